@@ -0,0 +1,233 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <objects.hpp>
+#include <composite.hpp>
+#include <ray.hpp>
+#include <sdf.hpp>
+#include "defines.h"
+
+/**
+ * Measures the time and the heap allocations of single calls to the ray and object kernels.
+ *
+ * usage: kernel_benchmark [milliseconds [filter]]
+ *
+ * Every kernel is called on the same fixed set of random rays and points for at least the given time (default 200),
+ * only kernels whose name contains filter are run.
+ */
+
+/** \brief Number of different rays and points every kernel is called with. */
+static const unsigned SAMPLE_COUNT = 4096;
+/** \brief Seed of the random rays and points, so every run measures the same work. */
+static const unsigned SAMPLE_SEED = 5489;
+
+/** \brief Number of calls to operator new since the start of the program. */
+static std::atomic<unsigned long> allocations(0);
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+/** \brief Keeps the results of the kernels alive, so they are not optimized away. */
+static volatile double sink = 0;
+
+/**
+ * \brief Random rays starting on a sphere of radius 5 around the origin and aiming at the unit cube.
+ */
+static std::vector<Ray> random_rays(std::mt19937& random) {
+  std::normal_distribution<double> normal(0, 1);
+  std::uniform_real_distribution<double> uniform(-1, 1);
+
+  std::vector<Ray> rays;
+  for (unsigned k = 0; k < SAMPLE_COUNT; k++) {
+    Eigen::Vector3d start = 5 * Eigen::Vector3d(normal(random), normal(random), normal(random)).normalized();
+    Eigen::Vector3d target(uniform(random), uniform(random), uniform(random));
+
+    rays.emplace_back(start, target - start, 1);
+  }
+
+  return rays;
+}
+
+/**
+ * \brief Random points in the cube [-2, 2]^3.
+ */
+static std::vector<Eigen::Vector4d> random_points(std::mt19937& random) {
+  std::uniform_real_distribution<double> uniform(-2, 2);
+
+  std::vector<Eigen::Vector4d> points;
+  for (unsigned k = 0; k < SAMPLE_COUNT; k++) {
+    points.emplace_back(uniform(random), uniform(random), uniform(random), 1);
+  }
+
+  return points;
+}
+
+/**
+ * \brief A complete tree of the combination Node with the given depth and fan-out over slightly moved unit spheres.
+ *
+ * The spheres overlap, so intersections, subtractions and exclusions of them are not empty.
+ */
+template<class Node>
+static BaseObject* combination_tree(Arena& arena, unsigned depth, unsigned fan_out, std::mt19937& random) {
+  if (depth == 0) {
+    std::uniform_real_distribution<double> offset(-0.3, 0.3);
+
+    return Transformation::Translation(arena, arena.create<Sphere>(ColData(), 1), offset(random), offset(random), offset(random));
+  }
+
+  std::vector<BaseObject*> children;
+  for (unsigned k = 0; k < fan_out; k++) {
+    children.push_back(combination_tree<Node>(arena, depth - 1, fan_out, random));
+  }
+
+  return arena.create<Node>(children);
+}
+
+/**
+ * \brief Calls kernel(k) for k = 0, 1, ... until at least milliseconds have passed and prints the time and allocations per call.
+ */
+static void measure(const std::string& name, const std::string& filter, unsigned milliseconds, const std::function<double(unsigned)>& kernel) {
+  if (name.find(filter) == std::string::npos) {
+    return;
+  }
+
+  // warm up the caches and the reused buffers
+  for (unsigned k = 0; k < SAMPLE_COUNT; k++) {
+    sink = sink + kernel(k);
+  }
+
+  unsigned long calls = 0;
+  unsigned long allocated = allocations.load();
+  auto start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+
+  while (elapsed * 1000 < milliseconds) {
+    double sum = 0;
+    for (unsigned k = 0; k < SAMPLE_COUNT; k++) {
+      sum += kernel(k);
+    }
+    sink = sink + sum;
+
+    calls += SAMPLE_COUNT;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  allocated = allocations.load() - allocated;
+
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(12) << elapsed * 1e9 / calls
+            << std::setprecision(3) << std::setw(14) << (double) allocated / calls << std::endl;
+}
+
+/**
+ * \brief Measures intersect() and included() of an object on the random rays and points.
+ */
+static void measure_object(const std::string& name, const std::string& filter, unsigned milliseconds, const BaseObject* object,
+                           const std::vector<Ray>& rays, const std::vector<Eigen::Vector4d>& points) {
+  const Eigen::Transform<double, 3, Eigen::Projective> identity = Eigen::Transform<double, 3, Eigen::Projective>::Identity();
+  std::vector<IntersectionPoint> dest;
+
+  measure(name + " intersect", filter, milliseconds, [&](unsigned k) {
+    dest.clear();
+    return object->intersect(rays[k], identity, dest) ? dest[0].distance : 0.0;
+  });
+
+  measure(name + " included", filter, milliseconds, [&](unsigned k) {
+    return object->included(points[k], identity) ? 1.0 : 0.0;
+  });
+}
+
+int main(int argc, char** argv) {
+  unsigned milliseconds = argc > 1 ? std::stoi(argv[1]) : 200;
+  std::string filter = argc > 2 ? argv[2] : "";
+
+  std::mt19937 random(SAMPLE_SEED);
+  std::vector<Ray> rays = random_rays(random);
+  std::vector<Eigen::Vector4d> points = random_points(random);
+
+  std::vector<Eigen::Transform<double, 3, Eigen::Projective>> transforms;
+  for (unsigned k = 0; k < SAMPLE_COUNT; k++) {
+    transforms.emplace_back(Eigen::Translation<double, 3>(points[k].head<3>()) * Eigen::AngleAxis<double>(k, rays[k].direction().head<3>().normalized()));
+  }
+
+  std::cout << std::left << std::setw(36) << "kernel" << std::right << std::setw(12) << "ns/op" << std::setw(14) << "allocs/op" << std::endl;
+
+  // ray kernels
+  measure("Ray::reflect", filter, milliseconds, [&](unsigned k) {
+    return rays[k].reflect(points[k], rays[(k + 1) % SAMPLE_COUNT].direction()).direction()[0];
+  });
+  measure("Ray::refract", filter, milliseconds, [&](unsigned k) {
+    return rays[k].refract(points[k], rays[(k + 1) % SAMPLE_COUNT].direction(), 1.5).direction()[0];
+  });
+  measure("Transform * Ray", filter, milliseconds, [&](unsigned k) {
+    return (transforms[k] * rays[k]).direction()[0];
+  });
+
+  // primitives
+  Arena arena;
+
+  SdfProgram program;
+  program.sphere(Eigen::Vector3d::Zero(), 1);
+  program.box(Eigen::Vector3d(0.5, 0, 0), Eigen::Vector3d(0.5, 0.5, 0.5));
+  program.combine(SdfOpcode::SMOOTH_UNION, 0.25);
+
+  std::vector<std::pair<std::string, const BaseObject*>> primitives = {
+    {"Sphere", arena.create<Sphere>(ColData(), 1)},
+    {"HalfSpace", arena.create<HalfSpace>(ColData(), 1, Eigen::Vector4d(0, 1, 1, 0))},
+    {"Cylinder", arena.create<Cylinder>(ColData(), 1)},
+    {"Quadric", Quadric::UnitCone(arena, ColData(), 1)},
+    {"DistanceField", arena.create<DistanceField>(ColData(), 1, program)},
+    {"ConvexPolyhedron", Composites::Cube(arena, ColData(), 1)->fold_transformations(arena)}
+  };
+
+  for (auto [name, object] : primitives) {
+    measure_object(name, filter, milliseconds, object, rays, points);
+  }
+
+  // object tree nodes
+  for (unsigned depth = 1; depth <= 8; depth *= 2) {
+    BaseObject* chain = arena.create<Sphere>(ColData(), 1);
+    for (unsigned d = 0; d < depth; d++) {
+      chain = Transformation::Rotation_Z(arena, chain, 0.1);
+    }
+
+    measure_object("Transformation d" + std::to_string(depth), filter, milliseconds, chain, rays, points);
+  }
+
+  for (unsigned depth = 1; depth <= 3; depth++) {
+    for (unsigned fan_out : {2, 4, 8}) {
+      std::string shape = " d" + std::to_string(depth) + " f" + std::to_string(fan_out);
+
+      measure_object("Union" + shape, filter, milliseconds, combination_tree<Union>(arena, depth, fan_out, random), rays, points);
+      measure_object("Intersection" + shape, filter, milliseconds, combination_tree<Intersection>(arena, depth, fan_out, random), rays, points);
+      measure_object("Subtraction" + shape, filter, milliseconds, combination_tree<Subtraction>(arena, depth, fan_out, random), rays, points);
+      measure_object("Exclusion" + shape, filter, milliseconds, combination_tree<Exclusion>(arena, depth, fan_out, random), rays, points);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+#include <scene.hpp>
+#include "defines.h"
+
+/**
+ * Renders whole scenes repeatedly and reports the throughput as JSON, optionally compared to a baseline.
+ *
+ * usage: render_benchmark [--resolution pixels] [--threads 1,4,...] [--scales 1,8,...] [--mode pixel|wavefront]
+ *                         [--orders scanline,morton,hilbert] [--tile pixels]
+ *                         [--warmup n] [--repetitions n] [--output result.json] [--timeline trace.json]
+ *                         [--baseline baseline.json [--tolerance fraction]] [scene.json ...]
+ *
+ * By default, the shipped examples are rendered 256 pixels wide in wavefront mode, on one thread and on all threads,
+ * once as they are and once with 8 copies of their objects. Every case is rendered once to warm up and 3 times measured.
+ * Run it from the build directory, like the main program.
+ *
+ * Every order of the pixels is a case of its own: scanline renders the image row by row as by default, morton and hilbert
+ * trace tiles of tile x tile pixels (default LIGHT_TILE_SIZE) one after another. Where the kernel provides hardware
+ * counters, the L1 data cache and last level cache misses per render are reported as well.
+ *
+ * With a timeline, the phases of loading and rendering all scenes are written as a Chrome trace, see Timeline.
+ * With a baseline, the exit code is 1 if any case rendered fewer rays per second than the baseline allows.
+ */
+
+/** \brief Seed of the offsets of the copied objects, so every run renders the same scenes. */
+static const unsigned SCALE_SEED = 5489;
+
+/**
+ * \class CacheMissCounter
+ *
+ * \brief Counts hardware cache events of the process while it is running, including threads started later.
+ *
+ * Counts nothing, if the kernel does not provide the counter, e.g. in virtual machines or with a restrictive perf_event_paranoid.
+ */
+class CacheMissCounter {
+public:
+  /**
+   * \brief Opens a stopped counter of the perf_event type and config.
+   */
+  CacheMissCounter(unsigned type, unsigned long config) {
+    #ifdef __linux__
+      perf_event_attr attributes;
+      std::memset(&attributes, 0, sizeof(attributes));
+      attributes.size = sizeof(attributes);
+      attributes.type = type;
+      attributes.config = config;
+      attributes.disabled = 1;
+      attributes.inherit = 1;
+      attributes.exclude_kernel = 1;
+      attributes.exclude_hv = 1;
+
+      fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    #endif
+  }
+
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+  ~CacheMissCounter() {
+    #ifdef __linux__
+      if (fd >= 0) {
+        close(fd);
+      }
+    #endif
+  }
+
+  /**
+   * \brief Sets the counter to 0 and starts it.
+   */
+  void start() {
+    #ifdef __linux__
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    #endif
+  }
+
+  /**
+   * \brief Stops the counter.
+   *
+   * \returns The events since start(), null if they could not be counted.
+   */
+  nlohmann::json stop() {
+    #ifdef __linux__
+      long long count = 0;
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) == sizeof(count)) {
+          return count;
+        }
+      }
+    #endif
+
+    return nullptr;
+  }
+
+private:
+  /** \brief File descriptor of the perf event, negative if it is not counted. */
+  int fd = -1;
+};
+
+/**
+ * \brief Splits a comma separated list of numbers.
+ */
+static std::vector<unsigned> number_list(const std::string& list) {
+  std::vector<unsigned> numbers;
+  std::istringstream stream(list);
+  std::string number;
+
+  while (std::getline(stream, number, ',')) {
+    numbers.push_back(std::stoi(number));
+  }
+
+  return numbers;
+}
+
+/**
+ * \brief Splits a comma separated list of names.
+ */
+static std::vector<std::string> name_list(const std::string& list) {
+  std::vector<std::string> names;
+  std::istringstream stream(list);
+  std::string name;
+
+  while (std::getline(stream, name, ',')) {
+    names.push_back(name);
+  }
+
+  return names;
+}
+
+/**
+ * \brief The scene description data, rendered resolution pixels wide, with scale copies of its objects.
+ *
+ * The copies are moved by small random offsets, so they overlap the original objects and stay in view.
+ */
+static nlohmann::json scaled_scene(nlohmann::json data, unsigned resolution, unsigned scale) {
+  double width = data["screen"]["dimensions"][1];
+  data["screen"]["dpi"] = resolution / width;
+
+  if (scale > 1) {
+    std::mt19937 random(SCALE_SEED);
+    std::uniform_real_distribution<double> offset(-0.5, 0.5);
+
+    nlohmann::json copies = nlohmann::json::array();
+    for (unsigned c = 0; c < scale; c++) {
+      copies.push_back({{"translation", {
+        {"factors", {offset(random), offset(random), offset(random)}},
+        {"subject", {{"union", data["objects"]}}}
+      }}});
+    }
+    data["objects"] = copies;
+  }
+
+  return data;
+}
+
+/**
+ * \brief Seconds needed to render scene with options, without printing the progress bar.
+ */
+static double render_time(Scene& scene, const RenderOptions& options) {
+  std::ostringstream sink;
+  std::streambuf* console = std::cout.rdbuf(sink.rdbuf());
+
+  auto start = std::chrono::steady_clock::now();
+  scene.generate(options);
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout.rdbuf(console);
+
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+  unsigned resolution = 256;
+  std::vector<unsigned> thread_counts = {1, 0};
+  std::vector<unsigned> scales = {1, 8};
+  RenderMode mode = RenderMode::WAVEFRONT;
+  std::vector<std::string> orders = {"scanline"};
+  unsigned tile_size = LIGHT_TILE_SIZE;
+  unsigned warmup = 1;
+  unsigned repetitions = 3;
+  std::string output_path;
+  std::string baseline_path;
+  std::string timeline_path;
+  double tolerance = 0.1;
+  std::vector<std::string> paths;
+
+  for (int k = 1; k < argc; k++) {
+    std::string arg = argv[k];
+
+    if (arg.rfind("--", 0) != 0) {
+      paths.push_back(arg);
+      continue;
+    }
+    if (k + 1 >= argc) {
+      std::cerr << "The option " << arg << " needs a value." << std::endl;
+      return 2;
+    }
+
+    std::string value = argv[++k];
+    if (arg == "--resolution") resolution = std::stoi(value);
+    else if (arg == "--threads") thread_counts = number_list(value);
+    else if (arg == "--scales") scales = number_list(value);
+    else if (arg == "--mode") mode = value == "pixel" ? RenderMode::PIXEL : RenderMode::WAVEFRONT;
+    else if (arg == "--orders") orders = name_list(value);
+    else if (arg == "--tile") tile_size = std::stoi(value);
+    else if (arg == "--warmup") warmup = std::stoi(value);
+    else if (arg == "--repetitions") repetitions = std::max(1, std::stoi(value));
+    else if (arg == "--output") output_path = value;
+    else if (arg == "--baseline") baseline_path = value;
+    else if (arg == "--timeline") timeline_path = value;
+    else if (arg == "--tolerance") tolerance = std::stod(value);
+    else {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 2;
+    }
+  }
+
+  if (paths.empty()) {
+    for (unsigned k = 1; k <= NUM_EXAMPLES; k++) {
+      paths.push_back("../examples/example" + std::to_string(k) + ".json");
+    }
+  }
+  for (const std::string& order : orders) {
+    if (order != "scanline" and order != "morton" and order != "hilbert") {
+      std::cerr << "Unknown pixel order " << order << "." << std::endl;
+      return 2;
+    }
+  }
+  // pixel mode always runs on a single thread
+  if (mode == RenderMode::PIXEL) {
+    thread_counts = {1};
+  }
+
+  if (not timeline_path.empty()) {
+    Timeline::start();
+  }
+
+  // misses of the L1 data cache on reads, and of the last level cache
+  #ifdef __linux__
+    CacheMissCounter l1_misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    CacheMissCounter cache_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  #else
+    CacheMissCounter l1_misses(0, 0);
+    CacheMissCounter cache_misses(0, 0);
+  #endif
+
+  nlohmann::json results = nlohmann::json::array();
+
+  for (const std::string& path : paths) {
+    std::ifstream input(path);
+    if (not input.is_open()) {
+      std::cerr << "The scene " << path << " could not be found." << std::endl;
+      return 2;
+    }
+    nlohmann::json data = nlohmann::json::parse(input);
+
+    for (unsigned scale : scales) {
+      std::istringstream description(scaled_scene(data, resolution, scale).dump());
+      Scene scene = Scene::read_parameters(description);
+
+      for (unsigned threads : thread_counts) {
+        for (const std::string& order : orders) {
+          RenderOptions options = scene.options();
+          options.mode = mode;
+          options.threads = threads;
+          options.pixel_order = order == "morton" ? PixelOrder::MORTON : order == "hilbert" ? PixelOrder::HILBERT : PixelOrder::SCANLINE;
+          options.tile_size = options.pixel_order == PixelOrder::SCANLINE ? 0 : tile_size;
+
+          // the names of scanline cases stay the same, so older baselines still apply
+          std::string name = path + " x" + std::to_string(scale) + " t" + std::to_string(options.thread_count());
+          if (options.pixel_order != PixelOrder::SCANLINE) {
+            name += " " + order + std::to_string(tile_size);
+          }
+          std::cerr << "rendering " << name << std::endl;
+
+          for (unsigned w = 0; w < warmup; w++) {
+            render_time(scene, options);
+          }
+
+          l1_misses.start();
+          cache_misses.start();
+          std::vector<double> times;
+          for (unsigned r = 0; r < repetitions; r++) {
+            times.push_back(render_time(scene, options));
+          }
+          nlohmann::json l1_count = l1_misses.stop();
+          nlohmann::json cache_count = cache_misses.stop();
+          std::sort(times.begin(), times.end());
+          double median = times[times.size() / 2];
+
+          // every repetition traces the same rays, so the counts of the last one hold for all of them
+          unsigned long primary = scene.primary_rays();
+          unsigned long shadow = scene.occluders().shadow_rays;
+          unsigned long secondary = scene.pruning().traced_rays;
+
+          results.push_back({
+            {"name", name},
+            {"scene", path},
+            {"scale", scale},
+            {"threads", options.thread_count()},
+            {"mode", mode == RenderMode::PIXEL ? "pixel" : "wavefront"},
+            {"order", options.pixel_order == PixelOrder::SCANLINE ? "scanline" : order},
+            {"tile", options.tile_size},
+            {"wall_time", median},
+            {"wall_time_min", times.front()},
+            {"primary_rays", primary},
+            {"shadow_rays", shadow},
+            {"secondary_rays", secondary},
+            {"rays_per_second", {
+              {"primary", primary / median},
+              {"shadow", shadow / median},
+              {"secondary", secondary / median},
+              {"total", (primary + shadow + secondary) / median}
+            }},
+            {"peak_rss_kb", RenderStats::peak_memory()},
+            {"cache_misses", {
+              {"l1d", l1_count.is_null() ? l1_count : nlohmann::json(l1_count.get<double>() / repetitions)},
+              {"last_level", cache_count.is_null() ? cache_count : nlohmann::json(cache_count.get<double>() / repetitions)}
+            }},
+            {"statistics", scene.statistics().json()}
+          });
+        }
+      }
+    }
+  }
+
+  nlohmann::json report = {
+    {"resolution", resolution},
+    {"warmup", warmup},
+    {"repetitions", repetitions},
+    {"results", results}
+  };
+
+  if (output_path.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  }
+  else {
+    std::ofstream(output_path) << report.dump(2) << std::endl;
+  }
+
+  if (not timeline_path.empty()) {
+    Timeline::stop();
+    std::ofstream timeline(timeline_path);
+    Timeline::write(timeline);
+  }
+
+  if (baseline_path.empty()) {
+    return 0;
+  }
+
+  std::ifstream baseline_input(baseline_path);
+  if (not baseline_input.is_open()) {
+    std::cerr << "The baseline " << baseline_path << " could not be found." << std::endl;
+    return 2;
+  }
+  nlohmann::json baseline = nlohmann::json::parse(baseline_input);
+
+  unsigned regressions = 0;
+  for (const nlohmann::json& result : results) {
+    for (const nlohmann::json& reference : baseline.at("results")) {
+      if (reference.at("name") != result.at("name")) {
+        continue;
+      }
+
+      double now = result["rays_per_second"]["total"];
+      double before = reference.at("rays_per_second").at("total");
+      if (now < (1 - tolerance) * before) {
+        std::cerr << "regression: " << result["name"].get<std::string>() << " traces " << now << " rays/s, the baseline " << before << " rays/s" << std::endl;
+        regressions++;
+      }
+    }
+  }
+
+  std::cerr << regressions << " regression(s) beyond a tolerance of " << tolerance * 100 << "%" << std::endl;
+
+  return regressions > 0 ? 1 : 0;
+}
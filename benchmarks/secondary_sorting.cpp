@@ -0,0 +1,86 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+#include <scene.hpp>
+#include "defines.h"
+
+/**
+ * Renders scenes in wavefront mode with and without sorting the secondary rays and compares the times.
+ *
+ * usage: secondary_sorting_benchmark [recursion [threads [scene.json ...]]]
+ *
+ * By default, the shipped examples are rendered with a recursion depth of 8 on all threads.
+ * Run it from the build directory, like the main program.
+ */
+
+/**
+ * \brief Seconds needed to render scene with options, without printing the progress bar.
+ */
+static double render_time(Scene& scene, const RenderOptions& options) {
+  std::ostringstream sink;
+  std::streambuf* console = std::cout.rdbuf(sink.rdbuf());
+
+  auto start = std::chrono::steady_clock::now();
+  scene.generate(options);
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout.rdbuf(console);
+
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+  unsigned recursion = argc > 1 ? std::stoi(argv[1]) : 8;
+  unsigned threads = argc > 2 ? std::stoi(argv[2]) : 0;
+
+  std::vector<std::string> paths;
+  for (int k = 3; k < argc; k++) {
+    paths.push_back(argv[k]);
+  }
+  if (paths.empty()) {
+    for (unsigned k = 1; k <= NUM_EXAMPLES; k++) {
+      paths.push_back("../examples/example" + std::to_string(k) + ".json");
+    }
+  }
+
+  std::cout << "recursion " << recursion << "\n\n"
+            << std::left << std::setw(32) << "scene" << std::right
+            << std::setw(16) << "secondary rays" << std::setw(12) << "unsorted" << std::setw(12) << "sorted" << std::setw(10) << "speedup" << std::endl;
+
+  for (const std::string& path : paths) {
+    std::ifstream input(path);
+    if (not input.is_open()) {
+      std::cout << "The scene " << path << " could not be found." << std::endl;
+      return 1;
+    }
+
+    nlohmann::json data = nlohmann::json::parse(input);
+    data["medium"]["recursion"] = recursion;
+
+    std::istringstream description(data.dump());
+    Scene scene = Scene::read_parameters(description);
+
+    RenderOptions options;
+    options.mode = RenderMode::WAVEFRONT;
+    options.threads = threads;
+
+    options.sort_secondary = false;
+    double unsorted = render_time(scene, options);
+
+    options.sort_secondary = true;
+    double sorted = render_time(scene, options);
+
+    std::cout << std::left << std::setw(32) << path << std::right << std::fixed << std::setprecision(3)
+              << std::setw(16) << scene.pruning().traced_rays
+              << std::setw(11) << unsorted << "s" << std::setw(11) << sorted << "s"
+              << std::setw(9) << unsorted / sorted << "x" << std::endl;
+  }
+
+  return 0;
+}
@@ -9,4 +9,47 @@
 
 #define NUM_EXAMPLES 4
 
-#define BAR_WIDTH 70
\ No newline at end of file
+#define BAR_WIDTH 70
+
+#define SDF_STACK_SIZE 32
+#define SDF_MAX_ITERATIONS 256
+#define SDF_HIT_EPSILON 0.0001
+
+#define ARENA_BLOCK_SIZE 65536
+
+#define CONTRIBUTION_THRESHOLD 0.001
+#define ROULETTE_SEED 5489
+
+#define TRACE_STACK_SIZE 64
+#define MEDIUM_DEPTH 8
+
+#define WAVEFRONT_BATCH_SIZE 16384
+#define PARALLEL_MIN_CHUNK 256
+#define COHERENCE_BIN_BITS 12
+#define LIGHT_SEED 48271
+#define LIGHT_TILE_SIZE 16
+#define AREA_LIGHT_STRATA 2
+#define AREA_LIGHT_MAX_STRATA 4
+
+#define AA_CONTRAST_THRESHOLD 0.1
+#define AA_SEED 16807
+
+#define GENERATOR_SEED 1234
+
+#define PROGRESSIVE_STEP 8
+#define PROGRESSIVE_CHUNK 4096
+
+#define COST_MAP_PERCENTILE 0.99
+
+#define ESTIMATE_FRACTION 0.01
+#define ESTIMATE_MIN_STRATA 64
+#define ESTIMATE_SEED 69621
+#define ESTIMATE_CONFIDENCE 0.95
+#define ESTIMATE_Z 1.96
+
+#define REGRESSION_PIXEL_ERROR 8
+#define REGRESSION_CHANGED_PIXELS 0.001
+#define REGRESSION_MIN_PSNR 40
+#define REGRESSION_MIN_SSIM 0.99
+#define REGRESSION_DIFF_GAIN 8
+#define SSIM_WINDOW 8
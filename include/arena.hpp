@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <memory_resource>
+
+#include <custom_exceptions.hpp>
+#include "defines.h"
+
+/**
+ * \class Arena arena.hpp
+ * 
+ * \brief Bump allocator owning all objects of a Scene.
+ * 
+ * Memory is handed out from large blocks of ARENA_BLOCK_SIZE bytes by advancing a pointer.
+ * Nothing is ever freed individually, so objects allocated together lie next to each other in memory.
+ * All blocks are freed at once when the Arena is destructed, without running any destructors.
+ * 
+ * The Arena is a std::pmr::memory_resource, so containers inside of objects (e.g. the elements of a Combination)
+ * can be placed into it as well. Objects constructed by create() receive the Arena as allocator,
+ * if they define an allocator_type.
+ * 
+ * An Arena can not be copied or moved, as allocated containers keep a pointer to it.
+ */
+class Arena: public std::pmr::memory_resource {
+private:
+  /**
+   * \brief Header at the start of every allocated block.
+   */
+  struct Block {
+    /** \brief Previously allocated block. */
+    Block* next;
+  };
+
+  /** \brief Most recently allocated block. */
+  Block* blocks;
+  /** \brief Next free byte in the current block. */
+  char* cursor;
+  /** \brief End of the current block. */
+  char* end;
+
+  /** \brief Size of a regular block. Larger requests get a block of their own. */
+  std::size_t block_size;
+  /** \brief Number of bytes handed out so far. */
+  std::size_t used_bytes;
+  /** \brief Number of allocated blocks. */
+  unsigned num_blocks;
+
+  /**
+   * \brief Allocates a new block with at least size usable bytes.
+   * 
+   * \returns Pointer to the first usable byte of the block.
+   */
+  char* new_block(std::size_t size);
+
+protected:
+  virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  /**
+   * \brief Does nothing, memory is only freed together with the Arena.
+   */
+  virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+  /**
+   * \brief Base Constructor for Arena.
+   * 
+   * No memory is allocated until the first request.
+   */
+  Arena(std::size_t block_size = ARENA_BLOCK_SIZE);
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * \brief Frees every block at once.
+   */
+  ~Arena();
+
+  /**
+   * \brief Constructs an object inside of the Arena.
+   * 
+   * Uses-allocator construction is applied, i.e. if T defines an allocator_type, the Arena is passed as
+   * last argument to the constructor.
+   * 
+   * \param args arguments to the constructor of T
+   * 
+   * \returns Pointer to the constructed object. It must not be deleted.
+   */
+  template<typename T, typename... Args>
+  T* create(Args&&... args) {
+    std::pmr::polymorphic_allocator<T> allocator(this);
+
+    T* object = allocator.allocate(1);
+    allocator.construct(object, std::forward<Args>(args)...);
+
+    return object;
+  }
+
+  /**
+   * \brief Number of bytes handed out so far, including padding for alignment.
+   */
+  std::size_t used() const;
+  /**
+   * \brief Number of blocks allocated from the system.
+   */
+  unsigned block_count() const;
+};
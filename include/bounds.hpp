@@ -0,0 +1,103 @@
+#pragma once
+
+#include <iostream>
+#include <limits>
+#include <Dense>
+
+#include <ray.hpp>
+#include <custom_exceptions.hpp>
+#include "defines.h"
+
+/**
+ * \class BoundingBox bounds.hpp
+ *
+ * \brief An axis-aligned bounding box.
+ *
+ * Boundaries may be infinite, e.g. for a Cylinder or a HalfSpace.
+ * A box where any minimum is larger than the corresponding maximum is empty.
+ */
+class BoundingBox {
+private:
+  /** \brief Lower corner of the box. */
+  Eigen::Vector3d min_corner;
+  /** \brief Upper corner of the box. */
+  Eigen::Vector3d max_corner;
+
+public:
+  /**
+   * \brief Base Constructor for BoundingBox.
+   */
+  BoundingBox(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner);
+  /**
+   * \brief Default Constructor for BoundingBox.
+   *
+   * Constructs an empty box.
+   */
+  BoundingBox();
+
+  /** \brief Constructs a box covering the whole space. */
+  static BoundingBox infinite();
+
+  /**
+   * \brief Getter function for the lower corner.
+   */
+  const Eigen::Vector3d& min() const;
+  /**
+   * \brief Getter function for the upper corner.
+   */
+  const Eigen::Vector3d& max() const;
+
+  /**
+   * \brief Checks if the box contains no point.
+   */
+  bool empty() const;
+  /**
+   * \brief Checks if every boundary of the (non-empty) box is finite.
+   */
+  bool finite() const;
+  /**
+   * \brief Volume of the box.
+   *
+   * \returns 0 for empty boxes and infinity for unbounded boxes.
+   */
+  double volume() const;
+
+  /**
+   * \brief Smallest box containing both *this and other.
+   */
+  BoundingBox merged(const BoundingBox& other) const;
+  /**
+   * \brief Box containing all points lying in both *this and other.
+   */
+  BoundingBox intersected(const BoundingBox& other) const;
+
+  /**
+   * \brief Smallest axis-aligned box containing the image of *this under an affine transformation.
+   *
+   * The image is computed with interval arithmetic per row of the matrix, so unbounded boxes
+   * stay as tight as possible (e.g. a translated HalfSpace).
+   *
+   * \param transformation affine matrix in homogenous coordinates
+   */
+  BoundingBox transformed(const Eigen::Transform<double, 3, Eigen::Projective>& transformation) const;
+
+  /**
+   * \brief Clips a Ray against the box (slab test).
+   *
+   * \param r Ray to clip. Its direction has to be normalized.
+   * \param t_near Is set to the distance at which r enters the box.
+   * \param t_far Is set to the distance at which r leaves the box.
+   *
+   * \returns True, if r hits the box at any positive distance.
+   */
+  bool clip(const Ray& r, double& t_near, double& t_far) const;
+  /**
+   * \brief Squared distance of a point to the (non-empty) box, 0 if the point lies inside.
+   */
+  double squared_distance(const Eigen::Vector3d& p) const;
+
+  /**
+   * \brief Formats the corners of the box into an output stream.
+   */
+  friend std::ostream& operator<<(std::ostream& out, const BoundingBox& box);
+};
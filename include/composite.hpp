@@ -10,9 +10,8 @@
  * \brief Helper class to construct composite objects.
  * 
  * You can use the static methods to construct composite objects.
- * The individual BaseObjects will be dynamical allocated and accordingly connected.
- * The returned BaseObject will act as a root of the composite and deleting it,
- * will free all allocated memory.
+ * The individual BaseObjects will be allocated in the given Arena and accordingly connected.
+ * The returned BaseObject will act as a root of the composite.
  */
 class Composites {
 public:
@@ -21,12 +20,13 @@ public:
    * 
    * The axis-aligned cube is centered at origin and has uniform side length of 1.
    * 
+   * \param arena Arena to allocate the objects in
    * \param col color informations to be used
    * \param index refractive index to be used
    * 
    * \returns Intersection of six planes making a cube.
    */
-  static BaseObject* Cube(ColData col, float index);
+  static BaseObject* Cube(Arena& arena, ColData col, float index);
 
   /**
    * \brief Constructs a right regular triangular prism with uniform color and index.
@@ -35,13 +35,14 @@ public:
    * i.e. the z-axis goes perpendicular through them.
    * The prism is centered at the origin and has uniform side length of 1.
    * 
+   * \param arena Arena to allocate the objects in
    * \param col color informations to be used
    * \param index refractive index to be used
    * 
    * \returns Intersection of five planes making a prism.
    * 
    */
-  static BaseObject* Prism(ColData col, float index);
+  static BaseObject* Prism(Arena& arena, ColData col, float index);
 
   /**
    * \brief Constructs a Triforce with uniform color and index.
@@ -53,11 +54,12 @@ public:
    * The Triforce is centered at origin and each prism has uniform
    * side length of 1.
    * 
+   * \param arena Arena to allocate the objects in
    * \param col color informations to be used
    * \param index refractive index to be used
    * 
    * \returns Union of three prisms making a Triforce.
    * 
    */
-  static BaseObject* Triforce(ColData col, float index);
+  static BaseObject* Triforce(Arena& arena, ColData col, float index);
 };
\ No newline at end of file
@@ -63,6 +63,48 @@ public:
   virtual const char* what() const noexcept override;
 };
 
+/**
+ * \class Cpp_Raytracing_INVALID_INPUT custom_exceptions.hpp
+ * 
+ * \brief Exception thrown for a scene description that is syntactically correct, but can not be used.
+ */
+class Cpp_Raytracing_INVALID_INPUT: public Cpp_Raytracing_Exception {
+private:
+  /**
+   * \brief Contains the C-String with infos about the error.
+   * 
+   * \sa what()
+   */
+  char* info;
+
+public:
+  /**
+   * \brief Constructor taking a description of the problem.
+   * 
+   * \param reason description of what is wrong with the input
+   */
+  Cpp_Raytracing_INVALID_INPUT(const char* reason);
+
+  /**
+   * \brief Copy Constructor, duplicating #info.
+   */
+  Cpp_Raytracing_INVALID_INPUT(const Cpp_Raytracing_INVALID_INPUT& other);
+
+  /**
+   * \brief Destructor to free allocated memory of #info.
+   * 
+   * \sa info
+   */
+  ~Cpp_Raytracing_INVALID_INPUT();
+
+  /**
+   * \brief Informations about encountered error.
+   * 
+   * \returns C-String describing the encountered error.
+   */
+  virtual const char* what() const noexcept override;
+};
+
 #ifdef ACTIVATE_CUSTOM_ASSERT
   /**
    * \brief Helper Macro to retrieve file and line of assertion.
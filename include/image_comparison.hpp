@@ -0,0 +1,83 @@
+#pragma once
+
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <json.hpp>
+
+#include "defines.h"
+
+/**
+ * \class ImageTolerance image_comparison.hpp
+ *
+ * \brief How far a render may drift from its reference image and still count as unchanged.
+ */
+struct ImageTolerance {
+  /** \brief Largest difference of a color channel, that does not count a pixel as changed. */
+  unsigned pixel_error = REGRESSION_PIXEL_ERROR;
+  /** \brief Largest fraction of changed pixels. */
+  double changed_pixels = REGRESSION_CHANGED_PIXELS;
+  /** \brief Smallest peak signal-to-noise ratio in decibels. */
+  double psnr = REGRESSION_MIN_PSNR;
+  /** \brief Smallest structural similarity. */
+  double ssim = REGRESSION_MIN_SSIM;
+};
+
+/**
+ * \class ImageComparison image_comparison.hpp
+ *
+ * \brief Differences between a render and its reference image.
+ *
+ * The structural similarity is the mean SSIM of all color channels over windows of SSIM_WINDOW x SSIM_WINDOW pixels,
+ * which overlap by half their size.
+ */
+struct ImageComparison {
+  /** \brief Largest difference of a color channel over all pixels. */
+  unsigned max_error = 0;
+  /** \brief Mean absolute difference of all color channels of all pixels. */
+  double mean_error = 0;
+  /** \brief Fraction of the pixels, that differ by more than ImageTolerance::pixel_error in any color channel. */
+  double changed_pixels = 0;
+  /** \brief Peak signal-to-noise ratio in decibels, infinite for equal images. */
+  double psnr = 0;
+  /** \brief Structural similarity, 1 for equal images. */
+  double ssim = 0;
+
+  /**
+   * \brief Compares image to reference.
+   *
+   * \param image the render to check
+   * \param reference the expected image
+   * \param pixel_error largest difference of a color channel, that does not count a pixel as changed
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if the images differ in size or are empty
+   */
+  static ImageComparison compare(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference, unsigned pixel_error = REGRESSION_PIXEL_ERROR);
+  /**
+   * \brief Absolute difference of image and reference, amplified by REGRESSION_DIFF_GAIN so small deviations are visible.
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if the images differ in size
+   */
+  static cv::Mat_<cv::Vec3b> difference(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference);
+
+  /**
+   * \brief Whether the differences are within tolerance.
+   *
+   * changed_pixels is only comparable, if it was computed with tolerance.pixel_error.
+   */
+  bool within(const ImageTolerance& tolerance) const;
+
+  /**
+   * \brief The comparison as a JSON object, an infinite psnr is written as null.
+   */
+  nlohmann::json json() const;
+
+  /**
+   * \brief Formats the comparison into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param comparison ImageComparison to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const ImageComparison& comparison);
+};
@@ -2,8 +2,11 @@
 
 #include <iostream>
 #include <array>
+#include <limits>
 #include <Dense>
 
+#include <arena.hpp>
+#include <bounds.hpp>
 #include <custom_exceptions.hpp>
 #include "defines.h"
 
@@ -125,6 +128,10 @@ public:
    * \param k color channel to get
   */
   const float& at(unsigned k) const;
+  /**
+   * \brief Largest value of all color channels.
+   */
+  float maximum() const;
 
   /**
    * \brief Inplace addition of two LightIntensity objects.
@@ -273,10 +280,25 @@ struct ColData {
   ColData();
 };
 
+/**
+ * \brief Shapes of the area emitting the light of a LightSource.
+ */
+enum class LightShape {
+  /** \brief The light is emitted from a single point, casting hard shadows. */
+  POINT,
+  /** \brief The light is emitted from a sphere around the position. */
+  SPHERE,
+  /** \brief The light is emitted from a parallelogram centered at the position. */
+  RECTANGLE
+};
+
 /**
  * \class LightSource light.hpp
  * 
  * \brief A light source which is localized in space.
+ * 
+ * By default, the light is emitted from a single point. Area lights, constructed by Sphere() and Rectangle(),
+ * emit the same light spread over their area and cast soft shadows.
  */
 class LightSource {
 private:
@@ -286,11 +308,23 @@ private:
   /** \brief Color of the light source. */
   LightIntensity intensity;
 
+  /** \brief Distance, at which the light has faded out completely. Infinite for lights without falloff. */
+  double range;
+
+  /** \brief Shape of the emitting area. */
+  LightShape area;
+  /** \brief Radius of a LightShape::SPHERE. */
+  double sphere_radius;
+  /** \brief Edges of a LightShape::RECTANGLE, spanning it around the position. */
+  Eigen::Vector3d edge_u, edge_v;
+
 public:
   /**
    * \brief Base Constructor for LightSource.
+   * 
+   * \param range distance, at which the light has faded out completely, has to be positive
    */
-  LightSource(const Eigen::Vector4d& position, const LightIntensity& intensity);
+  LightSource(const Eigen::Vector4d& position, const LightIntensity& intensity, double range = std::numeric_limits<double>::infinity());
 
   /**
    * \brief Constructor for LightSource using a 3-dimensional vector.
@@ -298,7 +332,30 @@ public:
    * Converts the position vector into a homogenous coordinate point vector 
    * (i.e. append a 1).
    */
-  LightSource(const Eigen::Vector3d& position, const LightIntensity& intensity);
+  LightSource(const Eigen::Vector3d& position, const LightIntensity& intensity, double range = std::numeric_limits<double>::infinity());
+
+  /**
+   * \brief Constructs a spherical area light.
+   * 
+   * \param arena Arena to allocate the LightSource in
+   * \param center center of the sphere
+   * \param radius radius of the sphere, has to be positive
+   * \param intensity color of the whole light
+   * \param range distance from the center, at which the light has faded out completely
+   */
+  static LightSource* Sphere(Arena& arena, const Eigen::Vector3d& center, double radius, const LightIntensity& intensity, double range = std::numeric_limits<double>::infinity());
+  /**
+   * \brief Constructs a rectangular area light.
+   * 
+   * \param arena Arena to allocate the LightSource in
+   * \param center center of the rectangle
+   * \param edge_u first edge of the rectangle
+   * \param edge_v second edge of the rectangle, must not be parallel to edge_u
+   * \param intensity color of the whole light
+   * \param range distance from the emitting point, at which the light has faded out completely
+   */
+  static LightSource* Rectangle(Arena& arena, const Eigen::Vector3d& center, const Eigen::Vector3d& edge_u, const Eigen::Vector3d& edge_v,
+                                const LightIntensity& intensity, double range = std::numeric_limits<double>::infinity());
 
   /**
    * \brief Default Constructor for LightSource.
@@ -322,4 +379,49 @@ public:
    * \brief Getter function to retrieve the position.
    */
   const Eigen::Vector4d& pos() const;
+
+  /**
+   * \brief Getter function to retrieve the shape of the emitting area.
+   */
+  LightShape shape() const;
+
+  /**
+   * \brief Largest distance of an emitting point from the position, 0 for point lights.
+   */
+  double extent() const;
+
+  /**
+   * \brief Point of the emitting area, parametrized by the unit square.
+   * 
+   * Spheres are sampled on the disc facing shaded, which covers the sphere as seen from there.
+   * Point lights always return their position.
+   * 
+   * \param shaded the point, that is lit by the sampled point
+   * \param s first coordinate in [0, 1)
+   * \param t second coordinate in [0, 1)
+   */
+  Eigen::Vector4d sample_point(const Eigen::Vector4d& shaded, double s, double t) const;
+
+  /**
+   * \brief Getter function to retrieve the distance, at which the light has faded out completely.
+   */
+  double radius() const;
+
+  /**
+   * \brief Checks if the light has a finite #range.
+   */
+  bool ranged() const;
+
+  /**
+   * \brief Factor, by which the light is dimmed at a distance from the light source.
+   * 
+   * Falls off smoothly as \f$(1 - (d / r)^2)^2\f$ from 1 at the light source to 0 at #range,
+   * lights without falloff are never dimmed.
+   */
+  float attenuation(double distance) const;
+
+  /**
+   * \brief Checks if the light of any emitting point can reach any point of box.
+   */
+  bool reaches(const BoundingBox& box) const;
 };
\ No newline at end of file
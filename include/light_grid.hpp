@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include <bounds.hpp>
+#include <light.hpp>
+#include "defines.h"
+
+/**
+ * \class LightGrid light_grid.hpp
+ *
+ * \brief Lists of the LightSources, that can reach the geometry seen through each tile of the screen.
+ *
+ * The screen is divided into square tiles of LIGHT_TILE_SIZE pixels. For every tile, cull() keeps only the
+ * LightSources, whose sphere of influence reaches the bounds of the points hit by its primary rays,
+ * so shading these points only has to loop over the lights of their tile.
+ * Without any tiles, i.e. if no LightSource has a finite range, every tile sees all lights.
+ */
+class LightGrid {
+private:
+  /** \brief Number of tiles along the rows of the screen. */
+  unsigned columns;
+  /** \brief Indices of the LightSources reaching every tile, row by row. */
+  std::vector<std::vector<unsigned>> lists;
+  /** \brief Indices of all LightSources. */
+  std::vector<unsigned> everything;
+
+public:
+  /**
+   * \brief Constructs a grid without tiles, where every tile sees all of sources lights.
+   */
+  LightGrid(unsigned sources);
+  /**
+   * \brief Constructs a grid of tiles covering a screen of rows x columns pixels, where every tile sees all of sources lights.
+   */
+  LightGrid(unsigned sources, unsigned rows, unsigned columns);
+  /**
+   * \brief Default Constructor for LightGrid, without any lights.
+   */
+  LightGrid();
+
+  /**
+   * \brief Number of tiles.
+   */
+  unsigned size() const;
+  /**
+   * \brief Index of the tile containing pixel (i, j), 0 if there are no tiles.
+   */
+  unsigned tile(unsigned i, unsigned j) const;
+
+  /**
+   * \brief Restricts the lights of a tile to those reaching geometry.
+   *
+   * \param tile index of the tile
+   * \param geometry bounds of all points seen through the tile
+   * \param sources all LightSources of the scene
+   */
+  void cull(unsigned tile, const BoundingBox& geometry, const std::vector<LightSource*>& sources);
+
+  /**
+   * \brief Indices of the LightSources reaching a tile.
+   */
+  const std::vector<unsigned>& lights(unsigned tile) const;
+  /**
+   * \brief Indices of all LightSources.
+   */
+  const std::vector<unsigned>& all() const;
+};
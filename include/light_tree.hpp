@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <Dense>
+
+#include <bounds.hpp>
+#include <light.hpp>
+#include <trace.hpp>
+#include "defines.h"
+
+/**
+ * \class LightChoice light_tree.hpp
+ *
+ * \brief A LightSource chosen to shade a hit point.
+ */
+struct LightChoice {
+  /** \brief Index of the chosen LightSource. */
+  unsigned source;
+  /** \brief Factor, by which the light of the chosen source is amplified, i.e. the inverse of its probability and the number of choices. */
+  float weight;
+};
+
+/**
+ * \class LightSum light_tree.hpp
+ *
+ * \brief Adds up the light of several LightSources at a hit point, some of them amplified by their LightChoice::weight.
+ *
+ * The screen blend of LightIntensity::operator+= saturates, so amplifying a few chosen lights by their weight
+ * would not give the expected sum of all lights. Instead, weighted lights are added up in the domain
+ * \f$-\log(1 - l)\f$, where the screen blend is a simple sum, and blended into the value by finish().
+ * Lights with weight 1 are blended in directly, exactly as by LightIntensity::operator+=.
+ */
+class LightSum {
+private:
+  /** \brief Sum of \f$-w\log(1 - l)\f$ of all weighted lights, per color channel. */
+  std::array<double, NUM_COL> density;
+
+  /**
+   * \brief Adds a single weighted LightIntensity.
+   */
+  void add(LightIntensity& value, const LightIntensity& light, float weight);
+
+public:
+  /**
+   * \brief Constructs an empty sum.
+   */
+  LightSum();
+
+  /**
+   * \brief Adds the diffuse and specular light of sample.
+   *
+   * \param value the LightIntensity at the hit point, lights with weight 1 are blended in immediately
+   * \param sample the light reflected by a LightSource
+   * \param weight weight of the LightSource
+   */
+  void add(LightIntensity& value, const LightSample& sample, float weight);
+  /**
+   * \brief Blends all weighted lights into value.
+   */
+  void finish(LightIntensity& value) const;
+};
+
+/**
+ * \class LightTree light_tree.hpp
+ *
+ * \brief Bounding volume hierarchy over the LightSources of a Scene, to choose the important ones for a point.
+ *
+ * Every node stores the bounds of its light positions and their total power, i.e. the sum of all color channels.
+ * The tree is built top-down by splitting the lights at the median of the longest axis of their bounds.
+ *
+ * The importance of a node for a point is its power divided by the squared distance of the point to its bounds
+ * (but at least to half of the diagonal of its bounds). Nodes, whose lights can not reach the point due to their range, are not important at all.
+ * sample() descends from the root, choosing a child with a probability proportional to its importance,
+ * so every LightSource can be chosen and near, bright lights are chosen most often.
+ */
+class LightTree {
+private:
+  /**
+   * \brief A node of the tree, either with two children or with a single LightSource.
+   */
+  struct Node {
+    /** \brief Bounds of all light positions below the node. */
+    BoundingBox box;
+    /** \brief Bounds of the spheres, in which the lights below the node have not faded out yet. */
+    BoundingBox influence;
+    /** \brief Total power of all lights below the node. */
+    double power;
+    /** \brief Index of the parent node, the root is its own parent. */
+    unsigned parent;
+    /** \brief Index of the first child, 0 for leaves. The second child follows directly after the subtree of the first. */
+    unsigned left;
+    /** \brief Index of the second child, 0 for leaves. */
+    unsigned right;
+    /** \brief Index of the LightSource of a leaf. */
+    unsigned source;
+  };
+
+  /** \brief Nodes of the tree in depth-first order, the root comes first. */
+  std::vector<Node> nodes;
+  /** \brief Index of the leaf of every LightSource. */
+  std::vector<unsigned> leaves;
+
+  /**
+   * \brief Recursively builds the subtree over the lights in order[begin:end].
+   *
+   * \returns Index of the root of the subtree.
+   */
+  unsigned build(const std::vector<LightSource*>& sources, std::vector<unsigned>& order, unsigned begin, unsigned end, unsigned parent);
+  /**
+   * \brief Importance of a node for a point.
+   */
+  double importance(const Node& node, const Eigen::Vector3d& point) const;
+  /**
+   * \brief Probability to descend from the parent of a node into the node.
+   */
+  double branch_probability(unsigned node, const Eigen::Vector3d& point) const;
+
+public:
+  /**
+   * \brief Builds the tree over sources.
+   */
+  LightTree(const std::vector<LightSource*>& sources);
+  /**
+   * \brief Default Constructor for LightTree, without any lights.
+   */
+  LightTree();
+
+  /**
+   * \brief Number of LightSources in the tree.
+   */
+  unsigned size() const;
+
+  /**
+   * \brief Chooses a LightSource for point.
+   *
+   * The tree must not be empty.
+   *
+   * \param point point to be shaded
+   * \param u uniformly distributed random number in [0, 1)
+   * \param probability is set to the probability of choosing the returned LightSource
+   *
+   * \returns Index of the chosen LightSource.
+   */
+  unsigned sample(const Eigen::Vector3d& point, double u, double& probability) const;
+  /**
+   * \brief Probability, that sample() chooses a LightSource for point.
+   */
+  double probability(const Eigen::Vector3d& point, unsigned source) const;
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <json.hpp>
+
+class RootObject;
+
+/**
+ * \class NodeCounters node_profiler.hpp
+ *
+ * \brief Work done by a single node of the object tree.
+ *
+ * \sa NodeProfiler
+ */
+struct NodeCounters {
+  /** \brief Number of calls to BaseObject::intersect(). */
+  unsigned long intersect_calls = 0;
+  /** \brief Number of calls to BaseObject::included(). */
+  unsigned long included_calls = 0;
+  /** \brief Number of IntersectionPoints returned by all calls to BaseObject::intersect(). */
+  unsigned long points = 0;
+  /** \brief Seconds spent in both functions, including the nodes below. */
+  double seconds = 0;
+  /** \brief Seconds spent in both functions, excluding the nodes below. */
+  double self_seconds = 0;
+
+  /**
+   * \brief Adds the counters of other to this.
+   */
+  NodeCounters& operator+=(const NodeCounters& other);
+};
+
+/**
+ * \class NodeProfiler node_profiler.hpp
+ *
+ * \brief Counts the work of every node of the object tree, if compiled with PROFILE_NODES.
+ *
+ * Every BaseObject gets an id when it is constructed. Its intersect() and included() record their calls with a NodeScope
+ * into counters of the calling thread, so the threads do not synchronize while rendering.
+ * The counters of a thread are merged into a shared total, when the thread ends.
+ *
+ * Without PROFILE_NODES nothing is recorded and the object tree has no overhead.
+ */
+class NodeProfiler {
+public:
+  /**
+   * \brief Counters of a single thread.
+   */
+  struct ThreadCounters {
+    /** \brief Counters of every node, indexed by its id. */
+    std::vector<NodeCounters> nodes;
+    /** \brief Seconds spent in calls from outside of the object tree. */
+    double seconds = 0;
+    /** \brief Number of nested NodeScopes. */
+    unsigned depth = 0;
+    /** \brief Seconds spent in the nodes below the innermost NodeScope of each depth. */
+    std::vector<double> child_seconds;
+
+    /**
+     * \brief Merges the counters into the shared total.
+     */
+    ~ThreadCounters();
+  };
+
+private:
+  /** \brief Number of registered nodes. */
+  static std::atomic<unsigned> node_count;
+  /** \brief Guards #finished and #finished_seconds. */
+  static std::mutex mutex;
+  /** \brief Counters of all ended threads. */
+  static std::vector<NodeCounters> finished;
+  /** \brief Seconds spent in calls from outside of the object tree by all ended threads. */
+  static double finished_seconds;
+  /** \brief Counters of the calling thread. */
+  static thread_local ThreadCounters local;
+
+public:
+  /**
+   * \brief Unique id of a new node.
+   */
+  static unsigned register_node();
+  /**
+   * \brief Counters of the calling thread.
+   */
+  static ThreadCounters& counters() {
+    if (local.nodes.size() < node_count) {
+      local.nodes.resize(node_count);
+    }
+
+    return local;
+  }
+
+  /**
+   * \brief Counters of every node, summed over the calling thread and all ended threads.
+   */
+  static std::vector<NodeCounters> collect();
+  /**
+   * \brief Seconds spent in the object tree, summed over the calling thread and all ended threads.
+   */
+  static double total_seconds();
+  /**
+   * \brief Sets all counters of the calling thread and all ended threads to 0.
+   */
+  static void reset();
+
+  /**
+   * \brief The object tree annotated with the counters of every node.
+   *
+   * Every node is an object with its type, its counters, the share of its (self) seconds in total_seconds() and its children.
+   */
+  static nlohmann::json tree(const RootObject& root);
+  /**
+   * \brief Prints the n nodes with the most seconds, with their path in the object tree.
+   */
+  static void print_top(std::ostream& out, const RootObject& root, unsigned n);
+};
+
+/**
+ * \class NodeScope node_profiler.hpp
+ *
+ * \brief Records a single call to BaseObject::intersect() or BaseObject::included() of a node, from construction to destruction.
+ *
+ * \tparam Points vector of IntersectionPoints, whose growth is counted
+ */
+template <typename Points>
+class NodeScope {
+private:
+  /** \brief Id of the node. */
+  unsigned id;
+  /** \brief Destination of the intersect() call, nullptr for included(). */
+  const Points* dest;
+  /** \brief Size of #dest at the start of the call. */
+  std::size_t initial_points;
+  /** \brief Start of the call. */
+  std::chrono::steady_clock::time_point start;
+
+public:
+  /**
+   * \brief Starts recording a call.
+   */
+  NodeScope(unsigned id, const Points* dest): id(id), dest(dest), initial_points(dest != nullptr ? dest->size() : 0) {
+    NodeProfiler::ThreadCounters& counters = NodeProfiler::counters();
+    if (counters.child_seconds.size() <= counters.depth) {
+      counters.child_seconds.resize(counters.depth + 1);
+    }
+    counters.child_seconds[counters.depth] = 0;
+    counters.depth++;
+
+    start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * \brief Ends recording the call.
+   */
+  ~NodeScope() {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    NodeProfiler::ThreadCounters& counters = NodeProfiler::counters();
+    counters.depth--;
+
+    NodeCounters& node = counters.nodes[id];
+    node.seconds += seconds;
+    node.self_seconds += seconds - counters.child_seconds[counters.depth];
+    if (dest != nullptr) {
+      node.intersect_calls++;
+      node.points += dest->size() - initial_points;
+    }
+    else {
+      node.included_calls++;
+    }
+
+    if (counters.depth > 0) {
+      counters.child_seconds[counters.depth - 1] += seconds;
+    }
+    else {
+      counters.seconds += seconds;
+    }
+  }
+};
+
+#ifdef PROFILE_NODES
+  #define PROFILE_NODE_INTERSECT(dest) NodeScope<std::vector<IntersectionPoint>> node_scope(profile_id, &dest)
+  #define PROFILE_NODE_INCLUDED() NodeScope<std::vector<IntersectionPoint>> node_scope(profile_id, nullptr)
+#else
+  #define PROFILE_NODE_INTERSECT(dest)
+  #define PROFILE_NODE_INCLUDED()
+#endif
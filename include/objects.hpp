@@ -4,10 +4,16 @@
 #include <vector>
 #include <tuple>
 #include <array>
+#include <memory_resource>
 #include <Dense>
 
 #include <ray.hpp>
 #include <light.hpp>
+#include <arena.hpp>
+#include <bounds.hpp>
+#include <optimizer.hpp>
+#include <sdf.hpp>
+#include <node_profiler.hpp>
 #include <custom_exceptions.hpp>
 #include "defines.h"
 
@@ -79,9 +85,29 @@ const IntersectionPoint operator*(const Eigen::Transform<double, 3, Eigen::Proje
  * \class BaseObject objects.hpp
  * 
  * \brief Base class for all objects of a scene.
+ * 
+ * The objects of a scene are allocated in an Arena (see Arena::create()) and are never deleted individually,
+ * so no object owns the objects below it.
  */
 class BaseObject {
 public:
+  /**
+   * \brief Id of this node for the NodeProfiler, copies get their own id.
+   */
+  unsigned profile_id;
+
+  /**
+   * \brief Base Constructor for BaseObject.
+   */
+  BaseObject();
+  /**
+   * \brief Copy Constructor for BaseObject, registering the copy as a new node.
+   */
+  BaseObject(const BaseObject& other);
+  /**
+   * \brief Copy Assignment for BaseObject, keeping the own #profile_id.
+   */
+  BaseObject& operator=(const BaseObject& other);
   /** 
    * \brief Dummy Destructor to be implemented by child classes.
    */
@@ -131,6 +157,70 @@ public:
    * Converts point to homogenous coordinates and assumes that it is in object space.
    */
   bool included(const Eigen::Vector3d& point);
+
+  /**
+   * \brief Folds affine Transformations into the primitives below them, where possible.
+   * 
+   * Objects that can absorb a Transformation (see absorb_transformation()) take over its matrix,
+   * so the Transformation node is not needed anymore.
+   * 
+   * \param arena Arena to allocate new objects in.
+   * 
+   * \returns The object that should replace *this in the tree. If it differs from this,
+   * *this is not part of the tree anymore and stays unused in the Arena.
+   */
+  virtual BaseObject* fold_transformations(Arena& arena);
+
+  /**
+   * \brief Applies a Transformation directly to the shape of this object, if supported.
+   * 
+   * \param inverse Inverse of the Transformation to be applied.
+   * 
+   * \returns True, if the Transformation was applied. By default nothing is applied.
+   */
+  virtual bool absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse);
+
+  /**
+   * \brief Axis-aligned bounds of this object in object space.
+   * 
+   * The bounds are conservative, i.e. every point for which included() is true lies inside them.
+   * Objects without known bounds return BoundingBox::infinite().
+   */
+  virtual BoundingBox bounds() const;
+
+  /**
+   * \brief Estimated relative cost of a call to intersect() or included().
+   * 
+   * A single primitive has cost 1.
+   */
+  virtual double cost() const;
+
+  /**
+   * \brief Simplifies the subtree below this object without changing its shape.
+   * 
+   * Follows the same rules for replaced objects as fold_transformations().
+   * 
+   * \param report OptimizerReport to record all changes in.
+   * 
+   * \returns The object that should replace *this in the tree, or nullptr if the
+   * subtree is provably empty and can be removed entirely.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report);
+
+  /**
+   * \brief Appends the parts of this object, which can be intersected independently, to parts.
+   * 
+   * A ray hits the object in front of some distance, if and only if it hits one of its parts in front of it.
+   * By default, the object is a single part.
+   */
+  virtual void split(std::vector<const BaseObject*>& parts) const;
+
+  /**
+   * \brief Appends the objects directly below this object to dest.
+   * 
+   * By default, the object has no children.
+   */
+  virtual void children(std::vector<const BaseObject*>& dest) const;
 };
 
 
@@ -145,9 +235,20 @@ class RootObject {
 private:
   /**
    * \brief Oject describing the scene.
-   * Each BaseObject* should always be attribute of \b only \b one object, to prevent segmentation faults.
+   * Each BaseObject* should always be attribute of \b only \b one object.
    */
   BaseObject* child;
+  /**
+   * \brief The parts of #child, which can be tested for occluding a shadow ray independently.
+   * 
+   * \sa BaseObject::split()
+   */
+  std::vector<const BaseObject*> parts;
+
+  /**
+   * \brief Updates #parts after #child changed.
+   */
+  void split();
 public:
   /**
    * \brief Base Constructor for RootObject.
@@ -156,10 +257,9 @@ public:
   RootObject() = delete;
 
   /**
-   * \brief Destructor for RootObject.
-   * Frees #child.
+   * \brief Getter function for the object describing the scene.
    */
-  ~RootObject();
+  const BaseObject* top() const;
 
   /**
    * \brief Find the neares %intersection point of the scene and a Ray.
@@ -181,6 +281,48 @@ public:
    * \returns True, if point lies in any object in the scene.
    */
   bool included(const Eigen::Vector4d& point) const;
+
+  /**
+   * \brief Checks if a Ray hits the scene in front of distance, i.e. if a shadow ray is blocked.
+   * 
+   * Stops at the first part of the scene, that blocks the ray, without searching for the nearest %intersection.
+   * 
+   * \param r the shadow Ray
+   * \param distance distance of the light source along r
+   * \param occluder is set to the index of the blocking part
+   * \param skip index of a part, that is known not to block the ray
+   * 
+   * \returns True, if the ray is blocked.
+   */
+  bool occluded(const Ray& r, double distance, unsigned& occluder, unsigned skip) const;
+  /**
+   * \brief Checks if a Ray hits a single part of the scene in front of distance.
+   * 
+   * \param r the shadow Ray
+   * \param distance distance of the light source along r
+   * \param occluder index of the part, as set by occluded()
+   */
+  bool occluded_by(const Ray& r, double distance, unsigned occluder) const;
+
+  /**
+   * \brief Folds all affine Transformations of the scene into the primitives below them, where possible.
+   * 
+   * \param arena Arena, that the scene is allocated in.
+   * 
+   * \sa BaseObject::fold_transformations()
+   */
+  void fold_transformations(Arena& arena);
+
+  /**
+   * \brief Runs the optimizer pass on the whole scene.
+   * 
+   * \param arena Arena, that the scene is allocated in.
+   * 
+   * \returns Report of all changes made to the object tree.
+   * 
+   * \sa BaseObject::optimize(OptimizerReport&)
+   */
+  OptimizerReport optimize(Arena& arena);
 };
 
 
@@ -211,6 +353,15 @@ public:
   Primitive();
 
   virtual ~Primitive();
+
+  /**
+   * \brief Getter function for the color information.
+   */
+  const ColData& color() const;
+  /**
+   * \brief Getter function for the refraction index.
+   */
+  float refraction_index() const;
 };
 
 /**
@@ -234,6 +385,8 @@ public:
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
   
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
 };
 
 /**
@@ -241,7 +394,7 @@ public:
  * 
  * \brief A single-color plane.
  * 
- * The plane lies on the origin, perpendicular to #normal.
+ * The plane consists of all points \f$x\f$ with \f$n\cdot x+o=0\f$, where \f$n\f$ is #normal and \f$o\f$ is #offset.
  * All points lying below the plane, i.e. in opposite direction to #normal,
  * are interpreted as inside the object.
  */
@@ -251,6 +404,12 @@ private:
    * \brief normal vector of the plane
    */
   Eigen::Vector4d normal;
+  /**
+   * \brief Signed distance of the origin to the plane.
+   * 
+   * Is 0 for every constructed HalfSpace and only changes by absorbing Transformations.
+   */
+  double offset;
 public:
   /**
    * \brief Base Constructor for HalfSpace.
@@ -264,6 +423,20 @@ public:
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+
+  /**
+   * \brief Moves the plane according to a Transformation.
+   */
+  virtual bool absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) override;
+
+  /**
+   * \brief Plane equation in homogenous coordinates.
+   * 
+   * \returns The vector \f$(n_x, n_y, n_z, o)\f$, such that a point \f$x\f$ is inside, if its product with it is negative.
+   */
+  Eigen::Vector4d plane_equation() const;
 };
 
 /**
@@ -287,6 +460,217 @@ public:
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+};
+
+/**
+ * \class Quadric objects.hpp
+ * 
+ * \brief A single-color quadric surface.
+ * 
+ * The surface is described by a symmetric 4x4 matrix \f$Q\f$ in homogenous coordinates.
+ * All points \f$x\f$ with \f$x^TQx<0\f$ are interpreted as inside the object.
+ * 
+ * Affine Transformations above a Quadric can be folded into #coefficients at load time
+ * (see BaseObject::fold_transformations()), so a transformed Quadric is intersected
+ * directly in world space with a single quadratic solve.
+ */
+class Quadric: public Primitive {
+private:
+  /**
+   * \brief Symmetric coefficient matrix of the quadric.
+   */
+  Eigen::Matrix4d coefficients;
+public:
+  /**
+   * \brief Constructs a unit sphere, i.e. \f$x^2+y^2+z^2-1\f$.
+   */
+  static Quadric* UnitSphere(Arena& arena, ColData col, float index);
+  /**
+   * \brief Constructs an infinitely tall cylinder around the z-axis with radius 1, i.e. \f$x^2+y^2-1\f$.
+   */
+  static Quadric* UnitCylinder(Arena& arena, ColData col, float index);
+  /**
+   * \brief Constructs a double cone around the z-axis with opening angle 90 degrees, i.e. \f$x^2+y^2-z^2\f$.
+   */
+  static Quadric* UnitCone(Arena& arena, ColData col, float index);
+  /**
+   * \brief Constructs a paraboloid opening in z-direction, i.e. \f$x^2+y^2-z\f$.
+   */
+  static Quadric* UnitParaboloid(Arena& arena, ColData col, float index);
+
+  /**
+   * \brief Base Constructor for Quadric.
+   * 
+   * coefficients is symmetrized, i.e. \f$Q=\frac{1}{2}(Q+Q^T)\f$.
+   */
+  Quadric(ColData col, float index, const Eigen::Matrix4d& coefficients);
+  /**
+   * \brief Default Constructor for Quadric.
+   * 
+   * Constructs a unit sphere.
+   */
+  Quadric();
+
+  virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
+
+  virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  /**
+   * \brief Bounds of the quadric.
+   * 
+   * Finite only for ellipsoids, i.e. if the upper left 3x3 block of #coefficients is positive definite.
+   */
+  virtual BoundingBox bounds() const override;
+
+  /**
+   * \brief Applies a Transformation to the quadric.
+   * 
+   * Sets \f$Q=M^{-T}QM^{-1}\f$, where \f$M^{-1}\f$ is the given inverse.
+   */
+  virtual bool absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) override;
+
+  /**
+   * \brief Getter function for the coefficient matrix.
+   */
+  const Eigen::Matrix4d& matrix() const;
+};
+
+/**
+ * \class DistanceField objects.hpp
+ * 
+ * \brief A single-color object described by a signed distance function.
+ * 
+ * Rays are intersected by sphere tracing: starting where the Ray enters the bounds of the
+ * SdfProgram, it advances by the distance to the surface divided by the #lipschitz constant,
+ * until it comes closer than SDF_HIT_EPSILON, leaves the bounds or #max_iterations is reached.
+ * Tracing continues behind every hit, so exit points are found as well and DistanceFields can be used in Combinations.
+ */
+class DistanceField: public Primitive {
+private:
+  /**
+   * \brief The compiled distance function.
+   */
+  SdfProgram program;
+  /**
+   * \brief Upper bound for the slope of the distance function.
+   * 
+   * Is 1 for exact distance functions. Larger values make smaller, safer steps.
+   */
+  double lipschitz;
+  /**
+   * \brief Maximal number of steps per Ray.
+   */
+  unsigned max_iterations;
+public:
+  /** \brief Allocator for the instructions of #program. */
+  typedef SdfProgram::allocator_type allocator_type;
+
+  /**
+   * \brief Base Constructor for DistanceField.
+   * 
+   * program is copied using allocator.
+   * 
+   * \throws Cpp_Raytracing_INVALID_INPUT if program is not complete or lipschitz is not positive.
+   */
+  DistanceField(ColData col, float index, const SdfProgram& program, double lipschitz = 1, unsigned max_iterations = SDF_MAX_ITERATIONS,
+                const allocator_type& allocator = allocator_type());
+  /**
+   * \brief Constructor with default #lipschitz and #max_iterations, used by Arena::create().
+   */
+  DistanceField(ColData col, float index, const SdfProgram& program, const allocator_type& allocator);
+  DistanceField() = delete;
+
+  virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
+
+  virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  /**
+   * \brief Bounds of the SdfProgram.
+   */
+  virtual BoundingBox bounds() const override;
+
+  /**
+   * \brief Every step of the sphere tracing evaluates the whole SdfProgram.
+   */
+  virtual double cost() const override;
+};
+
+/**
+ * \class ConvexPolyhedron objects.hpp
+ * 
+ * \brief Intersection of a list of HalfSpaces, stored as a single primitive.
+ * 
+ * All plane equations are stored contiguously in #planes, so a Ray is intersected
+ * by a single entry / exit clipping loop over all planes, instead of intersecting every
+ * HalfSpace and checking each found point against all others.
+ * 
+ * Every face keeps the color and refraction index of the HalfSpace it was built from.
+ */
+class ConvexPolyhedron: public BaseObject {
+private:
+  /** \brief Matrix type of the plane equations, one per row. */
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 4, Eigen::RowMajor> PlaneMatrix;
+
+  /**
+   * \brief Coefficients of the plane equations, stored row by row.
+   * 
+   * \sa planes()
+   */
+  std::pmr::vector<double> plane_data;
+  /**
+   * \brief Color information of each face.
+   */
+  std::pmr::vector<ColData> colors;
+  /**
+   * \brief Refraction index of each face.
+   */
+  std::pmr::vector<float> indices;
+
+  /**
+   * \brief Plane equations, one per row.
+   * 
+   * A point \f$x\f$ is inside, if the product of every row with \f$x\f$ is negative.
+   * \sa HalfSpace::plane_equation()
+   */
+  Eigen::Map<const PlaneMatrix> planes() const;
+  /**
+   * \brief Modifiable plane equations, one per row.
+   */
+  Eigen::Map<PlaneMatrix> planes();
+
+public:
+  /** \brief Allocator for the plane equations and face informations. */
+  typedef std::pmr::polymorphic_allocator<double> allocator_type;
+
+  /**
+   * \brief Base Constructor for ConvexPolyhedron.
+   * 
+   * \param half_spaces HalfSpaces whose intersection forms the polyhedron. They are not taken over.
+   * \param allocator allocator for the plane equations and face informations
+   */
+  ConvexPolyhedron(const std::vector<const HalfSpace*>& half_spaces, const allocator_type& allocator = allocator_type());
+  ConvexPolyhedron() = delete;
+
+  virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
+
+  virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  /**
+   * \brief Bounds of the polyhedron, computed from its vertices.
+   */
+  virtual BoundingBox bounds() const override;
+
+  /**
+   * \brief Moves all planes according to a Transformation.
+   */
+  virtual bool absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) override;
+
+  /**
+   * \brief Number of faces, i.e. planes, of the polyhedron.
+   */
+  unsigned faces() const;
 };
 
 
@@ -319,6 +703,7 @@ public:
   /**
    * \brief Constructs a scaling Transformation.
    * 
+   * \param arena Arena to allocate the Transformation in.
    * \param child BaseObject to be transformed.
    * \param ax Scaling factor in x direction.
    * \param ay Scaling factor in y direction.
@@ -326,39 +711,43 @@ public:
    * 
    * \returns Transformation that applies the described scalation.
    */
-  static Transformation* Scaling(BaseObject* child, double ax, double ay, double az);
+  static Transformation* Scaling(Arena& arena, BaseObject* child, double ax, double ay, double az);
 
   /**
    * \brief Constructs a rotation Transformation around the x-axis
    * 
+   * \param arena Arena to allocate the Transformation in.
    * \param child BaseObject to be transformed.
    * \param alpha Angle to rotate around.
    * 
    * \returns Transformation that applies the described rotation.
    */
-  static Transformation* Rotation_X(BaseObject* child, double alpha);
+  static Transformation* Rotation_X(Arena& arena, BaseObject* child, double alpha);
   /**
    * \brief Constructs a rotation Transformation around the y-axis
    * 
+   * \param arena Arena to allocate the Transformation in.
    * \param child BaseObject to be transformed.
    * \param alpha Angle to rotate around.
    * 
    * \returns Transformation that applies the described rotation.
    */
-  static Transformation* Rotation_Y(BaseObject* child, double alpha);
+  static Transformation* Rotation_Y(Arena& arena, BaseObject* child, double alpha);
   /**
    * \brief Constructs a rotation Transformation around the z-axis
    * 
+   * \param arena Arena to allocate the Transformation in.
    * \param child BaseObject to be transformed.
    * \param alpha Angle to rotate around.
    * 
    * \returns Transformation that applies the described rotation.
    */
-  static Transformation* Rotation_Z(BaseObject* child, double alpha);
+  static Transformation* Rotation_Z(Arena& arena, BaseObject* child, double alpha);
 
   /**
    * \brief Constructs a translation Transformation.
    * 
+   * \param arena Arena to allocate the Transformation in.
    * \param child BaseObject to be transformed.
    * \param ax Translation factor in x direction.
    * \param ay Translation factor in y direction.
@@ -366,7 +755,7 @@ public:
    * 
    * \returns Transformation that applies the described translation.
    */
-  static Transformation* Translation(BaseObject* child, double dx, double dy, double dz);
+  static Transformation* Translation(Arena& arena, BaseObject* child, double dx, double dy, double dz);
 
   /** 
    * \brief Helper Constructor for scaling.
@@ -381,12 +770,29 @@ public:
    */
   Transformation(BaseObject* child, Eigen::Translation<double, 3> translation);
 
-  virtual ~Transformation();
-
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
 
+  virtual BoundingBox bounds() const override;
+
+  virtual double cost() const override;
+
+  /**
+   * \brief Removes this Transformation if it is the identity and merges it with a directly following Transformation.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report) override;
+
+  /**
+   * \brief Folds this Transformation into its child, if the child is a Quadric.
+   */
+  virtual BaseObject* fold_transformations(Arena& arena) override;
+
+  /**
+   * \brief Appends #child to dest.
+   */
+  virtual void children(std::vector<const BaseObject*>& dest) const override;
+
   /**
    * \brief Getter function for the forward transformation matrix.
    */
@@ -409,16 +815,40 @@ protected:
   /**
    * \brief List of objects that are to be combined.
    */
-  std::vector<BaseObject*> objects;
+  std::pmr::vector<BaseObject*> objects;
 
 public:
+  /** \brief Allocator for #objects. */
+  typedef std::pmr::polymorphic_allocator<BaseObject*> allocator_type;
+
   /**
    * \brief Base Constructor for Combination.
    */
-  Combination(std::vector<BaseObject*> objects);
+  Combination(const std::vector<BaseObject*>& objects, const allocator_type& allocator = allocator_type());
   Combination() = delete;
 
-  virtual ~Combination();
+  /**
+   * \brief Folds the Transformations in each element of #objects.
+   */
+  virtual BaseObject* fold_transformations(Arena& arena) override;
+
+  /**
+   * \brief Sum of the costs of all elements of #objects.
+   */
+  virtual double cost() const override;
+
+  /**
+   * \brief Appends all elements of #objects to dest.
+   */
+  virtual void children(std::vector<const BaseObject*>& dest) const override;
+
+protected:
+  /**
+   * \brief Runs the optimizer on each element of #objects.
+   * 
+   * Elements that turn out to be empty are replaced by nullptr and have to be removed by the caller.
+   */
+  void optimize_objects(OptimizerReport& report);
 };
 
 /**
@@ -433,12 +863,24 @@ public:
   /** 
    * \brief Base Constructor for Union.
    */
-  Union(std::vector<BaseObject*> objects);
+  Union(const std::vector<BaseObject*>& objects, const allocator_type& allocator = allocator_type());
   Union() = delete;
 
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+
+  /**
+   * \brief Flattens nested Unions, removes empty elements and collapses single-element Unions.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report) override;
+
+  /**
+   * \brief The parts of every element of #objects are parts of the Union.
+   */
+  virtual void split(std::vector<const BaseObject*>& parts) const override;
 };
 
 /**
@@ -453,12 +895,30 @@ public:
   /** 
    * \brief Base Constructor for Intersection.
    */
-  Intersection(std::vector<BaseObject*> objects);
+  Intersection(const std::vector<BaseObject*>& objects, const allocator_type& allocator = allocator_type());
   Intersection() = delete;
 
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+
+  virtual double cost() const override;
+
+  /**
+   * \brief Folds the Transformations in each element of #objects and replaces the Intersection
+   * by a ConvexPolyhedron, if all elements are HalfSpaces afterwards.
+   */
+  virtual BaseObject* fold_transformations(Arena& arena) override;
+
+  /**
+   * \brief Flattens nested Intersections, removes provably empty Intersections and reorders #objects.
+   * 
+   * Elements are sorted by the ratio of their cost and their estimated probability to reject a point,
+   * so included() fails as early and cheaply as possible.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report) override;
 };
 
 /**
@@ -473,12 +933,21 @@ public:
   /** 
    * \brief Base Constructor for Exclusion.
    */
-  Exclusion(std::vector<BaseObject*> objects);
+  Exclusion(const std::vector<BaseObject*>& objects, const allocator_type& allocator = allocator_type());
   Exclusion() = delete;
 
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+
+  virtual double cost() const override;
+
+  /**
+   * \brief Removes empty elements and collapses single-element Exclusions.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report) override;
 };
 
 /**
@@ -493,10 +962,22 @@ public:
   /** 
    * \brief Base Constructor for Subtraction.
    */
-  Subtraction(std::vector<BaseObject*> objects);
+  Subtraction(const std::vector<BaseObject*>& objects, const allocator_type& allocator = allocator_type());
   Subtraction() = delete;
 
   virtual bool intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const override;
 
   virtual bool included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const override;
+
+  virtual BoundingBox bounds() const override;
+
+  virtual double cost() const override;
+
+  /**
+   * \brief Removes subtracted elements that cannot overlap the first element and reorders the remaining ones.
+   * 
+   * Subtracted elements are sorted by the ratio of their cost and their estimated probability to contain
+   * a point of the first element, so included() fails as early and cheaply as possible.
+   */
+  virtual BaseObject* optimize(OptimizerReport& report) override;
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <objects.hpp>
+#include <ray.hpp>
+#include "defines.h"
+
+/**
+ * \class OccluderReport occluder_cache.hpp
+ *
+ * \brief Summary of the shadow rays tested by an OccluderCache during a render.
+ *
+ * \sa Scene::occluders()
+ */
+struct OccluderReport {
+  /** \brief Number of shadow rays tested for being blocked. */
+  unsigned long shadow_rays = 0;
+  /** \brief Number of shadow rays blocked by any part of the scene. */
+  unsigned long occluded_rays = 0;
+  /** \brief Number of shadow rays, that were tested against a cached occluder first. */
+  unsigned long cached_tests = 0;
+  /** \brief Number of shadow rays blocked by the cached occluder, so the scene did not have to be searched. */
+  unsigned long cache_hits = 0;
+
+  /**
+   * \brief Fraction of the cached tests, that were hits. 0 if there were none.
+   */
+  double hit_rate() const;
+  /**
+   * \brief Fraction of the shadow rays, that were blocked. 0 if there were none.
+   */
+  double occlusion_rate() const;
+
+  /**
+   * \brief Adds the counts of other.
+   */
+  OccluderReport& operator+=(const OccluderReport& other);
+
+  /**
+   * \brief Formats the report into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param report OccluderReport to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const OccluderReport& report);
+};
+
+/**
+ * \class OccluderCache occluder_cache.hpp
+ *
+ * \brief Remembers the part of the scene, that blocked the last shadow ray to every LightSource.
+ *
+ * Neighboring hit points are usually shadowed by the same object, so this part is tested first
+ * and the whole scene is only searched, if it does not block the ray.
+ * A cache must only be used by a single thread.
+ *
+ * \sa RootObject::occluded()
+ */
+class OccluderCache {
+private:
+  /** \brief Marks a LightSource without a cached occluder. */
+  static constexpr unsigned NO_OCCLUDER = std::numeric_limits<unsigned>::max();
+
+  /** \brief Index of the part of the scene, that blocked the last shadow ray to every LightSource. */
+  std::vector<unsigned> occluders;
+  /** \brief Counts of all tests since the cache was constructed. */
+  OccluderReport counts;
+
+public:
+  /**
+   * \brief Constructs an empty cache for the given number of LightSources.
+   */
+  OccluderCache(unsigned sources);
+  /**
+   * \brief Default Constructor for OccluderCache, without any lights.
+   */
+  OccluderCache();
+
+  /**
+   * \brief Checks if a shadow ray is blocked, testing the cached occluder of its LightSource first.
+   *
+   * Gives the same result as searching the nearest %intersection of objects and comparing it to distance.
+   *
+   * \param objects the scene
+   * \param r the shadow Ray
+   * \param distance distance of the light source along r
+   * \param source index of the LightSource
+   *
+   * \returns True, if the ray is blocked.
+   */
+  bool occluded(const RootObject& objects, const Ray& r, double distance, unsigned source);
+
+  /**
+   * \brief Getter function for the counts of all tests.
+   */
+  const OccluderReport& report() const;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iostream>
+
+/**
+ * \class OptimizerReport optimizer.hpp
+ *
+ * \brief Summary of the changes made by the load-time optimizer pass.
+ *
+ * \sa BaseObject::optimize(OptimizerReport&)
+ */
+struct OptimizerReport {
+  /** \brief Number of Union and Intersection nodes merged into a parent of the same type. */
+  unsigned flattened_combinations = 0;
+  /** \brief Number of Combinations replaced by their only element. */
+  unsigned collapsed_combinations = 0;
+  /** \brief Number of Transformations removed, because they are the identity. */
+  unsigned removed_transformations = 0;
+  /** \brief Number of Transformations merged into a directly following Transformation. */
+  unsigned merged_transformations = 0;
+  /** \brief Number of Intersections and Subtractions whose elements were reordered. */
+  unsigned reordered_combinations = 0;
+  /** \brief Number of subtrees removed, because their bounds are provably empty or irrelevant. */
+  unsigned removed_subtrees = 0;
+
+  /**
+   * \brief Checks if the optimizer changed anything.
+   */
+  bool changed() const;
+
+  /**
+   * \brief Formats the report into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param report OptimizerReport to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const OptimizerReport& report);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "defines.h"
+
+/**
+ * \class PixelCost pixel_cost.hpp
+ *
+ * \brief Work done to render a single pixel, recorded by Scene::generate() if RenderOptions::cost_map is set.
+ *
+ * While a sample of a pixel is traced, its PixelCost is the recording target of the tracing thread,
+ * so the counters deep inside of the object tree and the shadow rays do not need to know the pixel.
+ *
+ * \sa Scene::costs()
+ */
+struct PixelCost {
+  /** \brief Number of primary rays, i.e. samples of the pixel. */
+  unsigned primary = 0;
+  /** \brief Number of shadow rays tested for being blocked. */
+  unsigned shadow = 0;
+  /** \brief Number of reflected and refracted rays. */
+  unsigned secondary = 0;
+  /** \brief Number of points tested by CSG combinations for being included in one of their elements. */
+  unsigned long included = 0;
+  /** \brief Wall-clock seconds spent tracing the samples of the pixel. */
+  double seconds = 0;
+
+  /** \brief Number of values per pixel written by write_costs(). */
+  static constexpr unsigned channels = 5;
+  /** \brief Names of the values per pixel written by write_costs(), in order. */
+  static const std::string channel_names;
+
+  /** \brief Cost of the pixel the calling thread traces at the moment, nullptr if nothing is recorded. */
+  static thread_local PixelCost* recording;
+
+  /**
+   * \brief Counts a shadow ray of the pixel currently recorded by the calling thread.
+   */
+  static void count_shadow() {
+    if (recording != nullptr) {
+      recording->shadow++;
+    }
+  }
+  /**
+   * \brief Counts a reflected or refracted ray of the pixel currently recorded by the calling thread.
+   */
+  static void count_secondary() {
+    if (recording != nullptr) {
+      recording->secondary++;
+    }
+  }
+  /**
+   * \brief Counts a CSG inclusion test of the pixel currently recorded by the calling thread.
+   * 
+   * \sa RenderStats::count_csg_test()
+   */
+  static void count_included() {
+    if (recording != nullptr) {
+      recording->included++;
+    }
+  }
+};
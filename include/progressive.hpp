@@ -0,0 +1,27 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * \class ProgressiveFrame progressive.hpp
+ *
+ * \brief An intermediate or final image of Scene::generate_progressive().
+ */
+struct ProgressiveFrame {
+  /** \brief The image, untraced pixels are filled in from the nearest traced pixel. */
+  cv::Mat_<cv::Vec3b> image;
+  /**
+   * \brief Which pixels of #image are traced.
+   *
+   * Filled in pixels are black, pixels traced through their center only are gray and finished pixels are white.
+   */
+  cv::Mat_<cv::Vec3b> coverage;
+  /** \brief Number of started passes. */
+  unsigned passes = 0;
+  /** \brief Fraction of finished pixels. */
+  float finished = 0;
+  /** \brief Wall-clock seconds since rendering started. */
+  double elapsed = 0;
+  /** \brief Whether every pixel is finished, i.e. #image is the same as a complete render. */
+  bool complete = false;
+};
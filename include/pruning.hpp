@@ -0,0 +1,38 @@
+#pragma once
+
+#include <iostream>
+
+/**
+ * \class PruningReport pruning.hpp
+ *
+ * \brief Summary of the secondary rays skipped by Scene::trace_ray during a render.
+ *
+ * Every reflected or refracted ray, that could have been traced, is counted exactly once.
+ *
+ * \sa Scene::pruning()
+ */
+struct PruningReport {
+  /** \brief Number of reflected and refracted rays, that were traced. */
+  unsigned long traced_rays = 0;
+  /** \brief Number of rays skipped, because the reflected or refracted coefficient is black. */
+  unsigned long black_rays = 0;
+  /** \brief Number of rays skipped, because their weight in the pixel is below the contribution threshold. */
+  unsigned long negligible_rays = 0;
+  /** \brief Number of rays terminated by russian roulette. */
+  unsigned long roulette_rays = 0;
+
+  /**
+   * \brief Number of skipped rays.
+   */
+  unsigned long pruned() const;
+
+  /**
+   * \brief Formats the report into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param report PruningReport to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const PruningReport& report);
+};
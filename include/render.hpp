@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+
+/**
+ * \brief Strategies of Scene::generate() to trace the rays of an image.
+ */
+enum class RenderMode {
+  /** \brief Every pixel is traced completely, before the next one is started. */
+  PIXEL,
+  /** \brief Large batches of rays are traced together, one stage at a time. */
+  WAVEFRONT
+};
+
+/**
+ * \brief Orders, in which Scene::generate() traces the pixels inside of a tile of the image.
+ */
+enum class PixelOrder {
+  /** \brief Row by row. */
+  SCANLINE,
+  /** \brief Along the Morton curve (Z-order), which visits every aligned square of 2^k x 2^k pixels completely before leaving it. */
+  MORTON,
+  /** \brief Along the Hilbert curve, which additionally only steps between neighboring pixels. */
+  HILBERT
+};
+
+/**
+ * \class RenderOptions render.hpp
+ *
+ * \brief Settings of Scene::generate(), that do not change the described scene.
+ */
+struct RenderOptions {
+  /** \brief How the rays are traced. */
+  RenderMode mode = RenderMode::PIXEL;
+  /** \brief Number of threads for the stages of RenderMode::WAVEFRONT, 0 uses one per hardware thread. */
+  unsigned threads = 0;
+  /** \brief Number of pixels traced together by RenderMode::WAVEFRONT. */
+  unsigned batch_size = WAVEFRONT_BATCH_SIZE;
+  /** \brief If RenderMode::WAVEFRONT sorts the reflected and refracted rays by direction and start point before tracing them. */
+  bool sort_secondary = false;
+  /** \brief Number of LightSources chosen by importance to shade every hit point, 0 shades by all of them exactly. */
+  unsigned light_samples = 0;
+  /** \brief Number of samples of every pixel, a single one goes through the center of the pixel. */
+  unsigned min_samples = 1;
+  /** \brief Number of samples of pixels with a high contrast to their neighbors. Anti-aliasing is enabled, if it is larger than 1. */
+  unsigned max_samples = 1;
+  /** \brief Smallest difference of a color channel to a neighboring pixel, that counts as a high contrast. */
+  float contrast_threshold = AA_CONTRAST_THRESHOLD;
+  /** \brief Wall-clock seconds Scene::generate_progressive() may take, 0 for no limit. */
+  double time_budget = 0;
+  /** \brief Fraction of finished pixels, at which Scene::generate_progressive() stops. */
+  float coverage_target = 1;
+  /** \brief Distance of the pixels traced in the first pass of Scene::generate_progressive(). */
+  unsigned progressive_step = PROGRESSIVE_STEP;
+  /** \brief If the work done for every pixel is recorded, see Scene::costs(). Only RenderMode::PIXEL records it. */
+  bool cost_map = false;
+  /** \brief Order of the pixels inside of a tile. */
+  PixelOrder pixel_order = PixelOrder::SCANLINE;
+  /** \brief Side of the square tiles, which are traced one after another, row by row. 0 treats the whole image as a single tile. */
+  unsigned tile_size = 0;
+
+  /**
+   * \brief Number of threads actually used, resolving #threads = 0.
+   */
+  unsigned thread_count() const {
+    if (threads > 0) {
+      return threads;
+    }
+
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * \brief Whether the image should be rendered by Scene::generate_progressive(), i.e. a time budget or coverage target is set.
+   */
+  bool progressive() const {
+    return time_budget > 0 or coverage_target < 1;
+  }
+};
+
+/**
+ * \class PixelSample render.hpp
+ *
+ * \brief A point on the screen, that a primary ray passes through.
+ */
+struct PixelSample {
+  /** \brief Index of the pixel, row by row. */
+  unsigned pixel;
+  /** \brief Position of the point inside of the pixel along both axes of the screen, in [0, 1). */
+  float dx, dy;
+};
+
+/**
+ * \brief The indices of all pixels of an image, row by row, in the order they are traced.
+ *
+ * The image is divided into tiles of tile_size x tile_size pixels, which are visited row by row, and the pixels
+ * of every tile are visited in order. Tiles at the right and bottom border may be smaller.
+ *
+ * \param rows number of rows of the image
+ * \param columns number of columns of the image
+ * \param order order of the pixels inside of a tile
+ * \param tile_size side of the tiles, 0 treats the whole image as a single tile
+ */
+std::vector<unsigned> pixel_traversal(unsigned rows, unsigned columns, PixelOrder order, unsigned tile_size);
+
+/**
+ * \brief Calls body(begin, end) for contiguous, disjoint ranges covering [0, count) on up to threads threads.
+ *
+ * Returns after all ranges are processed. Small counts are processed on the calling thread only.
+ */
+template <typename Body>
+void parallel_for(unsigned count, unsigned threads, Body body) {
+  unsigned chunks = std::min(threads, (count + PARALLEL_MIN_CHUNK - 1) / PARALLEL_MIN_CHUNK);
+
+  if (chunks <= 1) {
+    body(0u, count);
+    return;
+  }
+
+  auto bound = [count, chunks](unsigned c) {
+    return (unsigned) ((unsigned long) count * c / chunks);
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned c = 1; c < chunks; c++) {
+    workers.emplace_back(body, bound(c), bound(c + 1));
+  }
+
+  body(0u, bound(1)); // the calling thread takes the first range
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
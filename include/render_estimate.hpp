@@ -0,0 +1,76 @@
+#pragma once
+
+#include <iostream>
+#include <json.hpp>
+
+#include "defines.h"
+
+/**
+ * \class EstimateInterval render_estimate.hpp
+ *
+ * \brief An estimated quantity with its confidence interval.
+ */
+struct EstimateInterval {
+  /** \brief The most likely value. */
+  double value = 0;
+  /** \brief Lower bound of the confidence interval. */
+  double low = 0;
+  /** \brief Upper bound of the confidence interval. */
+  double high = 0;
+
+  /**
+   * \brief The interval as a JSON object with value, low and high.
+   */
+  nlohmann::json json() const;
+};
+
+/**
+ * \class RenderEstimate render_estimate.hpp
+ *
+ * \brief Expected cost of rendering a Scene, extrapolated from a sparse sample of its pixels.
+ *
+ * All intervals are ESTIMATE_CONFIDENCE intervals, assuming the sampled strata represent the whole image.
+ *
+ * \sa Scene::estimate()
+ */
+struct RenderEstimate {
+  /** \brief Number of pixels of the image. */
+  unsigned long pixels = 0;
+  /** \brief Number of strata, whose pixels were sampled. */
+  unsigned strata = 0;
+  /** \brief Number of pixels traced to estimate the cost. */
+  unsigned long traced_pixels = 0;
+  /** \brief Fraction of the pixels, that will be refined by anti-aliasing. */
+  EstimateInterval refined_fraction;
+  /** \brief Number of primary rays per pixel, including anti-aliasing. */
+  EstimateInterval samples_per_pixel;
+  /** \brief Number of primary rays. */
+  EstimateInterval primary_rays;
+  /** \brief Number of traced reflected and refracted rays. */
+  EstimateInterval secondary_rays;
+  /** \brief Number of shadow rays. */
+  EstimateInterval shadow_rays;
+  /** \brief Number of points tested by CSG combinations. */
+  EstimateInterval csg_tests;
+  /** \brief Wall-clock seconds of the render, assuming perfect scaling over the threads of RenderMode::WAVEFRONT. */
+  EstimateInterval seconds;
+  /** \brief Expected peak resident memory of the process during the render, in kilobytes. */
+  long memory_kb = 0;
+  /** \brief Wall-clock seconds spent on the estimate. */
+  double sampling_seconds = 0;
+
+  /**
+   * \brief The estimate as a JSON object.
+   */
+  nlohmann::json json() const;
+
+  /**
+   * \brief Formats the estimate into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param estimate RenderEstimate to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const RenderEstimate& estimate);
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <json.hpp>
+
+#include <pixel_cost.hpp>
+#include "defines.h"
+
+/**
+ * \class RenderStats render_stats.hpp
+ *
+ * \brief Statistics of a single call of Scene::generate() or Scene::generate_progressive().
+ *
+ * They can be written as JSON or in the Prometheus text format, e.g. to trend the performance of a scene over builds.
+ *
+ * \sa Scene::statistics()
+ */
+struct RenderStats {
+  /** \brief Number of primary rays, i.e. samples of all pixels. */
+  unsigned long primary_rays = 0;
+  /** \brief Number of traced reflected and refracted rays. */
+  unsigned long secondary_rays = 0;
+  /** \brief Number of shadow rays tested for being blocked. */
+  unsigned long shadow_rays = 0;
+  /** \brief Number of shadow rays blocked by any part of the scene. */
+  unsigned long occluded_rays = 0;
+  /** \brief Number of primary and secondary rays, that hit the scene. */
+  unsigned long hits = 0;
+  /** \brief Largest recursion depth of a traced ray, 0 for primary rays. */
+  unsigned max_depth = 0;
+  /** \brief Number of points tested by CSG combinations for being included in one of their elements. */
+  unsigned long csg_tests = 0;
+  /** \brief Wall-clock seconds of every phase of the render, in their order. */
+  std::vector<std::pair<std::string, double>> phases;
+  /** \brief Largest resident set size of the process at the end of the render, in kilobytes. */
+  long peak_memory_kb = 0;
+
+  /**
+   * \brief Fraction of the shadow rays, that were blocked. 0 if there were none.
+   */
+  double occlusion_rate() const;
+  /**
+   * \brief Fraction of the primary and secondary rays, that hit the scene. 0 if there were none.
+   */
+  double hit_rate() const;
+  /**
+   * \brief Wall-clock seconds of all phases.
+   */
+  double seconds() const;
+
+  /**
+   * \brief Appends a phase, that lasted from mark until now, and moves mark to now.
+   */
+  void add_phase(const std::string& name, std::chrono::steady_clock::time_point& mark);
+
+  /**
+   * \brief The statistics as a JSON object.
+   */
+  nlohmann::json json() const;
+  /**
+   * \brief Writes the statistics in the Prometheus text exposition format into out.
+   *
+   * \param out outputstream to write into
+   * \param scene value of the label scene of every sample, no label if it is empty
+   */
+  void write_prometheus(std::ostream& out, const std::string& scene = "") const;
+
+  /**
+   * \brief Formats the statistics into an output stream.
+   *
+   * \param out outputstream to format into
+   * \param stats RenderStats to format into out
+   *
+   * \return modified output stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, const RenderStats& stats);
+
+  /**
+   * \brief Largest resident set size of the process so far, in kilobytes.
+   */
+  static long peak_memory();
+
+  /**
+   * \brief Counts a point tested by a CSG combination, on the calling thread.
+   *
+   * Also counts it into the PixelCost recorded by the calling thread.
+   */
+  static void count_csg_test() {
+    local_csg_tests.count++;
+    PixelCost::count_included();
+  }
+  /**
+   * \brief Number of CSG tests counted by the calling thread and all ended threads since the last reset_csg_tests().
+   */
+  static unsigned long csg_test_count();
+  /**
+   * \brief Sets the CSG tests of the calling thread and all ended threads to 0.
+   */
+  static void reset_csg_tests();
+
+private:
+  /**
+   * \brief CSG tests of a single thread, added to #finished_csg_tests, when the thread ends.
+   */
+  struct ThreadCsgTests {
+    /** \brief Number of CSG tests of the thread. */
+    unsigned long count = 0;
+
+    /**
+     * \brief Adds the count to #finished_csg_tests.
+     */
+    ~ThreadCsgTests();
+  };
+
+  /** \brief CSG tests of all ended threads. */
+  static std::atomic<unsigned long> finished_csg_tests;
+  /** \brief CSG tests of the calling thread. */
+  static thread_local ThreadCsgTests local_csg_tests;
+};
@@ -4,16 +4,32 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <memory>
+#include <functional>
+#include <random>
 #include <iostream>
 #include "math.h"
 #include <Dense>
 #include <opencv2/opencv.hpp>
 #include <json.hpp>
 
+#include <arena.hpp>
 #include <objects.hpp>
 #include <light.hpp>
 #include <ray.hpp>
 #include <composite.hpp>
+#include <pruning.hpp>
+#include <trace.hpp>
+#include <render.hpp>
+#include <wavefront.hpp>
+#include <light_tree.hpp>
+#include <light_grid.hpp>
+#include <occluder_cache.hpp>
+#include <progressive.hpp>
+#include <pixel_cost.hpp>
+#include <timeline.hpp>
+#include <render_stats.hpp>
+#include <render_estimate.hpp>
 #include "defines.h"
 
 /**
@@ -27,9 +43,9 @@
 class Scene {
 private:
   /** \brief Function pointer to object creating helper functions for reading the scene. */
-  typedef BaseObject* (*action_t)(nlohmann::json&);
+  typedef BaseObject* (*action_t)(nlohmann::json&, Arena&);
   /** \brief Function pointer to rotation creating functions. */
-  typedef Transformation* (*rotation_t)(BaseObject*, double);
+  typedef Transformation* (*rotation_t)(Arena&, BaseObject*, double);
   /** \brief Action handler to choose reading helper function based on object string in the scene describing .json. */
   static const std::map<std::string, action_t> action_handler;
   /** \brief Action handler to choose the right rotation based on an index 
@@ -37,50 +53,66 @@ private:
    * 0 -- X-Axis, 1 -- Y-Axis, 2 -- Z-Axis
   */
   static const std::array<rotation_t, 3> rotation_handler;
+  /** \brief Function pointer to Quadric creating functions. */
+  typedef Quadric* (*quadric_t)(Arena&, ColData, float);
+  /** \brief Action handler to choose the Quadric constructor based on the "shape" string of a quadric. */
+  static const std::map<std::string, quadric_t> quadric_handler;
+  /** \brief Function pointer to helper functions, that compile a node of a signed distance field expression. */
+  typedef void (*sdf_action_t)(nlohmann::json&, SdfProgram&);
+  /** \brief Action handler to choose the compiling helper function based on the node string of a signed distance field expression. */
+  static const std::map<std::string, sdf_action_t> sdf_handler;
   /** 
    * \brief Action handler to choose the right color based on the read string.
    */
   static const std::map<std::string, LightIntensity> color_handler;
 
   /** \brief Helper function to read a LightSource from .json */
-  static LightSource* read_source(nlohmann::json& descr);
+  static LightSource* read_source(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a LightIntensity from .json */
   static LightIntensity read_color(nlohmann::json& descr);
 
   /** \brief Helper function to read a ColData from .json */
   static ColData read_col_data(nlohmann::json& descr);
   /** \brief Helper function to read a list of BaseObjects from .json into a vector. */
-  static std::vector<BaseObject*> read_obj_list(nlohmann::json& descr);
+  static std::vector<BaseObject*> read_obj_list(nlohmann::json& descr, Arena& arena);
 
   /** \brief Helper function to read a Sphere from .json */
-  static BaseObject* read_sphere(nlohmann::json& descr);
+  static BaseObject* read_sphere(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a HalfSpace from .json */
-  static BaseObject* read_half_space(nlohmann::json& descr);
+  static BaseObject* read_half_space(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a Cylinder from .json */
-  static BaseObject* read_cylinder(nlohmann::json& descr);
+  static BaseObject* read_cylinder(nlohmann::json& descr, Arena& arena);
+  /** \brief Helper function to read a Quadric from .json */
+  static BaseObject* read_quadric(nlohmann::json& descr, Arena& arena);
+  /** \brief Helper function to read a DistanceField from .json */
+  static BaseObject* read_sdf(nlohmann::json& descr, Arena& arena);
+  /** \brief Helper function to compile a signed distance field expression from .json into program. */
+  static void read_sdf_expression(nlohmann::json& descr, SdfProgram& program);
+  /** \brief Helper function to compile the "objects" of a signed distance field combination from .json, combining them pairwise from left to right. */
+  static void read_sdf_combination(nlohmann::json& descr, SdfProgram& program, SdfOpcode op, double smoothing = 0);
 
   /** \brief Helper function to read a scaling Transformation from .json */
-  static BaseObject* read_scaling(nlohmann::json& descr);
+  static BaseObject* read_scaling(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a rotation Transformation from .json */
-  static BaseObject* read_rotation(nlohmann::json& descr);
+  static BaseObject* read_rotation(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a translation Transformation from .json */
-  static BaseObject* read_translation(nlohmann::json& descr);
+  static BaseObject* read_translation(nlohmann::json& descr, Arena& arena);
 
   /** \brief Helper function to read a Union from .json */
-  static BaseObject* read_union(nlohmann::json& descr);
+  static BaseObject* read_union(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read an Intersection from .json */
-  static BaseObject* read_intersection(nlohmann::json& descr);
+  static BaseObject* read_intersection(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read an Exclusion from .json */
-  static BaseObject* read_exclusion(nlohmann::json& descr);
+  static BaseObject* read_exclusion(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a Subtraction from .json */
-  static BaseObject* read_subtraction(nlohmann::json& descr);
+  static BaseObject* read_subtraction(nlohmann::json& descr, Arena& arena);
 
   /** \brief Helper function to read a Cube from .json */
-  static BaseObject* read_cube(nlohmann::json& descr);
+  static BaseObject* read_cube(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a Prism from .json */
-  static BaseObject* read_prism(nlohmann::json& descr);
+  static BaseObject* read_prism(nlohmann::json& descr, Arena& arena);
   /** \brief Helper function to read a Triforce from .json */
-  static BaseObject* read_triforce(nlohmann::json& descr);
+  static BaseObject* read_triforce(nlohmann::json& descr, Arena& arena);
 
   /** \brief Prints the current progress as a progression bar in std::cout. 
    * 
@@ -90,6 +122,224 @@ private:
   */
   static void progress_bar(float progress);
 
+  /**
+   * \brief Channel-wise product of li with factor, capped at 1 like every other LightIntensity.
+   */
+  static LightIntensity amplified(const LightIntensity& li, float factor);
+
+  /**
+   * \brief Decides, if a reflected or refracted ray has to be traced.
+   * 
+   * Counts the decision in #pruning_report.
+   * 
+   * \param coefficient reflected or refracted coefficient of the hit object
+   * \param weight weight of the secondary ray in the pixel, i.e. coefficient times the weight of the current ray
+   * 
+   * \returns 0 if the ray is skipped, otherwise the factor, by which its contribution has to be amplified
+   * to make up for the rays terminated by russian roulette.
+   */
+  float survival(const LightIntensity& coefficient, const LightIntensity& weight);
+  /**
+   * \brief Updates #object_indexs, when a ray enters or leaves an object.
+   * 
+   * \returns The refraction index behind the surface at ip.
+   */
+  float medium_index(const IntersectionPoint& ip);
+  /**
+   * \brief Number of LightSources shading a hit point, that can be reached by the given lights.
+   * 
+   * All lights in exact mode, i.e. if #light_samples is 0 or not smaller than their number, #light_samples otherwise.
+   */
+  unsigned light_count(const std::vector<unsigned>& lights) const;
+  /**
+   * \brief Chooses the k-th of the light_count() LightSources shading a point.
+   * 
+   * In exact mode, this is simply the k-th of lights with weight 1. Otherwise, it is chosen randomly from all #sources by #light_tree,
+   * weighted by the inverse of its probability, so the expected sum of all chosen lights equals the sum of all #sources.
+   * 
+   * \param point the hit point
+   * \param k index of the choice
+   * \param lights indices of all LightSources, that can reach point
+   */
+  LightChoice choose_light(const Eigen::Vector4d& point, unsigned k, const std::vector<unsigned>& lights);
+  /**
+   * \brief Traces the shadow ray from a hit point to a single point of a LightSource.
+   * 
+   * \param ray the Ray, that hit the scene at ip
+   * \param ip the hit point
+   * \param source index of the LightSource to sample
+   * \param target emitting point of the LightSource
+   * \param cache OccluderCache of the calling thread
+   * 
+   * \returns The light of target reflected at ip along ray, which is dark without tracing a shadow ray, if ip is out of range.
+   */
+  LightSample connect_light(const Ray& ray, const IntersectionPoint& ip, unsigned source, const Eigen::Vector4d& target, OccluderCache& cache) const;
+  /**
+   * \brief Traces the shadow rays from a hit point to a LightSource.
+   * 
+   * Point lights need a single shadow ray. Area lights are sampled at AREA_LIGHT_STRATA x AREA_LIGHT_STRATA jittered points
+   * of their area first. Only if some, but not all of them are occluded, i.e. in the penumbra, the area is refined to
+   * AREA_LIGHT_MAX_STRATA x AREA_LIGHT_MAX_STRATA strata, each holding one sample. The jitter is derived from the hit point,
+   * so every render gives the same image.
+   * 
+   * \param ray the Ray, that hit the scene at ip
+   * \param ip the hit point
+   * \param source index of the LightSource to sample
+   * \param cache OccluderCache of the calling thread
+   * 
+   * \returns The average light of the LightSource reflected at ip along ray.
+   */
+  LightSample sample_light(const Ray& ray, const IntersectionPoint& ip, unsigned source, OccluderCache& cache) const;
+  /**
+   * \brief Intersects the ray of task with the scene and shades the hit point by the given light sources.
+   * 
+   * Stores the hit point, the coefficients of the hit object, the refraction index behind the surface
+   * and the shaded LightIntensity in task.
+   * 
+   * \param task the task to shade
+   * \param lights indices of all LightSources, that can reach the hit point
+   * 
+   * \returns False, if the ray hits nothing.
+   */
+  bool shade(TraceTask& task, const std::vector<unsigned>& lights);
+  /**
+   * \brief Pushes a reflected or refracted ray of task onto stack, unless it is skipped.
+   * 
+   * \param stack stack of the tracing thread, with task on top
+   * \param task the task, whose hit point the secondary ray starts at
+   * \param coefficient reflected or refracted coefficient of the hit object
+   * \param secondary the reflected or refracted ray
+   * 
+   * \returns True, if the ray was pushed.
+   */
+  bool spawn(TraceStack& stack, TraceTask& task, const LightIntensity& coefficient, const Ray& secondary);
+
+  /**
+   * \brief Traces a single ray like the public trace_ray(), shading its own hit point only by the given lights.
+   * 
+   * Hit points of reflected and refracted rays are shaded by all #sources.
+   */
+  LightIntensity trace_ray(const Ray& ray, unsigned depth, const LightIntensity& weight, const std::vector<unsigned>& lights);
+
+  /**
+   * \brief Builds #light_grid for the next render.
+   * 
+   * If any LightSource has a finite range, the primary rays of every tile are intersected with the scene
+   * in parallel and the lights of the tile are culled to those reaching the hit points.
+   * Otherwise, every tile sees all #sources.
+   */
+  void cull_lights(unsigned threads);
+
+  /**
+   * \brief The Ray from the observer through the center of pixel (i, j) of the screen.
+   */
+  Ray primary_ray(unsigned i, unsigned j) const;
+  /**
+   * \brief The Ray from the observer through the point (dx, dy) inside of pixel (i, j) of the screen.
+   */
+  Ray primary_ray(unsigned i, unsigned j, float dx, float dy) const;
+  /**
+   * \brief The Ray from the observer through a PixelSample.
+   */
+  Ray primary_ray(const PixelSample& sample) const;
+  /**
+   * \brief Writes the LightIntensity of pixel (i, j) of the screen into the image.
+   */
+  void store_pixel(cv::Mat_<cv::Vec3b>& pixel_data, unsigned i, unsigned j, const LightIntensity& val) const;
+  /**
+   * \brief Writes the LightIntensity of every pixel of the screen, row by row, into the image in its memory order.
+   */
+  void store_image(cv::Mat_<cv::Vec3b>& pixel_data, const std::vector<LightIntensity>& values) const;
+  /**
+   * \brief Traces the primary ray of every sample according to options.mode.
+   * 
+   * \param samples points on the screen to trace
+   * \param values is filled with the LightIntensity perceived by every sample
+   * \param options how to trace the rays
+   */
+  void trace_samples(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values, const RenderOptions& options);
+  /**
+   * \brief Traces samples in RenderMode::PIXEL, i.e. calls trace_ray() for every sample.
+   * 
+   * If #pixel_costs is not empty, the work of every sample is recorded in the PixelCost of its pixel.
+   */
+  void trace_pixels(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values);
+  /**
+   * \brief The samples refining pixels with a high contrast to their neighbors.
+   * 
+   * Every pixel gets options.min_samples, pixels differing from one of their four neighbors by more than
+   * options.contrast_threshold in any color channel get options.max_samples. Both are rounded down to square numbers:
+   * n samples are placed on a jittered grid of \f$\sqrt{n} \times \sqrt{n}\f$ strata.
+   * The jitter only depends on the pixel, so every render gives the same image.
+   * 
+   * \param values the LightIntensity of the center of every pixel
+   * \param options the numbers of samples and the contrast threshold
+   * 
+   * \returns The samples of all pixels needing more than one, the samples of every pixel are consecutive.
+   */
+  std::vector<PixelSample> refinement_samples(const std::vector<LightIntensity>& values, const RenderOptions& options) const;
+  /**
+   * \brief Replaces the LightIntensity of every pixel in samples by the average of its samples.
+   * 
+   * \param samples samples from refinement_samples(), only containing complete pixels
+   * \param refined the traced LightIntensity of every sample
+   * \param values the LightIntensity of every pixel
+   */
+  void average_samples(const std::vector<PixelSample>& samples, const std::vector<LightIntensity>& refined, std::vector<LightIntensity>& values);
+  /**
+   * \brief Refines pixels with a high contrast to their neighbors by stratified supersampling.
+   * 
+   * \param values the LightIntensity of the center of every pixel, replaced by the average of its samples
+   * \param options how to choose and trace the additional samples
+   * 
+   * \sa refinement_samples()
+   */
+  void antialias(std::vector<LightIntensity>& values, const RenderOptions& options);
+  /**
+   * \brief Resets the reports, statistics, random generators and caches before rendering with options.
+   */
+  void begin_render(const RenderOptions& options);
+  /**
+   * \brief Collects the reports and statistics after rendering with options.
+   */
+  void end_render(const RenderOptions& options);
+
+  /**
+   * \brief Wavefront stage intersecting every ray of queue with the scene, in parallel.
+   * 
+   * Updates the Medium of every ray, that hits the scene.
+   */
+  void intersect_stage(std::vector<WavefrontRay>& queue, unsigned threads) const;
+  /**
+   * \brief Wavefront stage emitting a shadow ray from every hit point of queue to every LightSource into shadows,
+   * tracing all of them and shading the hit points, in parallel.
+   * 
+   * Hit points of primary rays are only connected to the LightSources of their tile in #light_grid.
+   * 
+   * \param queue hit points to shade
+   * \param shadows buffer for the shadow rays
+   * \param threads number of threads to use
+   * \param primaries the samples, whose primary rays form queue, nullptr for queues of secondary rays
+   */
+  void shadow_stage(std::vector<WavefrontRay>& queue, std::vector<ShadowRay>& shadows, unsigned threads, const std::vector<PixelSample>* primaries);
+  /**
+   * \brief Wavefront stage emitting the reflected and refracted rays of every hit point of queue into secondary.
+   * 
+   * Rays are pruned just like by trace_ray().
+   */
+  void secondary_stage(std::vector<WavefrontRay>& queue, std::vector<WavefrontRay>& secondary);
+  /**
+   * \brief Traces samples in RenderMode::WAVEFRONT.
+   * 
+   * The samples are processed in batches of options.batch_size. The primary rays of a batch form the first queue,
+   * whose secondary rays form the next one, and so on. Every queue is processed by intersect_stage(), shadow_stage()
+   * and secondary_stage(), before the next queue is started. Finally, the results are added up from the deepest queue upwards.
+   * If options.sort_secondary is set, every queue of secondary rays is sorted by sort_coherent() first.
+   * 
+   * Unlike trace_ray(), every ray path keeps track of its own Medium.
+   */
+  void trace_wavefront(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values, const RenderOptions& options);
+
 
   float dpi; //!< pixels per unit length in the final image
   float L_x; //!< size of the screen in x-direction (vertically)
@@ -104,8 +354,28 @@ private:
 
   unsigned max_recursion_depth;
 
+  float contribution_threshold; //!< reflected and refracted rays with a smaller weight in the pixel are skipped
+  float roulette_threshold; //!< reflected and refracted rays with a smaller weight in the pixel are terminated by russian roulette, 0 disables it
+  std::minstd_rand roulette_random; //!< random numbers for the russian roulette, reseeded for every render
+  PruningReport pruning_report; //!< secondary rays skipped during the last call of generate()
+
+  RenderOptions render_options; //!< how generate() renders the scene by default
+  unsigned light_samples; //!< RenderOptions::light_samples of the current render
+  std::minstd_rand light_random; //!< random numbers for choosing LightSources, reseeded for every render
+
+  std::unique_ptr<Arena> arena; //!< owns all LightSources and BaseObjects of the scene, including #objects
   std::vector<LightSource*> sources; //!< list of all LightSources in the scene
+  LightTree light_tree; //!< hierarchy over #sources, to choose the important ones for a point
+  LightGrid light_grid; //!< LightSources reaching every tile of the screen in the current render
+  OccluderCache occluder_cache; //!< occluders of the shadow rays traced by trace_ray()
+  OccluderReport occluder_report; //!< shadow rays tested during the last call of generate()
+  std::vector<unsigned> sample_counts; //!< number of samples of every pixel during the last call of generate(), row by row
+  unsigned long traced_samples = 0; //!< number of primary rays traced during the last call of generate()
+  RenderStats render_stats; //!< statistics of the last call of generate()
+  std::vector<PixelCost> pixel_costs; //!< work done for every pixel during the last call of generate(), row by row, empty if it was not recorded
   RootObject* objects; //!< The root of the scene. All interaction with the scenes objects goes through this.
+
+  OptimizerReport optimizer_report; //!< changes made to #objects by the optimizer while loading
   
 public:
   /**
@@ -119,21 +389,45 @@ public:
   
   /** 
    * \brief Base Constructor for Scene.
+   * 
+   * sources and objects have to be allocated in arena, which is taken over by the Scene.
+   * Reflected and refracted rays are pruned according to contribution_threshold and roulette_threshold.
+   * max_recursion_depth has to be smaller than TRACE_STACK_SIZE.
    */
   Scene(float dpi, float L_x, float L_y,
         Eigen::Vector4d position, Eigen::Vector4d observer,
         LightIntensity ambient_light, float global_index,
         unsigned max_recursion_depth,
-        std::vector<LightSource*> sources, RootObject* objects);
+        std::vector<LightSource*> sources, RootObject* objects,
+        std::unique_ptr<Arena> arena,
+        OptimizerReport optimizer_report = OptimizerReport(),
+        float contribution_threshold = CONTRIBUTION_THRESHOLD, float roulette_threshold = 0,
+        RenderOptions render_options = RenderOptions());
   /**
    * \brief Default Constructor for Scene.
    */
   Scene();
 
+  /**
+   * \brief A Scene can not be copied, as it is the only owner of its #arena.
+   */
+  Scene(const Scene&) = delete;
+  Scene& operator=(const Scene&) = delete;
+  /**
+   * \brief Move Constructor for Scene, taking over the #arena of other.
+   * 
+   * other must not be used anymore afterwards.
+   */
+  Scene(Scene&& other) = default;
+  /**
+   * \brief Move Assignment for Scene, taking over the #arena of other.
+   */
+  Scene& operator=(Scene&& other) = default;
+
   /**
    * \brief Destructor for the whole Scene
    * 
-   * Frees each LightSource in #sources and through #objects all BaseObjects in the scene.
+   * Frees all LightSources and BaseObjects at once, by freeing the blocks of #arena.
    */
   ~Scene();
 
@@ -146,12 +440,132 @@ public:
    * \returns The LightIntensity perceived by the ray.
    */
   LightIntensity trace_ray(const Ray& ray, unsigned depth);
+  /**
+   * \brief Traces a single ray in the Scene, that contributes to its pixel with a given weight.
+   * 
+   * Reflected and refracted rays are traced depth-first on a TraceStack of the calling thread instead of by recursion,
+   * so #max_recursion_depth has to be smaller than TRACE_STACK_SIZE.
+   * Their results are added to the ray they start from as soon as they are finished.
+   * 
+   * The weight is the product of all reflected and refracted coefficients along the path from the observer.
+   * Reflected and refracted rays, whose weight falls below #contribution_threshold, are not traced,
+   * as they can not change the pixel noticeably.
+   * 
+   * \param ray The Ray to trace.
+   * \param depth The current recursion depth. No more reflactions and refractions are calculated, when depth = #max_recursion_depth.
+   * \param weight The weight of ray in its pixel.
+   * 
+   * \returns The LightIntensity perceived by the ray.
+   */
+  LightIntensity trace_ray(const Ray& ray, unsigned depth, const LightIntensity& weight);
   /**
    * \brief Generates an image of the Scene.
    * 
-   * Traces Rays through every pixel of the screen.
+   * Traces Rays through every pixel of the screen, using the RenderOptions given when the Scene was constructed.
    * 
    * \returns An opencv matrix consisting of the generated image. Can be written into an actual image by cv::imwrite. 
    */
   cv::Mat_<cv::Vec3b> generate();
+  /**
+   * \brief Generates an image of the Scene with the given RenderOptions.
+   * 
+   * RenderMode::WAVEFRONT tracks the refraction index of every ray path separately, so scenes with refracting objects
+   * may differ slightly from RenderMode::PIXEL. Otherwise both modes give identical images.
+   * 
+   * \returns An opencv matrix consisting of the generated image. Can be written into an actual image by cv::imwrite. 
+   */
+  cv::Mat_<cv::Vec3b> generate(const RenderOptions& options);
+  /**
+   * \brief Generates the best image of the Scene, that can be rendered within options.time_budget.
+   * 
+   * The pixels are traced coarse to fine: the first pass traces every options.progressive_step-th pixel of every
+   * options.progressive_step-th row, every following pass halves the step, until all pixels are traced. Pixels, that are not
+   * traced yet, take the color of the nearest traced pixel above and left of them. Finally, the pixels are anti-aliased
+   * according to options.min_samples and options.max_samples.
+   * 
+   * Rendering stops between two chunks of PROGRESSIVE_CHUNK samples, as soon as the time budget is used up or
+   * options.coverage_target of the pixels are finished. The first pass is always completed, so every pixel has a color.
+   * Without a budget and target, the final image is the same as the one of generate() for scenes without randomness.
+   * 
+   * \param options how to render, options.time_budget = 0 means no time limit
+   * \param callback called with the current frame after every pass and when rendering stops
+   * 
+   * \returns The last frame.
+   */
+  ProgressiveFrame generate_progressive(const RenderOptions& options, const std::function<void(const ProgressiveFrame&)>& callback = {});
+  /**
+   * \brief Estimates the cost of generate(options) by tracing a sparse, stratified sample of its pixels.
+   * 
+   * The image is divided into square strata, so about fraction of the pixels, but at least ESTIMATE_MIN_STRATA are traced
+   * with full recursion in RenderMode::PIXEL. If anti-aliasing is enabled, the four neighbors of every sampled pixel are traced as well,
+   * so the fraction of refined pixels is estimated with the same contrast test as refinement_samples().
+   * The totals assume every anti-aliasing sample costs as much as the center of a pixel.
+   * 
+   * The reports and statistics of the last render are replaced by those of the sampled pixels.
+   * 
+   * \param options how the scene would be rendered
+   * \param fraction fraction of the pixels to sample
+   * 
+   * \returns The extrapolated rays, time and memory of the render with their confidence intervals.
+   */
+  RenderEstimate estimate(const RenderOptions& options, float fraction = ESTIMATE_FRACTION);
+
+  /**
+   * \brief Getter function for the RenderOptions used by generate().
+   */
+  const RenderOptions& options() const;
+  /**
+   * \brief Getter function for the changes made by the optimizer while loading the scene.
+   * 
+   * \sa RootObject::optimize()
+   */
+  const OptimizerReport& optimizations() const;
+  /**
+   * \brief Getter function for the secondary rays skipped during the last call of generate().
+   */
+  const PruningReport& pruning() const;
+  /**
+   * \brief Getter function for the shadow rays tested during the last call of generate(), and how often their cached occluder blocked them.
+   */
+  const OccluderReport& occluders() const;
+  /**
+   * \brief Getter function for the object tree of the scene, e.g. to look up its NodeProfiler counters after generate().
+   */
+  const RootObject& tree() const;
+  /**
+   * \brief Getter function for the number of primary rays traced during the last call of generate().
+   */
+  unsigned long primary_rays() const;
+  /**
+   * \brief Getter function for the statistics of the last call of generate() or generate_progressive().
+   */
+  const RenderStats& statistics() const;
+  /**
+   * \brief Getter function for the work done for every pixel during the last call of generate(), row by row.
+   * 
+   * Empty, unless RenderOptions::cost_map was set and the scene was rendered in RenderMode::PIXEL.
+   */
+  const std::vector<PixelCost>& costs() const;
+  /**
+   * \brief False color image of the seconds spent on every pixel during the last call of generate().
+   * 
+   * The colors go from black over blue, red and yellow to white. Pixels at or above the COST_MAP_PERCENTILE quantile
+   * are white, so a few pixels interrupted by the operating system do not darken the rest of the image.
+   * The image is black, if costs() is empty.
+   */
+  cv::Mat_<cv::Vec3b> cost_image() const;
+  /**
+   * \brief Writes costs() as raw float data into out.
+   * 
+   * The data starts with the text line "cost <rows> <columns> <PixelCost::channel_names>". It is followed by
+   * PixelCost::channels native 32 bit floats for every pixel, row by row from the top of the image,
+   * or by nothing, if costs() is empty.
+   */
+  void write_costs(std::ostream& out) const;
+  /**
+   * \brief Debug image of the number of samples of every pixel during the last call of generate().
+   * 
+   * Pixels with a single sample are black, the most sampled pixels are white.
+   */
+  cv::Mat_<cv::Vec3b> sample_image() const;
 };
\ No newline at end of file
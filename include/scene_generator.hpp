@@ -0,0 +1,55 @@
+#pragma once
+
+#include <random>
+#include <json.hpp>
+
+#include <scene.hpp>
+#include "defines.h"
+
+/**
+ * \class GeneratorOptions scene_generator.hpp
+ *
+ * \brief Parameters of a scene built by SceneGenerator.
+ */
+struct GeneratorOptions {
+  /** \brief Number of spheres. */
+  unsigned spheres = 8;
+  /** \brief Number of cylinders. */
+  unsigned cylinders = 2;
+  /** \brief Number of cubes. */
+  unsigned cubes = 4;
+  /** \brief Number of triforces. */
+  unsigned triforces = 1;
+  /** \brief Number of alternating subtractions and intersections with spheres around every object. */
+  unsigned csg_depth = 0;
+  /** \brief Number of rotations, scalings and translations above every object. */
+  unsigned transform_chain = 0;
+  /** \brief Number of point light sources. */
+  unsigned lights = 2;
+  /** \brief Recursion depth of reflected and refracted rays. */
+  unsigned recursion = 2;
+  /** \brief Pixels per unit of the 4 x 4 screen. */
+  unsigned dpi = 32;
+  /** \brief Seed of all random choices, equal options always give the same scene. */
+  unsigned seed = GENERATOR_SEED;
+};
+
+/**
+ * \class SceneGenerator scene_generator.hpp
+ *
+ * \brief Helper class to build random scenes of a given size, e.g. to measure how rendering scales.
+ *
+ * The objects are scattered in front of the screen, so most of them are visible.
+ * Every random choice is drawn from a generator seeded with GeneratorOptions::seed, so a scene is exactly reproducible.
+ */
+class SceneGenerator {
+public:
+  /**
+   * \brief Builds the description of a random scene, in the format of Scene::read_parameters().
+   */
+  static nlohmann::json describe(const GeneratorOptions& options);
+  /**
+   * \brief Builds a random Scene, the same as reading describe(options).
+   */
+  static Scene build(const GeneratorOptions& options);
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <memory_resource>
+#include <Dense>
+
+#include <bounds.hpp>
+#include <custom_exceptions.hpp>
+#include "defines.h"
+
+/**
+ * \brief Operations of a compiled SdfProgram.
+ */
+enum class SdfOpcode {
+  /** \brief Pushes the distance to a sphere. */
+  SPHERE,
+  /** \brief Pushes the distance to an axis-aligned box. */
+  BOX,
+  /** \brief Pushes the distance to a torus lying in the xy-plane. */
+  TORUS,
+  /** \brief Replaces the two topmost distances by their minimum. */
+  UNION,
+  /** \brief Replaces the two topmost distances by their maximum. */
+  INTERSECTION,
+  /** \brief Removes the topmost shape from the one below it. */
+  SUBTRACTION,
+  /** \brief Replaces the two topmost distances by their polynomial smooth minimum. */
+  SMOOTH_UNION,
+  /** \brief Pushes the current point moved by an offset. */
+  PUSH_TRANSLATION,
+  /** \brief Pushes the current point divided by a uniform factor. */
+  PUSH_SCALING,
+  /** \brief Pushes the current point folded into the center cell of a finite grid. */
+  PUSH_REPETITION,
+  /** \brief Pops the current point. */
+  POP_POINT,
+  /** \brief Pops the current point and multiplies the topmost distance by a uniform factor. */
+  POP_SCALING
+};
+
+/**
+ * \class SdfInstruction sdf.hpp
+ *
+ * \brief A single instruction of a compiled SdfProgram.
+ *
+ * The meaning of #vector and #scalars depends on #op, e.g. center and radius for a sphere.
+ */
+struct SdfInstruction {
+  /** \brief Operation to execute. */
+  SdfOpcode op;
+  /** \brief Center, half size, offset or spacing of the operation. */
+  Eigen::Vector3d vector;
+  /** \brief Radii, smoothing factor, scaling factor or repetition counts of the operation. */
+  Eigen::Vector3d scalars;
+};
+
+/**
+ * \class SdfProgram sdf.hpp
+ *
+ * \brief A signed distance function, compiled from an expression tree into a flat list of SdfInstruction.
+ *
+ * The program is built in post-order, i.e. the operands of a combination are emitted before
+ * the combination itself, and point transformations enclose the instructions of their subject:
+ * \code
+ * program.begin_translation(offset);
+ * program.sphere(center, 1);
+ * program.box(center, half_size);
+ * program.combine(SdfOpcode::SMOOTH_UNION, 0.25);
+ * program.end_translation();
+ * \endcode
+ *
+ * evaluate() runs the instructions on two fixed-size stacks of SDF_STACK_SIZE entries,
+ * so no memory is allocated while rendering.
+ * The bounds of the shape are computed alongside the instructions.
+ */
+class SdfProgram {
+private:
+  /**
+   * \brief The compiled instructions.
+   */
+  std::pmr::vector<SdfInstruction> instructions;
+  /**
+   * \brief Bounds of every distance, that is on the stack after the last emitted instruction.
+   */
+  std::pmr::vector<BoundingBox> bound_stack;
+  /**
+   * \brief Point transformations, that have been started, but not ended yet.
+   */
+  std::pmr::vector<SdfInstruction> open_transformations;
+  /**
+   * \brief Number of distances on the stack, when each of #open_transformations was started.
+   */
+  std::pmr::vector<unsigned> open_depths;
+
+  /**
+   * \brief Appends an instruction, pushing the bounds of a new distance.
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if the expression is nested too deep.
+   */
+  void push(const SdfInstruction& instruction, const BoundingBox& box);
+  /**
+   * \brief Appends an instruction, that modifies the point.
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if the expression is nested too deep.
+   */
+  void begin_transformation(const SdfInstruction& instruction);
+  /**
+   * \brief Ends the innermost point transformation.
+   *
+   * \returns The instruction, that started the transformation.
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if there is no open transformation or it encloses no shape.
+   */
+  SdfInstruction end_transformation(SdfOpcode expected);
+
+public:
+  /** \brief Allocator for the instructions. */
+  typedef std::pmr::polymorphic_allocator<SdfInstruction> allocator_type;
+
+  /**
+   * \brief Default Constructor for SdfProgram.
+   *
+   * Constructs an empty program, which is not complete().
+   */
+  SdfProgram(const allocator_type& allocator = allocator_type());
+  /**
+   * \brief Copy Constructor for SdfProgram.
+   */
+  SdfProgram(const SdfProgram& other) = default;
+  /**
+   * \brief Copy Constructor placing the copied instructions with allocator.
+   */
+  SdfProgram(const SdfProgram& other, const allocator_type& allocator);
+
+  /**
+   * \brief Emits a sphere.
+   */
+  void sphere(const Eigen::Vector3d& center, double radius);
+  /**
+   * \brief Emits an axis-aligned box.
+   *
+   * \param half_size distance of the faces to the center in every direction
+   */
+  void box(const Eigen::Vector3d& center, const Eigen::Vector3d& half_size);
+  /**
+   * \brief Emits a torus, that lies in the xy-plane.
+   *
+   * \param major_radius distance of the center of the tube to center
+   * \param minor_radius radius of the tube
+   */
+  void torus(const Eigen::Vector3d& center, double major_radius, double minor_radius);
+  /**
+   * \brief Combines the two last emitted shapes.
+   *
+   * \param op one of UNION, INTERSECTION, SUBTRACTION or SMOOTH_UNION
+   * \param smoothing size of the blended region for SMOOTH_UNION
+   *
+   * \throws Cpp_Raytracing_INVALID_INPUT if there are less than two shapes to combine or the smoothing is not positive.
+   */
+  void combine(SdfOpcode op, double smoothing = 0);
+
+  /**
+   * \brief Moves every shape emitted until the matching end_translation() by offset.
+   */
+  void begin_translation(const Eigen::Vector3d& offset);
+  /**
+   * \brief Ends the innermost translation.
+   */
+  void end_translation();
+  /**
+   * \brief Scales every shape emitted until the matching end_scaling() uniformly by factor.
+   */
+  void begin_scaling(double factor);
+  /**
+   * \brief Ends the innermost scaling.
+   */
+  void end_scaling();
+  /**
+   * \brief Repeats every shape emitted until the matching end_repetition() on a finite grid.
+   *
+   * The shape is copied count[i] times into both directions of every axis i, so it appears
+   * \f$\prod_i (2 count_i + 1)\f$ times.
+   * It should fit into a single cell of the grid, otherwise the distances are not exact.
+   *
+   * \param spacing distance of the copies along every axis
+   * \param count number of copies into each direction along every axis
+   */
+  void begin_repetition(const Eigen::Vector3d& spacing, const Eigen::Vector3i& count);
+  /**
+   * \brief Ends the innermost repetition.
+   */
+  void end_repetition();
+
+  /**
+   * \brief Checks if the program describes exactly one shape and every transformation is ended.
+   */
+  bool complete() const;
+  /**
+   * \brief Number of compiled instructions.
+   */
+  unsigned size() const;
+  /**
+   * \brief Bounds of the described shape.
+   *
+   * Only meaningful if the program is complete().
+   */
+  const BoundingBox& bounds() const;
+
+  /**
+   * \brief Evaluates the signed distance function.
+   *
+   * The program has to be complete().
+   *
+   * \param p point to evaluate at
+   *
+   * \returns The (approximate) distance of p to the surface. Negative distances are inside.
+   */
+  double evaluate(const Eigen::Vector3d& p) const;
+  /**
+   * \brief Normal of the surface near a point, estimated by finite differences.
+   *
+   * \param p point close to the surface
+   * \param h step size of the finite differences
+   *
+   * \returns The normalized gradient of the distance function at p.
+   */
+  Eigen::Vector3d gradient(const Eigen::Vector3d& p, double h) const;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <json.hpp>
+
+#include "defines.h"
+
+/**
+ * \class TimelineEvent timeline.hpp
+ *
+ * \brief A phase of loading or rendering, that ran on a single thread.
+ */
+struct TimelineEvent {
+  /** \brief Name of the phase, has to outlive the Timeline, e.g. a string literal. */
+  const char* name;
+  /** \brief Category of the phase, has to outlive the Timeline, e.g. a string literal. */
+  const char* category;
+  /** \brief Start in microseconds since Timeline::start(). */
+  double start;
+  /** \brief Duration in microseconds. */
+  double duration;
+  /** \brief Name of the optional argument, e.g. the index of a tile, nullptr if there is none. */
+  const char* arg_name;
+  /** \brief Value of the optional argument. */
+  long arg;
+};
+
+/**
+ * \class Timeline timeline.hpp
+ *
+ * \brief Records the phases of loading and rendering a scene on every thread, to be shown as a timeline
+ * in chrome://tracing or Perfetto.
+ *
+ * Every thread appends its events to its own buffer without locking. The buffers form a lock-free list and are
+ * reused by later threads, once their thread has ended, so the short-lived threads of parallel_for() show up
+ * as a few lanes of workers instead of one lane per thread.
+ *
+ * start(), stop() and write() must not be called while other threads record events. While the Timeline is
+ * stopped, recording an event costs a single relaxed atomic load.
+ */
+class Timeline {
+private:
+  /**
+   * \brief Events of a single thread at a time.
+   */
+  struct Buffer {
+    /** \brief Number of the lane, in the order the buffers were created. */
+    unsigned lane;
+    /** \brief If the buffer belongs to the thread, that called start(). */
+    bool main;
+    /** \brief If a running thread records into the buffer. */
+    std::atomic<bool> in_use;
+    /** \brief Recorded events, in the order they ended. */
+    std::vector<TimelineEvent> events;
+    /** \brief Next buffer of the list. */
+    Buffer* next;
+  };
+
+  /**
+   * \brief Buffer of the calling thread, returned to the list, when the thread ends.
+   */
+  struct LocalBuffer {
+    /** \brief The buffer, nullptr until the first event of the thread. */
+    Buffer* buffer = nullptr;
+    /** \brief Value of #generation, when #buffer was claimed. */
+    unsigned generation = 0;
+
+    /**
+     * \brief Releases the buffer for the next thread.
+     */
+    ~LocalBuffer();
+  };
+
+  /** \brief If events are recorded. */
+  static std::atomic<bool> active;
+  /** \brief Number of calls to start(), a LocalBuffer of an earlier generation points to a deleted buffer. */
+  static std::atomic<unsigned> generation;
+  /** \brief First buffer of the list of all buffers. */
+  static std::atomic<Buffer*> buffers;
+  /** \brief Number of buffers in the list. */
+  static std::atomic<unsigned> lanes;
+  /** \brief Time of the last call to start(). */
+  static std::chrono::steady_clock::time_point origin;
+  /** \brief Thread, that called start(). */
+  static std::thread::id main_thread;
+  /** \brief Buffer of the calling thread. */
+  static thread_local LocalBuffer local;
+
+  /**
+   * \brief Buffer of the calling thread, claiming a free one or adding a new one to the list on its first event.
+   */
+  static Buffer& buffer();
+
+public:
+  /**
+   * \brief Discards all recorded events and starts recording.
+   */
+  static void start();
+  /**
+   * \brief Stops recording, the recorded events are kept.
+   */
+  static void stop();
+  /**
+   * \brief If events are recorded.
+   */
+  static bool enabled() {
+    return active.load(std::memory_order_relaxed);
+  }
+  /**
+   * \brief Microseconds since start().
+   */
+  static double now();
+  /**
+   * \brief Records an event of the calling thread from start to end, in microseconds since start(), if the Timeline is enabled().
+   */
+  static void record(const char* name, const char* category, double start, double end, const char* arg_name = nullptr, long arg = 0);
+  /**
+   * \brief Number of events recorded since the last call to start().
+   */
+  static std::size_t size();
+
+  /**
+   * \brief All recorded events in the Chrome trace event format, every lane of events is a thread.
+   */
+  static nlohmann::json trace();
+  /**
+   * \brief Writes trace() into out.
+   */
+  static void write(std::ostream& out);
+};
+
+/**
+ * \class TimelineSpan timeline.hpp
+ *
+ * \brief Records the lifetime of the span as an event of the calling thread, if the Timeline is enabled() at its construction.
+ */
+class TimelineSpan {
+private:
+  /** \brief Name of the event. */
+  const char* name;
+  /** \brief Category of the event. */
+  const char* category;
+  /** \brief Name of the optional argument. */
+  const char* arg_name;
+  /** \brief Value of the optional argument. */
+  long arg;
+  /** \brief Start of the span, negative if nothing is recorded. */
+  double start;
+
+public:
+  /**
+   * \brief Starts the span of an event.
+   */
+  TimelineSpan(const char* name, const char* category, const char* arg_name = nullptr, long arg = 0):
+    name(name), category(category), arg_name(arg_name), arg(arg), start(Timeline::enabled() ? Timeline::now() : -1) {}
+
+  TimelineSpan(const TimelineSpan&) = delete;
+  TimelineSpan& operator=(const TimelineSpan&) = delete;
+
+  /**
+   * \brief Ends the span and records its event.
+   */
+  ~TimelineSpan() {
+    if (start >= 0) {
+      Timeline::record(name, category, start, Timeline::now(), arg_name, arg);
+    }
+  }
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <Dense>
+
+#include <light.hpp>
+#include <ray.hpp>
+#include <custom_exceptions.hpp>
+#include "defines.h"
+
+/**
+ * \class Medium trace.hpp
+ *
+ * \brief The objects a single ray path is inside of, identified by their refraction indices.
+ *
+ * Counts, how often every refraction index was entered and not yet left, in ascending order of the index.
+ * At most MEDIUM_DEPTH different indices are tracked, deeper nesting is ignored.
+ */
+class Medium {
+private:
+  /** \brief Refraction indices, that were entered, in ascending order. */
+  std::array<float, MEDIUM_DEPTH> indices;
+  /** \brief How often each of #indices was entered and not yet left. */
+  std::array<unsigned, MEDIUM_DEPTH> counts;
+  /** \brief Number of tracked indices. */
+  unsigned size;
+
+public:
+  /**
+   * \brief Constructs a Medium, that is inside of no object.
+   */
+  Medium();
+
+  /**
+   * \brief Enters an object.
+   *
+   * \param index refraction index of the entered object
+   *
+   * \returns The refraction index behind the surface, i.e. index.
+   */
+  float enter(float index);
+  /**
+   * \brief Leaves an object.
+   *
+   * \param index refraction index of the left object
+   * \param global_index refraction index outside of all objects
+   *
+   * \returns The refraction index behind the surface, i.e. the smallest index of an object, that was not left yet,
+   * or global_index.
+   */
+  float leave(float index, float global_index);
+};
+
+/**
+ * \class LightSample trace.hpp
+ *
+ * \brief Light of a single LightSource reflected at a hit point along a ray, after tracing the shadow ray.
+ *
+ * \sa Scene::sample_light()
+ */
+struct LightSample {
+  /** \brief False, if the LightSource is occluded from the hit point. */
+  bool lit = false;
+  /** \brief True, if the LightSource causes a specular highlight. */
+  bool highlighted = false;
+  /** \brief Diffusely reflected light by Lambert's Law. */
+  LightIntensity diffuse;
+  /** \brief Specularly reflected light, only valid if #highlighted. */
+  LightIntensity specular;
+};
+
+/**
+ * \brief Steps of tracing a single ray in a TraceTask.
+ */
+enum class TraceStage {
+  /** \brief The ray has to be intersected with the scene and shaded by the light sources. */
+  SHADE,
+  /** \brief The reflected ray has been traced or skipped, the refracted ray is next. */
+  REFRACT,
+  /** \brief All secondary rays have been traced or skipped, the value is final. */
+  FINISH
+};
+
+/**
+ * \class TraceTask trace.hpp
+ *
+ * \brief A ray waiting to be traced or waiting for its reflected and refracted rays.
+ *
+ * The task keeps everything needed to continue after a secondary ray is finished,
+ * i.e. the state of a single call of the former recursive Scene::trace_ray.
+ */
+struct TraceTask {
+  /** \brief The traced ray. */
+  Ray ray;
+  /** \brief Weight of #ray in its pixel, i.e. the product of all coefficients on its path. */
+  LightIntensity weight;
+  /** \brief Number of reflections and refractions on the path of #ray. */
+  unsigned depth;
+  /** \brief Next step to execute. */
+  TraceStage stage;
+
+  /** \brief Point, where #ray hits the scene. */
+  Eigen::Vector4d point;
+  /** \brief Normal of the scene at #point. */
+  Eigen::Vector4d normal;
+  /** \brief Reflected coefficient of the hit object. */
+  LightIntensity reflected;
+  /** \brief Refracted coefficient of the hit object. */
+  LightIntensity refracted;
+  /** \brief Refraction index of the medium behind #point. */
+  float index;
+
+  /** \brief LightIntensity perceived by #ray so far. */
+  LightIntensity value;
+  /** \brief Coefficient, by which the result of the currently traced secondary ray is added to #value. */
+  LightIntensity coefficient;
+
+  /**
+   * \brief Constructs a task, that still has to be shaded.
+   */
+  TraceTask(const Ray& ray, const LightIntensity& weight, unsigned depth);
+  /**
+   * \brief Default Constructor for TraceTask.
+   */
+  TraceTask();
+};
+
+/**
+ * \class TraceStack trace.hpp
+ *
+ * \brief Fixed-size stack of TraceTask's, replacing the call stack of a recursive ray tracer.
+ *
+ * The stack holds the path from a primary ray down to the currently traced ray,
+ * so TRACE_STACK_SIZE limits the recursion depth. No memory is allocated while tracing.
+ */
+class TraceStack {
+private:
+  /** \brief Storage of the tasks. */
+  std::array<TraceTask, TRACE_STACK_SIZE> tasks;
+  /** \brief Number of tasks on the stack. */
+  unsigned count;
+
+public:
+  /**
+   * \brief Constructs an empty stack.
+   */
+  TraceStack();
+
+  /**
+   * \brief Pushes a task on top of the stack.
+   *
+   * The stack must not be full.
+   */
+  void push(const TraceTask& task);
+  /**
+   * \brief Removes the topmost task.
+   */
+  void pop();
+  /**
+   * \brief The topmost task.
+   *
+   * References stay valid until the task is popped.
+   */
+  TraceTask& top();
+
+  /**
+   * \brief Checks if there are no tasks on the stack.
+   */
+  bool empty() const;
+  /**
+   * \brief Number of tasks on the stack.
+   */
+  unsigned size() const;
+};
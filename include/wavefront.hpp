@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <Dense>
+
+#include <objects.hpp>
+#include <light.hpp>
+#include <ray.hpp>
+#include <trace.hpp>
+#include <light_tree.hpp>
+#include "defines.h"
+
+/**
+ * \class WavefrontRay wavefront.hpp
+ *
+ * \brief A ray in a queue of the wavefront renderer, together with the results of every stage.
+ *
+ * \sa Scene::generate_wavefront()
+ */
+struct WavefrontRay {
+  /** \brief The traced ray. */
+  Ray ray;
+  /** \brief Weight of #ray in its pixel, i.e. the product of all coefficients on its path. */
+  LightIntensity weight;
+  /** \brief Index of the pixel for primary rays, index of the ray in the previous queue it starts from otherwise. */
+  unsigned parent;
+  /** \brief Coefficient, by which the result of #ray is added to its parent. */
+  LightIntensity coefficient;
+  /** \brief Objects the path of #ray is inside of, before #ray hits the scene. */
+  Medium medium;
+  /** \brief Position of #ray in its queue, before the queue was sorted. */
+  unsigned sequence;
+
+  /** \brief True, if #ray hits the scene. Set by the intersection stage. */
+  bool hit;
+  /** \brief The hit point of #ray, if #hit. */
+  IntersectionPoint ip;
+  /** \brief Refraction index of the medium behind #ip. */
+  float index;
+  /** \brief Index of the first shadow ray of #ip in the shadow queue, followed by the others of #ip. */
+  unsigned shadows;
+  /** \brief Number of shadow rays of #ip. */
+  unsigned lights;
+
+  /** \brief LightIntensity perceived by #ray so far. */
+  LightIntensity value;
+
+  /**
+   * \brief Constructs a ray, that still has to be intersected.
+   */
+  WavefrontRay(const Ray& ray, const LightIntensity& weight, unsigned parent, const LightIntensity& coefficient, const Medium& medium, unsigned sequence);
+};
+
+/**
+ * \brief Sort key of a ray, grouping rays with similar directions and start points.
+ *
+ * The octant of the direction forms the highest bits, followed by the Morton code (Z-order curve) of the start point
+ * quantized to a grid of \f$2^9\f$ cells along every axis of the box [min, max], giving 30 bits in total.
+ */
+unsigned coherence_key(const Ray& ray, const Eigen::Vector3d& min, const Eigen::Vector3d& max);
+
+/**
+ * \brief Bins rays by the highest COHERENCE_BIN_BITS of their coherence_key(), so that neighboring rays take similar paths through the scene.
+ *
+ * The bins are formed by a counting sort, keeping the order of rays within a bin.
+ * Keeps the WavefrontRay::sequence of every ray, so the original order can be restored.
+ *
+ * \param queue rays to sort
+ * \param scratch buffer for the sorted rays, swapped with queue, so it can be reused for the next call
+ */
+void sort_coherent(std::vector<WavefrontRay>& queue, std::vector<WavefrontRay>& scratch);
+
+/**
+ * \class ShadowRay wavefront.hpp
+ *
+ * \brief A connection from a hit point to a LightSource in the shadow queue of the wavefront renderer.
+ */
+struct ShadowRay {
+  /** \brief Index of the WavefrontRay, whose hit point is connected. */
+  unsigned ray;
+  /** \brief The connected LightSource and its weight. */
+  LightChoice light;
+  /** \brief Result of the shadow stage. */
+  LightSample sample;
+};
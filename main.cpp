@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -27,6 +28,12 @@ int main() {
 
   std::string final_path = std::string() + "../" + file_path;
 
+  // the phases of loading and rendering are only recorded on request
+  const char* timeline_path = std::getenv("CPP_RAYTRACING_TIMELINE");
+  if (timeline_path != nullptr) {
+    Timeline::start();
+  }
+
   std::ifstream inp;
   inp.open(final_path, std::ios::in);
 
@@ -39,8 +46,15 @@ int main() {
 
   Scene scene = Scene::read_parameters(inp);
 
-  std::cout << "\nThe scene was loaded successfully.\nDepending on size and resolution, the rendering may"
-  " take a while.\n\nDo you want to continue? (y/N): " << std::flush;
+  if (scene.optimizations().changed()) {
+    std::cout << "\nThe scene was simplified while loading:\n" << scene.optimizations() << std::endl;
+  }
+
+  std::cout << "\nThe scene was loaded successfully. Estimating the cost of rendering it from a sample of its pixels:" << std::endl;
+  RenderEstimate estimate = scene.estimate(scene.options());
+  std::cout << estimate << std::endl;
+
+  std::cout << "\nDepending on size and resolution, the rendering may take a while.\n\nDo you want to continue? (y/N): " << std::flush;
 
   char answ;
   std::cin >> answ;
@@ -54,9 +68,75 @@ int main() {
 
   std::cout << "\nStarting rendering process" << std::endl;
 
-  cv::Mat_<cv::Vec3b> img = scene.generate();
+  cv::Mat_<cv::Vec3b> img;
+
+  if (scene.options().progressive()) {
+    ProgressiveFrame frame = scene.generate_progressive(scene.options());
+    img = frame.image;
+
+    cv::imwrite("coverage.png", frame.coverage);
+    std::cout << "\nAfter " << frame.elapsed << "s and " << frame.passes << " passes, " << int(frame.finished * 100) << "% of the pixels are finished."
+    " The traced pixels can be found as \"coverage.png\" in your build directory." << std::endl;
+  }
+  else {
+    img = scene.generate();
+  }
+
+  {
+    TimelineSpan span("encode", "output");
+    cv::imwrite("output.png", img);
+  }
 
-  cv::imwrite("output.png", img);
+  if (scene.options().max_samples > 1) {
+    cv::imwrite("samples.png", scene.sample_image());
+    std::cout << "\nThe number of samples per pixel can be found as \"samples.png\" in your build directory." << std::endl;
+  }
+
+  if (not scene.costs().empty()) {
+    cv::imwrite("cost.png", scene.cost_image());
+    std::ofstream costs("cost.raw", std::ios::binary);
+    scene.write_costs(costs);
+    std::cout << "\nThe time spent on every pixel can be found as \"cost.png\" in your build directory,"
+    " the rays and CSG tests of every pixel as raw float data in \"cost.raw\"." << std::endl;
+  }
+
+  if (scene.pruning().pruned() > 0) {
+    std::cout << "\nSecondary rays were skipped, because they could not change the image noticeably:\n" << scene.pruning() << std::endl;
+  }
+
+  #ifdef PROFILE_NODES
+    std::ofstream("profile.json") << NodeProfiler::tree(scene.tree()).dump(2) << std::endl;
+    std::cout << "\nThe most expensive nodes of the object tree, the full tree can be found as \"profile.json\" in your build directory:\n";
+    NodeProfiler::print_top(std::cout, scene.tree(), 10);
+  #endif
+
+  if (scene.occluders().cached_tests > 0) {
+    std::cout << "\nShadow rays were tested against the last object blocking their light first:\n" << scene.occluders() << std::endl;
+  }
+
+  std::cout << "\nStatistics of the render:\n" << scene.statistics() << std::endl;
+
+  // the statistics are written as JSON or in the Prometheus text format, depending on the file extension
+  const char* statistics_path = std::getenv("CPP_RAYTRACING_STATISTICS");
+  if (statistics_path != nullptr) {
+    std::string path = statistics_path;
+    std::ofstream statistics(path);
+
+    if (path.size() >= 5 and path.compare(path.size() - 5, 5, ".json") == 0) {
+      statistics << scene.statistics().json().dump(2) << std::endl;
+    }
+    else {
+      scene.statistics().write_prometheus(statistics, file_path);
+    }
+    std::cout << "\nThe statistics can be found as \"" << path << "\"." << std::endl;
+  }
+
+  if (timeline_path != nullptr) {
+    Timeline::stop();
+    std::ofstream timeline(timeline_path);
+    Timeline::write(timeline);
+    std::cout << "\nThe timeline of loading and rendering can be found as \"" << timeline_path << "\", open it in chrome://tracing or ui.perfetto.dev." << std::endl;
+  }
 
   std::cout << "\nRendering was successfull. The final image can be found as \"output.png\" in your build directory."
   << std::endl;
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <new>
+
+#include <arena.hpp>
+
+/**
+ * \brief Space reserved for the header of a block, so the usable memory stays maximally aligned.
+ */
+static constexpr std::size_t header_size = alignof(std::max_align_t) > sizeof(void*) ? alignof(std::max_align_t) : sizeof(void*);
+
+
+Arena::Arena(std::size_t block_size):
+  blocks(nullptr), cursor(nullptr), end(nullptr), block_size(block_size), used_bytes(0), num_blocks(0) {}
+
+Arena::~Arena() {
+  #ifdef DEBUG
+    std::cout << "Destructing Arena at " << this << " with " << num_blocks << " blocks" << std::endl;
+  #endif
+
+  while (blocks != nullptr) {
+    Block* next = blocks->next;
+    std::free(blocks);
+    blocks = next;
+  }
+}
+
+char* Arena::new_block(std::size_t size) {
+  Block* block = (Block*) std::malloc(header_size + size);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  block->next = blocks;
+  blocks = block;
+  num_blocks++;
+
+  return (char*) block + header_size;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  std::size_t padding = (alignment - (std::size_t) cursor % alignment) % alignment;
+
+  if (cursor == nullptr or padding + bytes > (std::size_t) (end - cursor)) {
+    if (bytes + alignment > block_size / 4) { // large requests get a block of their own, keeping the current one
+      char* memory = new_block(bytes + alignment);
+      used_bytes += bytes;
+
+      return memory + (alignment - (std::size_t) memory % alignment) % alignment;
+    }
+
+    cursor = new_block(block_size);
+    end = cursor + block_size;
+    padding = (alignment - (std::size_t) cursor % alignment) % alignment;
+  }
+
+  void* memory = cursor + padding;
+  cursor += padding + bytes;
+  used_bytes += padding + bytes;
+
+  return memory;
+}
+
+void Arena::do_deallocate(void*, std::size_t, std::size_t) {}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+std::size_t Arena::used() const {
+  return used_bytes;
+}
+
+unsigned Arena::block_count() const {
+  return num_blocks;
+}
@@ -0,0 +1,118 @@
+#include <bounds.hpp>
+
+BoundingBox::BoundingBox(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner): min_corner(min_corner), max_corner(max_corner) {}
+
+BoundingBox::BoundingBox():
+  BoundingBox(Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity()), Eigen::Vector3d::Constant(- std::numeric_limits<double>::infinity()))
+  {}
+
+BoundingBox BoundingBox::infinite() {
+  return BoundingBox(Eigen::Vector3d::Constant(- std::numeric_limits<double>::infinity()), Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity()));
+}
+
+const Eigen::Vector3d& BoundingBox::min() const {
+  return min_corner;
+}
+
+const Eigen::Vector3d& BoundingBox::max() const {
+  return max_corner;
+}
+
+bool BoundingBox::empty() const {
+  return (min_corner.array() > max_corner.array()).any();
+}
+
+bool BoundingBox::finite() const {
+  return min_corner.allFinite() and max_corner.allFinite();
+}
+
+double BoundingBox::volume() const {
+  if (empty()) {
+    return 0;
+  }
+
+  Eigen::Vector3d extent = max_corner - min_corner;
+  if (extent.minCoeff() == 0) { // flat boxes have no volume, even if unbounded in another direction
+    return 0;
+  }
+
+  return extent.prod();
+}
+
+BoundingBox BoundingBox::merged(const BoundingBox& other) const {
+  if (empty()) return other;
+  if (other.empty()) return *this;
+
+  return BoundingBox(min_corner.cwiseMin(other.min_corner), max_corner.cwiseMax(other.max_corner));
+}
+
+BoundingBox BoundingBox::intersected(const BoundingBox& other) const {
+  return BoundingBox(min_corner.cwiseMax(other.min_corner), max_corner.cwiseMin(other.max_corner));
+}
+
+BoundingBox BoundingBox::transformed(const Eigen::Transform<double, 3, Eigen::Projective>& transformation) const {
+  if (empty()) {
+    return BoundingBox();
+  }
+
+  const Eigen::Matrix4d& M = transformation.matrix();
+  Eigen::Vector3d new_min = M.block<3, 1>(0, 3);
+  Eigen::Vector3d new_max = M.block<3, 1>(0, 3);
+
+  for (unsigned i = 0; i < 3; i++) {
+    for (unsigned j = 0; j < 3; j++) {
+      // zero coefficients are skipped, as 0 * inf is not defined
+      if (M(i, j) > 0) {
+        new_min[i] += M(i, j) * min_corner[j];
+        new_max[i] += M(i, j) * max_corner[j];
+      }
+      else if (M(i, j) < 0) {
+        new_min[i] += M(i, j) * max_corner[j];
+        new_max[i] += M(i, j) * min_corner[j];
+      }
+    }
+  }
+
+  return BoundingBox(new_min, new_max);
+}
+
+bool BoundingBox::clip(const Ray& r, double& t_near, double& t_far) const {
+  t_near = 0;
+  t_far = std::numeric_limits<double>::infinity();
+
+  if (empty()) {
+    return false;
+  }
+
+  for (unsigned i = 0; i < 3; i++) {
+    double S = r.start_point()[i];
+    double d = r.direction()[i];
+
+    if (d == 0) { // parallel to the slab
+      if (S < min_corner[i] or S > max_corner[i]) return false;
+      continue;
+    }
+
+    double t0 = (min_corner[i] - S) / d;
+    double t1 = (max_corner[i] - S) / d;
+    if (t0 > t1) std::swap(t0, t1);
+
+    t_near = std::max(t_near, t0);
+    t_far = std::min(t_far, t1);
+  }
+
+  return t_near <= t_far;
+}
+
+double BoundingBox::squared_distance(const Eigen::Vector3d& p) const {
+  Eigen::Vector3d below = (min_corner - p).cwiseMax(0);
+  Eigen::Vector3d above = (p - max_corner).cwiseMax(0);
+
+  return (below + above).squaredNorm();
+}
+
+std::ostream& operator<<(std::ostream& out, const BoundingBox& box) {
+  out << "[" << box.min_corner.transpose() << "] - [" << box.max_corner.transpose() << "]";
+
+  return out;
+}
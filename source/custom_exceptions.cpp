@@ -17,3 +17,21 @@ Cpp_Raytracing_ASSERTION_FAILED::~Cpp_Raytracing_ASSERTION_FAILED() {
 const char* Cpp_Raytracing_ASSERTION_FAILED::what() const noexcept {  
   return info;
 }
+
+
+Cpp_Raytracing_INVALID_INPUT::Cpp_Raytracing_INVALID_INPUT(const char* reason) {
+  info = (char*) malloc((24 + strlen(reason)) * sizeof(char));
+  snprintf(info, (24 + strlen(reason)) * sizeof(char), "ERROR : INVALID INPUT %s", reason);
+}
+
+Cpp_Raytracing_INVALID_INPUT::Cpp_Raytracing_INVALID_INPUT(const Cpp_Raytracing_INVALID_INPUT& other) {
+  info = strdup(other.info);
+}
+
+Cpp_Raytracing_INVALID_INPUT::~Cpp_Raytracing_INVALID_INPUT() {
+  free(info);
+}
+
+const char* Cpp_Raytracing_INVALID_INPUT::what() const noexcept {  
+  return info;
+}
\ No newline at end of file
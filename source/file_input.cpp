@@ -4,12 +4,13 @@ using json = nlohmann::json;
 
 const std::map<std::string, Scene::action_t> Scene::action_handler = {
   {"sphere", &Scene::read_sphere},              {"halfSpace", &Scene::read_half_space},
-  {"cylinder", &Scene::read_cylinder},          {"scaling", &Scene::read_scaling},            
-  {"rotation", &Scene::read_rotation},          {"translation", &Scene::read_translation},    
-  {"union", &Scene::read_union},                {"intersection", &Scene::read_intersection},
-  {"exclusion", &Scene::read_exclusion},        {"subtraction", &Scene::read_subtraction},
-  {"cube", &Scene::read_cube},                  {"prism", &Scene::read_prism},
-  {"triforce", &Scene::read_triforce}
+  {"cylinder", &Scene::read_cylinder},          {"quadric", &Scene::read_quadric},
+  {"scaling", &Scene::read_scaling},            {"rotation", &Scene::read_rotation},
+  {"translation", &Scene::read_translation},    {"union", &Scene::read_union},
+  {"intersection", &Scene::read_intersection},  {"exclusion", &Scene::read_exclusion},
+  {"subtraction", &Scene::read_subtraction},    {"cube", &Scene::read_cube},
+  {"prism", &Scene::read_prism},                {"triforce", &Scene::read_triforce},
+  {"sdf", &Scene::read_sdf}
 };
 
 const std::array<Scene::rotation_t, 3> Scene::rotation_handler = {
@@ -18,6 +19,58 @@ const std::array<Scene::rotation_t, 3> Scene::rotation_handler = {
   &Transformation::Rotation_Z
 };
 
+const std::map<std::string, Scene::quadric_t> Scene::quadric_handler = {
+  {"sphere", &Quadric::UnitSphere},             {"cylinder", &Quadric::UnitCylinder},
+  {"cone", &Quadric::UnitCone},                 {"paraboloid", &Quadric::UnitParaboloid}
+};
+
+static Eigen::Vector3d read_sdf_vector(nlohmann::json& descr) {
+  std::array<double, 3> raw = descr;
+
+  return Eigen::Vector3d(raw[0], raw[1], raw[2]);
+}
+
+const std::map<std::string, Scene::sdf_action_t> Scene::sdf_handler = {
+  {"sphere", [](json& descr, SdfProgram& program) {
+    program.sphere(read_sdf_vector(descr.at("position")), descr.at("radius"));
+  }},
+  {"box", [](json& descr, SdfProgram& program) {
+    program.box(read_sdf_vector(descr.at("position")), read_sdf_vector(descr.at("size")) / 2);
+  }},
+  {"torus", [](json& descr, SdfProgram& program) {
+    program.torus(read_sdf_vector(descr.at("position")), descr.at("radius"), descr.at("thickness"));
+  }},
+  {"union", [](json& descr, SdfProgram& program) {
+    read_sdf_combination(descr, program, SdfOpcode::UNION);
+  }},
+  {"intersection", [](json& descr, SdfProgram& program) {
+    read_sdf_combination(descr, program, SdfOpcode::INTERSECTION);
+  }},
+  {"subtraction", [](json& descr, SdfProgram& program) {
+    read_sdf_combination(descr, program, SdfOpcode::SUBTRACTION);
+  }},
+  {"smoothUnion", [](json& descr, SdfProgram& program) {
+    read_sdf_combination(descr, program, SdfOpcode::SMOOTH_UNION, descr.at("smoothing"));
+  }},
+  {"translation", [](json& descr, SdfProgram& program) {
+    program.begin_translation(read_sdf_vector(descr.at("factors")));
+    read_sdf_expression(descr.at("subject"), program);
+    program.end_translation();
+  }},
+  {"scaling", [](json& descr, SdfProgram& program) {
+    program.begin_scaling(descr.at("factor"));
+    read_sdf_expression(descr.at("subject"), program);
+    program.end_scaling();
+  }},
+  {"repetition", [](json& descr, SdfProgram& program) {
+    std::array<int, 3> count = descr.at("count");
+
+    program.begin_repetition(read_sdf_vector(descr.at("spacing")), Eigen::Vector3i(count[0], count[1], count[2]));
+    read_sdf_expression(descr.at("subject"), program);
+    program.end_repetition();
+  }}
+};
+
 const std::map<std::string, LightIntensity> Scene::color_handler = {
   {"black", LightIntensity::black()},           {"silver", LightIntensity::silver()},
   {"gray", LightIntensity::gray()},             {"white", LightIntensity::white()},
@@ -45,13 +98,41 @@ LightIntensity Scene::read_color(nlohmann::json& descr) {
   }
 }
 
-LightSource* Scene::read_source(nlohmann::json& descr) {
+LightSource* Scene::read_source(nlohmann::json& descr, Arena& arena) {
   std::array<double, 3> raw_pos = descr.at("position");
   LightIntensity intensity = read_color(descr.at("intensity"));
 
+  double radius = descr.value("radius", std::numeric_limits<double>::infinity());
+
+  if (radius <= 0) {
+    throw Cpp_Raytracing_INVALID_INPUT("light source radius has to be positive");
+  }
+
   Eigen::Vector3d pos(raw_pos[0], raw_pos[1], raw_pos[2]);
 
-  LightSource* source = new LightSource(pos, intensity);
+  if (descr.contains("sphere")) {
+    double sphere_radius = descr.at("sphere");
+
+    if (sphere_radius <= 0) {
+      throw Cpp_Raytracing_INVALID_INPUT("spherical light source radius has to be positive");
+    }
+
+    return LightSource::Sphere(arena, pos, sphere_radius, intensity, radius);
+  }
+
+  if (descr.contains("rectangle")) {
+    std::array<std::array<double, 3>, 2> raw_edges = descr.at("rectangle");
+    Eigen::Vector3d edge_u(raw_edges[0][0], raw_edges[0][1], raw_edges[0][2]);
+    Eigen::Vector3d edge_v(raw_edges[1][0], raw_edges[1][1], raw_edges[1][2]);
+
+    if (edge_u.cross(edge_v).norm() <= EPSILON) {
+      throw Cpp_Raytracing_INVALID_INPUT("rectangular light source needs two edges, that are not parallel");
+    }
+
+    return LightSource::Rectangle(arena, pos, edge_u, edge_v, intensity, radius);
+  }
+
+  LightSource* source = arena.create<LightSource>(pos, intensity, radius);
 
   return source;
 }
@@ -68,11 +149,11 @@ ColData Scene::read_col_data(nlohmann::json& descr) {
   return ColData(amb, diff, spec, refl, refr, shiny);
 }
 
-std::vector<BaseObject*> Scene::read_obj_list(nlohmann::json& descr) {
+std::vector<BaseObject*> Scene::read_obj_list(nlohmann::json& descr, Arena& arena) {
   std::vector<BaseObject*> objects;
 
   for (auto [_, j] : descr.items()) {
-    BaseObject* obj = action_handler.at(j.begin().key())(j.begin().value());
+    BaseObject* obj = action_handler.at(j.begin().key())(j.begin().value(), arena);
     objects.push_back(obj);
   }
 
@@ -80,51 +161,51 @@ std::vector<BaseObject*> Scene::read_obj_list(nlohmann::json& descr) {
 }
 
 
-BaseObject* Scene::read_sphere(nlohmann::json& descr) {
+BaseObject* Scene::read_sphere(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
-  BaseObject* obj = new Sphere(col, ind);
+  BaseObject* obj = Quadric::UnitSphere(arena, col, ind);
 
   double rad = descr.at("radius");
   if (rad != 1.0) {
-    obj = Transformation::Scaling(obj, rad, rad, rad);
+    obj = Transformation::Scaling(arena, obj, rad, rad, rad);
   }
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
-BaseObject* Scene::read_half_space(nlohmann::json& descr) {
+BaseObject* Scene::read_half_space(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
   std::array<double, 3> normal_arr = descr.at("normal");
   Eigen::Vector4d normal(normal_arr[0], normal_arr[1], normal_arr[2], 0);
 
-  BaseObject* obj = new HalfSpace(col, ind, normal);
+  BaseObject* obj = arena.create<HalfSpace>(col, ind, normal);
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
-BaseObject* Scene::read_cylinder(nlohmann::json& descr) {
+BaseObject* Scene::read_cylinder(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
-  BaseObject* obj = new Cylinder(col, ind);
+  BaseObject* obj = Quadric::UnitCylinder(arena, col, ind);
 
   double rad = descr.at("radius");
   if (rad != 1.0) {
-    obj = Transformation::Scaling(obj, rad, rad, 1);
+    obj = Transformation::Scaling(arena, obj, rad, rad, 1);
   }
 
   std::array<double, 3> axis_arr = descr.at("axis");
@@ -134,133 +215,191 @@ BaseObject* Scene::read_cylinder(nlohmann::json& descr) {
     double alpha = asinf64(- axis[1]);
     double beta = asinf64(axis[0] / cosf64(alpha));
 
-    obj = Transformation::Rotation_X(obj, alpha);
-    obj = Transformation::Rotation_Y(obj, beta);
+    obj = Transformation::Rotation_X(arena, obj, alpha);
+    obj = Transformation::Rotation_Y(arena, obj, beta);
   }
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
-BaseObject* Scene::read_scaling(nlohmann::json& descr) {
+BaseObject* Scene::read_quadric(nlohmann::json& descr, Arena& arena) {
+  ColData col = read_col_data(descr.at("color"));
+  float ind = descr.at("index");
+
+  if (descr.contains("shape")) {
+    return quadric_handler.at(descr.at("shape"))(arena, col, ind);
+  }
+
+  std::array<std::array<double, 4>, 4> raw_coeff = descr.at("coefficients");
+  Eigen::Matrix4d coeff;
+  for (unsigned i = 0; i < 4; i++) {
+    for (unsigned j = 0; j < 4; j++) {
+      coeff(i, j) = raw_coeff[i][j];
+    }
+  }
+
+  return arena.create<Quadric>(col, ind, coeff);
+}
+
+BaseObject* Scene::read_sdf(nlohmann::json& descr, Arena& arena) {
+  ColData col = read_col_data(descr.at("color"));
+  float ind = descr.at("index");
+
+  SdfProgram program;
+  read_sdf_expression(descr.at("shape"), program);
+
+  double lipschitz = descr.value("lipschitz", 1.0);
+  unsigned iterations = descr.value("iterations", SDF_MAX_ITERATIONS);
+
+  return arena.create<DistanceField>(col, ind, program, lipschitz, iterations);
+}
+
+void Scene::read_sdf_expression(nlohmann::json& descr, SdfProgram& program) {
+  auto j = descr.begin();
+  sdf_handler.at(j.key())(j.value(), program);
+}
+
+void Scene::read_sdf_combination(nlohmann::json& descr, SdfProgram& program, SdfOpcode op, double smoothing) {
+  bool first = true;
+
+  for (auto [_, j] : descr.at("objects").items()) {
+    read_sdf_expression(j, program);
+
+    if (not first) {
+      program.combine(op, smoothing);
+    }
+    first = false;
+  }
+
+  if (first) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field combination without objects");
+  }
+}
+
+BaseObject* Scene::read_scaling(nlohmann::json& descr, Arena& arena) {
   std::array<double, 3> fac = descr.at("factors");
 
   auto j = descr.at("subject").begin();
-  BaseObject* subj = action_handler.at(j.key())(j.value());
+  BaseObject* subj = action_handler.at(j.key())(j.value(), arena);
 
-  BaseObject* obj = Transformation::Scaling(subj, fac[0], fac[1], fac[2]);
+  BaseObject* obj = Transformation::Scaling(arena, subj, fac[0], fac[1], fac[2]);
 
   return obj;
 }
 
-BaseObject* Scene::read_rotation(nlohmann::json& descr) {
+BaseObject* Scene::read_rotation(nlohmann::json& descr, Arena& arena) {
   double ang = descr.at("angle").get<double>() / 180.0 * M_PI;
   unsigned dir = descr.at("direction");
 
   auto j = descr.at("subject").begin();
-  BaseObject* subj = action_handler.at(j.key())(j.value());
+  BaseObject* subj = action_handler.at(j.key())(j.value(), arena);
 
-  BaseObject* obj = rotation_handler.at(dir)(subj, ang);
+  BaseObject* obj = rotation_handler.at(dir)(arena, subj, ang);
 
   return obj;
 }
 
-BaseObject* Scene::read_translation(nlohmann::json& descr) {
+BaseObject* Scene::read_translation(nlohmann::json& descr, Arena& arena) {
   std::array<double, 3> fac = descr.at("factors");
 
   auto j = descr.at("subject").begin();
-  BaseObject* subj = action_handler.at(j.key())(j.value());
+  BaseObject* subj = action_handler.at(j.key())(j.value(), arena);
 
-  BaseObject* obj = Transformation::Translation(subj, fac[0], fac[1], fac[2]);
+  BaseObject* obj = Transformation::Translation(arena, subj, fac[0], fac[1], fac[2]);
 
   return obj;
 }
 
-BaseObject* Scene::read_union(nlohmann::json& descr) {
-  std::vector<BaseObject*> subj = read_obj_list(descr);
+BaseObject* Scene::read_union(nlohmann::json& descr, Arena& arena) {
+  std::vector<BaseObject*> subj = read_obj_list(descr, arena);
 
-  BaseObject* obj = new Union(subj);
+  BaseObject* obj = arena.create<Union>(subj);
 
   return obj;
 }
 
-BaseObject* Scene::read_intersection(nlohmann::json& descr) {
-  std::vector<BaseObject*> subj = read_obj_list(descr);
+BaseObject* Scene::read_intersection(nlohmann::json& descr, Arena& arena) {
+  std::vector<BaseObject*> subj = read_obj_list(descr, arena);
 
-  BaseObject* obj = new Intersection(subj);
+  BaseObject* obj = arena.create<Intersection>(subj);
 
   return obj;
 }
 
-BaseObject* Scene::read_exclusion(nlohmann::json& descr) {
-  std::vector<BaseObject*> subj = read_obj_list(descr);
+BaseObject* Scene::read_exclusion(nlohmann::json& descr, Arena& arena) {
+  std::vector<BaseObject*> subj = read_obj_list(descr, arena);
 
-  BaseObject* obj = new Exclusion(subj);
+  BaseObject* obj = arena.create<Exclusion>(subj);
 
   return obj;
 }
 
-BaseObject* Scene::read_subtraction(nlohmann::json& descr) {
-  std::vector<BaseObject*> subj = read_obj_list(descr);
+BaseObject* Scene::read_subtraction(nlohmann::json& descr, Arena& arena) {
+  std::vector<BaseObject*> subj = read_obj_list(descr, arena);
 
-  BaseObject* obj = new Subtraction(subj);
+  BaseObject* obj = arena.create<Subtraction>(subj);
 
   return obj;
 }
 
-BaseObject* Scene::read_cube(nlohmann::json& descr) {
+BaseObject* Scene::read_cube(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
-  BaseObject* obj = Composites::Cube(col, ind);
+  BaseObject* obj = Composites::Cube(arena, col, ind);
 
   std::array<double, 3> dim = descr.at("dimensions");
   if (dim[0] != 0 or dim[1] != 0 or dim[2] != 0) {
-    obj = Transformation::Scaling(obj, dim[0], dim[1], dim[2]);
+    obj = Transformation::Scaling(arena, obj, dim[0], dim[1], dim[2]);
   }
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
-BaseObject* Scene::read_prism(nlohmann::json& descr) {
+BaseObject* Scene::read_prism(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
-  BaseObject* obj = Composites::Prism(col, ind);
+  BaseObject* obj = Composites::Prism(arena, col, ind);
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
-BaseObject* Scene::read_triforce(nlohmann::json& descr) {
+BaseObject* Scene::read_triforce(nlohmann::json& descr, Arena& arena) {
   ColData col = read_col_data(descr.at("color"));
   float ind = descr.at("index");
 
-  BaseObject* obj = Composites::Triforce(col, ind);
+  BaseObject* obj = Composites::Triforce(arena, col, ind);
 
   std::array<double, 3> pos = descr.at("position");
   if (pos[0] != 0 or pos[1] != 0 or pos[2] != 0) {
-    obj = Transformation::Translation(obj, pos[0], pos[1], pos[2]);
+    obj = Transformation::Translation(arena, obj, pos[0], pos[1], pos[2]);
   }
 
   return obj;
 }
 
 Scene Scene::read_parameters(std::istream& input) {
-  json data = json::parse(input);
+  json data;
+  {
+    TimelineSpan span("parse", "load");
+    data = json::parse(input);
+  }
 
   json screen_info = data.at("screen");
   float dpi = screen_info.at("dpi");
@@ -272,18 +411,93 @@ Scene Scene::read_parameters(std::istream& input) {
   LightIntensity amb = read_color(medium_info.at("ambient"));
   float index = medium_info.at("index");
   unsigned recursion = medium_info.at("recursion");
+  if (recursion >= TRACE_STACK_SIZE) {
+    throw Cpp_Raytracing_INVALID_INPUT("recursion depth is too large");
+  }
+  float threshold = medium_info.value("threshold", CONTRIBUTION_THRESHOLD);
+  float roulette = medium_info.value("roulette", 0.0);
+
+  RenderOptions options;
+  if (data.contains("render")) {
+    json render_info = data.at("render");
+
+    std::string mode = render_info.value("mode", "pixel");
+    if (mode == "wavefront") {
+      options.mode = RenderMode::WAVEFRONT;
+    }
+    else if (mode != "pixel") {
+      throw Cpp_Raytracing_INVALID_INPUT("unknown render mode");
+    }
+
+    options.threads = render_info.value("threads", options.threads);
+    options.batch_size = render_info.value("batch", options.batch_size);
+    options.sort_secondary = render_info.value("sort", options.sort_secondary);
+    options.light_samples = render_info.value("lights", options.light_samples);
+    options.cost_map = render_info.value("cost_map", options.cost_map);
+    options.tile_size = render_info.value("tile", options.tile_size);
+
+    std::string order = render_info.value("order", "scanline");
+    if (order == "morton") {
+      options.pixel_order = PixelOrder::MORTON;
+    }
+    else if (order == "hilbert") {
+      options.pixel_order = PixelOrder::HILBERT;
+    }
+    else if (order != "scanline") {
+      throw Cpp_Raytracing_INVALID_INPUT("unknown pixel order");
+    }
+
+    if (options.cost_map and options.mode != RenderMode::PIXEL) {
+      throw Cpp_Raytracing_INVALID_INPUT("the cost map can only be recorded in pixel mode");
+    }
+
+    if (render_info.contains("antialiasing")) {
+      json aa_info = render_info.at("antialiasing");
+
+      options.min_samples = aa_info.value("min", options.min_samples);
+      options.max_samples = aa_info.value("max", options.max_samples);
+      options.contrast_threshold = aa_info.value("threshold", options.contrast_threshold);
+
+      if (options.min_samples == 0 or options.max_samples < options.min_samples) {
+        throw Cpp_Raytracing_INVALID_INPUT("antialiasing needs 0 < min <= max samples");
+      }
+    }
+
+    if (render_info.contains("progressive")) {
+      json progressive_info = render_info.at("progressive");
+
+      options.time_budget = progressive_info.value("budget", options.time_budget);
+      options.coverage_target = progressive_info.value("coverage", options.coverage_target);
+      options.progressive_step = progressive_info.value("step", options.progressive_step);
+
+      if (options.time_budget < 0 or options.coverage_target <= 0 or options.coverage_target > 1 or options.progressive_step == 0) {
+        throw Cpp_Raytracing_INVALID_INPUT("progressive rendering needs a budget >= 0, 0 < coverage <= 1 and step > 0");
+      }
+    }
+  }
+
+  double build_start = Timeline::now();
+  std::unique_ptr<Arena> arena = std::make_unique<Arena>();
 
   std::vector<LightSource*> sources;
   for (auto [_, val] : data.at("sources").items()) {
-    LightSource* src = read_source(val);
+    LightSource* src = read_source(val, *arena);
     sources.push_back(src);
   }
 
-  BaseObject* objects = read_union(data.at("objects"));
-  RootObject* root = new RootObject(objects);
+  BaseObject* objects = read_union(data.at("objects"), *arena);
+  RootObject* root = arena->create<RootObject>(objects);
+  Timeline::record("build tree", "load", build_start, Timeline::now());
+
+  OptimizerReport report = root->optimize(*arena);
+  {
+    TimelineSpan span("fold transformations", "optimizer");
+    root->fold_transformations(*arena);
+  }
 
   return Scene(dpi, dim[0], dim[1], 
                Eigen::Vector4d(pos[0], pos[1], pos[2], 1), Eigen::Vector4d(obs[0], obs[1], obs[2], 1),
-               amb, index, recursion, sources, root);
+               amb, index, recursion, sources, root, std::move(arena), report,
+               threshold, roulette, options);
 }
 
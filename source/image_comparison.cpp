@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <image_comparison.hpp>
+#include <custom_exceptions.hpp>
+
+/**
+ * \brief Throws, unless image and reference have the same, non-zero size.
+ */
+static void check_sizes(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference) {
+  if (image.rows != reference.rows or image.cols != reference.cols) {
+    throw Cpp_Raytracing_INVALID_INPUT("compared images differ in size");
+  }
+}
+
+/**
+ * \brief Structural similarity of color channel k in the window of rows x columns pixels at (i0, j0).
+ */
+static double window_ssim(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference, int i0, int j0, int rows, int columns, unsigned k) {
+  // the stabilizing constants of Wang et al. for 8 bit channels
+  const double C1 = (0.01 * 255) * (0.01 * 255);
+  const double C2 = (0.03 * 255) * (0.03 * 255);
+
+  double sum_x = 0, sum_y = 0, sum_xx = 0, sum_yy = 0, sum_xy = 0;
+  for (int i = i0; i < i0 + rows; i++) {
+    for (int j = j0; j < j0 + columns; j++) {
+      double x = image(i, j)[k];
+      double y = reference(i, j)[k];
+      sum_x += x;
+      sum_y += y;
+      sum_xx += x * x;
+      sum_yy += y * y;
+      sum_xy += x * y;
+    }
+  }
+
+  double n = rows * columns;
+  double mean_x = sum_x / n;
+  double mean_y = sum_y / n;
+  double var_x = sum_xx / n - mean_x * mean_x;
+  double var_y = sum_yy / n - mean_y * mean_y;
+  double cov = sum_xy / n - mean_x * mean_y;
+
+  return ((2 * mean_x * mean_y + C1) * (2 * cov + C2)) / ((mean_x * mean_x + mean_y * mean_y + C1) * (var_x + var_y + C2));
+}
+
+
+ImageComparison ImageComparison::compare(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference, unsigned pixel_error) {
+  check_sizes(image, reference);
+  if (image.empty()) {
+    throw Cpp_Raytracing_INVALID_INPUT("compared images are empty");
+  }
+
+  ImageComparison C;
+
+  double squared = 0;
+  double absolute = 0;
+  unsigned long changed = 0;
+  for (int i = 0; i < image.rows; i++) {
+    for (int j = 0; j < image.cols; j++) {
+      unsigned pixel_max = 0;
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        unsigned error = std::abs(image(i, j)[k] - reference(i, j)[k]);
+        pixel_max = std::max(pixel_max, error);
+        absolute += error;
+        squared += error * error;
+      }
+
+      C.max_error = std::max(C.max_error, pixel_max);
+      if (pixel_max > pixel_error) {
+        changed++;
+      }
+    }
+  }
+
+  double pixels = (double) image.rows * image.cols;
+  C.mean_error = absolute / (pixels * NUM_COL);
+  C.changed_pixels = changed / pixels;
+
+  double mse = squared / (pixels * NUM_COL);
+  C.psnr = mse == 0 ? std::numeric_limits<double>::infinity() : 10 * std::log10(255.0 * 255.0 / mse);
+
+  // images smaller than a window are compared as a single window
+  int rows = std::min(image.rows, SSIM_WINDOW);
+  int columns = std::min(image.cols, SSIM_WINDOW);
+  int step = std::max(1, SSIM_WINDOW / 2);
+
+  double ssim = 0;
+  unsigned long windows = 0;
+  for (int i0 = 0; i0 + rows <= image.rows; i0 += step) {
+    for (int j0 = 0; j0 + columns <= image.cols; j0 += step) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        ssim += window_ssim(image, reference, i0, j0, rows, columns, k);
+        windows++;
+      }
+    }
+  }
+  C.ssim = ssim / windows;
+
+  return C;
+}
+
+cv::Mat_<cv::Vec3b> ImageComparison::difference(const cv::Mat_<cv::Vec3b>& image, const cv::Mat_<cv::Vec3b>& reference) {
+  check_sizes(image, reference);
+
+  cv::Mat_<cv::Vec3b> diff(image.rows, image.cols);
+  for (int i = 0; i < image.rows; i++) {
+    for (int j = 0; j < image.cols; j++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        diff(i, j)[k] = std::min(255, REGRESSION_DIFF_GAIN * std::abs(image(i, j)[k] - reference(i, j)[k]));
+      }
+    }
+  }
+
+  return diff;
+}
+
+bool ImageComparison::within(const ImageTolerance& tolerance) const {
+  return changed_pixels <= tolerance.changed_pixels and psnr >= tolerance.psnr and ssim >= tolerance.ssim;
+}
+
+nlohmann::json ImageComparison::json() const {
+  return {
+    {"max_error", max_error},
+    {"mean_error", mean_error},
+    {"changed_pixels", changed_pixels},
+    {"psnr", std::isinf(psnr) ? nlohmann::json() : nlohmann::json(psnr)},
+    {"ssim", ssim}
+  };
+}
+
+std::ostream& operator<<(std::ostream& out, const ImageComparison& comparison) {
+  out << "largest channel error: " << comparison.max_error << "\n"
+      << "mean channel error:    " << comparison.mean_error << "\n"
+      << "changed pixels:        " << 100 * comparison.changed_pixels << "%\n"
+      << "PSNR:                  " << comparison.psnr << " dB\n"
+      << "SSIM:                  " << comparison.ssim;
+
+  return out;
+}
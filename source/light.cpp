@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include <light.hpp>
 
 LightIntensity::LightIntensity(std::array<float, NUM_COL> rgb): rgb(rgb) {
@@ -13,6 +16,10 @@ const float& LightIntensity::at(unsigned k) const {
   return rgb.at(k);
 }
 
+float LightIntensity::maximum() const {
+  return *std::max_element(rgb.begin(), rgb.end());
+}
+
 void LightIntensity::operator+=(const LightIntensity& other) {
   for (unsigned i = 0; i < NUM_COL; i++) {
     this->rgb.at(i) = 1 - (1 - this->rgb.at(i)) * (1 - other.rgb.at(i));
@@ -75,18 +82,44 @@ ColData::ColData():
 
 LightSource::LightSource(
   const Eigen::Vector4d& position,
-  const LightIntensity& intensity
-): position(position), intensity(intensity)
+  const LightIntensity& intensity,
+  double range
+): position(position), intensity(intensity), range(range),
+  area(LightShape::POINT), sphere_radius(0), edge_u(Eigen::Vector3d::Zero()), edge_v(Eigen::Vector3d::Zero())
 {
   CUSTOM_ASSERT(abs(position[3] - 1) < EPSILON);
+  CUSTOM_ASSERT(range > 0);
 }
 
 LightSource::LightSource(
   const Eigen::Vector3d& position,
-  const LightIntensity& intensity
-): LightSource((Eigen::Vector4d) position.homogeneous(), intensity) 
+  const LightIntensity& intensity,
+  double range
+): LightSource((Eigen::Vector4d) position.homogeneous(), intensity, range) 
 {}
 
+LightSource* LightSource::Sphere(Arena& arena, const Eigen::Vector3d& center, double radius, const LightIntensity& intensity, double range) {
+  CUSTOM_ASSERT(radius > 0);
+
+  LightSource* ls = arena.create<LightSource>(center, intensity, range);
+  ls->area = LightShape::SPHERE;
+  ls->sphere_radius = radius;
+
+  return ls;
+}
+
+LightSource* LightSource::Rectangle(Arena& arena, const Eigen::Vector3d& center, const Eigen::Vector3d& edge_u, const Eigen::Vector3d& edge_v,
+                                    const LightIntensity& intensity, double range) {
+  CUSTOM_ASSERT(edge_u.cross(edge_v).norm() > EPSILON);
+
+  LightSource* ls = arena.create<LightSource>(center, intensity, range);
+  ls->area = LightShape::RECTANGLE;
+  ls->edge_u = edge_u;
+  ls->edge_v = edge_v;
+
+  return ls;
+}
+
 LightSource::LightSource(): LightSource((Eigen::Vector3d) Eigen::Vector3d::Zero(), {0, 0, 0}) {}
 
 LightSource::~LightSource() {
@@ -101,4 +134,74 @@ const LightIntensity& LightSource::rgb() const {
 
 const Eigen::Vector4d& LightSource::pos() const {
   return position;
+}
+
+LightShape LightSource::shape() const {
+  return area;
+}
+
+double LightSource::extent() const {
+  switch (area) {
+    case LightShape::SPHERE:
+      return sphere_radius;
+    case LightShape::RECTANGLE:
+      return std::max((edge_u + edge_v).norm(), (edge_u - edge_v).norm()) / 2;
+    default:
+      return 0;
+  }
+}
+
+Eigen::Vector4d LightSource::sample_point(const Eigen::Vector4d& shaded, double s, double t) const {
+  switch (area) {
+    case LightShape::SPHERE: {
+      Eigen::Vector3d w = (shaded - position).head<3>();
+      if (w.isZero()) {
+        return position;
+      }
+      w.normalize();
+
+      // orthonormal basis of the disc facing shaded
+      Eigen::Vector3d u = (abs(w[0]) < 0.9 ? Eigen::Vector3d::UnitX() : Eigen::Vector3d::UnitY()).cross(w).normalized();
+      Eigen::Vector3d v = w.cross(u);
+
+      double r = sphere_radius * sqrt(s);
+      double phi = 2 * M_PI * t;
+
+      return position + (r * (cos(phi) * u + sin(phi) * v)).homogeneous() - Eigen::Vector4d::UnitW();
+    }
+    case LightShape::RECTANGLE:
+      return position + ((s - 0.5) * edge_u + (t - 0.5) * edge_v).homogeneous() - Eigen::Vector4d::UnitW();
+    default:
+      return position;
+  }
+}
+
+double LightSource::radius() const {
+  return range;
+}
+
+bool LightSource::ranged() const {
+  return std::isfinite(range);
+}
+
+float LightSource::attenuation(double distance) const {
+  if (not ranged()) {
+    return 1;
+  }
+
+  if (distance >= range) {
+    return 0;
+  }
+
+  double x = 1 - (distance * distance) / (range * range);
+  return x * x;
+}
+
+bool LightSource::reaches(const BoundingBox& box) const {
+  if (box.empty()) {
+    return false;
+  }
+
+  double reach = range + extent();
+  return box.squared_distance(position.head<3>()) < reach * reach;
 }
\ No newline at end of file
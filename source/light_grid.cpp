@@ -0,0 +1,49 @@
+#include <numeric>
+
+#include <light_grid.hpp>
+
+LightGrid::LightGrid(unsigned sources): columns(0), lists(), everything(sources) {
+  std::iota(everything.begin(), everything.end(), 0);
+}
+
+LightGrid::LightGrid(unsigned sources, unsigned rows, unsigned columns): LightGrid(sources) {
+  this->columns = (columns + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+  lists.assign(((rows + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE) * this->columns, everything);
+}
+
+LightGrid::LightGrid(): LightGrid(0) {}
+
+unsigned LightGrid::size() const {
+  return lists.size();
+}
+
+unsigned LightGrid::tile(unsigned i, unsigned j) const {
+  if (lists.empty()) {
+    return 0;
+  }
+
+  return (i / LIGHT_TILE_SIZE) * columns + j / LIGHT_TILE_SIZE;
+}
+
+void LightGrid::cull(unsigned tile, const BoundingBox& geometry, const std::vector<LightSource*>& sources) {
+  std::vector<unsigned>& list = lists.at(tile);
+
+  list.clear();
+  for (unsigned k = 0; k < sources.size(); k++) {
+    if (sources[k]->reaches(geometry)) {
+      list.push_back(k);
+    }
+  }
+}
+
+const std::vector<unsigned>& LightGrid::lights(unsigned tile) const {
+  if (lists.empty()) {
+    return everything;
+  }
+
+  return lists.at(tile);
+}
+
+const std::vector<unsigned>& LightGrid::all() const {
+  return everything;
+}
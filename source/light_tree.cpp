@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include <light_tree.hpp>
+
+LightSum::LightSum(): density() {}
+
+void LightSum::add(LightIntensity& value, const LightIntensity& light, float weight) {
+  if (weight == 1) {
+    value += light;
+    return;
+  }
+
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    density[k] -= weight * std::log1p(- (double) light.at(k));
+  }
+}
+
+void LightSum::add(LightIntensity& value, const LightSample& sample, float weight) {
+  if (sample.lit) {
+    add(value, sample.diffuse, weight);
+  }
+  if (sample.highlighted) {
+    add(value, sample.specular, weight);
+  }
+}
+
+void LightSum::finish(LightIntensity& value) const {
+  if (std::all_of(density.begin(), density.end(), [](double d) { return d == 0; })) {
+    return;
+  }
+
+  std::array<float, NUM_COL> rgb;
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    rgb[k] = - std::expm1(- density[k]);
+  }
+
+  value += LightIntensity(rgb);
+}
+
+LightTree::LightTree(const std::vector<LightSource*>& sources): nodes(), leaves(sources.size()) {
+  if (sources.empty()) {
+    return;
+  }
+
+  std::vector<unsigned> order(sources.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  nodes.reserve(2 * sources.size() - 1);
+  build(sources, order, 0, sources.size(), 0);
+}
+
+LightTree::LightTree(): nodes(), leaves() {}
+
+unsigned LightTree::build(const std::vector<LightSource*>& sources, std::vector<unsigned>& order, unsigned begin, unsigned end, unsigned parent) {
+  unsigned index = nodes.size();
+  nodes.push_back(Node{BoundingBox(), BoundingBox(), 0, parent, 0, 0, 0});
+
+  BoundingBox box;
+  BoundingBox influence;
+  double power = 0;
+  for (unsigned k = begin; k < end; k++) {
+    const LightSource& ls = *sources[order[k]];
+    Eigen::Vector3d position = ls.pos().head<3>();
+
+    box = box.merged(BoundingBox(position, position));
+    double reach = ls.radius() + ls.extent();
+    influence = influence.merged(BoundingBox(position.array() - reach, position.array() + reach));
+    for (unsigned c = 0; c < NUM_COL; c++) {
+      power += ls.rgb().at(c);
+    }
+  }
+  nodes[index].box = box;
+  nodes[index].influence = influence;
+  nodes[index].power = power;
+
+  if (end - begin == 1) {
+    nodes[index].source = order[begin];
+    leaves[order[begin]] = index;
+    return index;
+  }
+
+  unsigned axis;
+  (box.max() - box.min()).maxCoeff(&axis);
+
+  unsigned middle = (begin + end) / 2;
+  std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&sources, axis](unsigned a, unsigned b) {
+    return sources[a]->pos()[axis] < sources[b]->pos()[axis];
+  });
+
+  // nodes may be reallocated while building the children
+  unsigned left = build(sources, order, begin, middle, index);
+  unsigned right = build(sources, order, middle, end, index);
+  nodes[index].left = left;
+  nodes[index].right = right;
+
+  return index;
+}
+
+double LightTree::importance(const Node& node, const Eigen::Vector3d& point) const {
+  if (node.influence.squared_distance(point) > 0) { // out of range of every light below node
+    return 0;
+  }
+
+  double half_diagonal = (node.box.max() - node.box.min()).squaredNorm() / 4;
+  double distance = std::max({node.box.squared_distance(point), half_diagonal, EPSILON});
+
+  return node.power / distance;
+}
+
+double LightTree::branch_probability(unsigned node, const Eigen::Vector3d& point) const {
+  const Node& parent = nodes[nodes[node].parent];
+
+  double left = importance(nodes[parent.left], point);
+  double right = importance(nodes[parent.right], point);
+
+  if (left + right == 0) { // only black lights or out of range
+    return 0.5;
+  }
+
+  return (node == parent.left ? left : right) / (left + right);
+}
+
+unsigned LightTree::size() const {
+  return leaves.size();
+}
+
+unsigned LightTree::sample(const Eigen::Vector3d& point, double u, double& probability) const {
+  CUSTOM_ASSERT(not nodes.empty());
+
+  unsigned node = 0;
+  probability = 1;
+
+  while (nodes[node].left != 0) {
+    double p_left = branch_probability(nodes[node].left, point);
+
+    // u is stretched back to [0, 1) after every decision, so a single random number suffices
+    if (u < p_left) {
+      u /= p_left;
+      probability *= p_left;
+      node = nodes[node].left;
+    }
+    else {
+      u = std::min((u - p_left) / (1 - p_left), std::nextafter(1.0, 0.0));
+      probability *= 1 - p_left;
+      node = nodes[node].right;
+    }
+  }
+
+  return nodes[node].source;
+}
+
+double LightTree::probability(const Eigen::Vector3d& point, unsigned source) const {
+  double probability = 1;
+
+  for (unsigned node = leaves.at(source); node != 0; node = nodes[node].parent) {
+    probability *= branch_probability(node, point);
+  }
+
+  return probability;
+}
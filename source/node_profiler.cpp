@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <cxxabi.h>
+
+#include <node_profiler.hpp>
+#include <objects.hpp>
+
+/**
+ * \brief Readable name of the class of node.
+ */
+static std::string type_name(const BaseObject* node) {
+  const char* mangled = typeid(*node).name();
+
+  int status = 0;
+  std::unique_ptr<char, void(*)(void*)> demangled(abi::__cxa_demangle(mangled, nullptr, nullptr, &status), std::free);
+
+  return status == 0 ? demangled.get() : mangled;
+}
+
+/**
+ * \brief Annotates node and the nodes below it with their counters.
+ */
+static nlohmann::json annotate(const BaseObject* node, const std::vector<NodeCounters>& counters, double total) {
+  NodeCounters count = node->profile_id < counters.size() ? counters[node->profile_id] : NodeCounters();
+
+  nlohmann::json annotated = {
+    {"type", type_name(node)},
+    {"intersect_calls", count.intersect_calls},
+    {"included_calls", count.included_calls},
+    {"points", count.points},
+    {"seconds", count.seconds},
+    {"self_seconds", count.self_seconds},
+    {"share", total > 0 ? count.seconds / total : 0},
+    {"self_share", total > 0 ? count.self_seconds / total : 0},
+    {"children", nlohmann::json::array()}
+  };
+
+  std::vector<const BaseObject*> children;
+  node->children(children);
+  for (const BaseObject* child : children) {
+    annotated["children"].push_back(annotate(child, counters, total));
+  }
+
+  return annotated;
+}
+
+/**
+ * \brief Appends node and the nodes below it to nodes, with their path below path.
+ */
+static void flatten(const BaseObject* node, const std::string& path, std::vector<std::pair<std::string, const BaseObject*>>& nodes) {
+  nodes.emplace_back(path, node);
+
+  std::vector<const BaseObject*> children;
+  node->children(children);
+  for (unsigned k = 0; k < children.size(); k++) {
+    flatten(children[k], path + " > " + type_name(children[k]) + "[" + std::to_string(k) + "]", nodes);
+  }
+}
+
+
+NodeCounters& NodeCounters::operator+=(const NodeCounters& other) {
+  intersect_calls += other.intersect_calls;
+  included_calls += other.included_calls;
+  points += other.points;
+  seconds += other.seconds;
+  self_seconds += other.self_seconds;
+
+  return *this;
+}
+
+
+std::atomic<unsigned> NodeProfiler::node_count(0);
+std::mutex NodeProfiler::mutex;
+std::vector<NodeCounters> NodeProfiler::finished;
+double NodeProfiler::finished_seconds = 0;
+thread_local NodeProfiler::ThreadCounters NodeProfiler::local;
+
+NodeProfiler::ThreadCounters::~ThreadCounters() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (finished.size() < nodes.size()) {
+    finished.resize(nodes.size());
+  }
+  for (unsigned id = 0; id < nodes.size(); id++) {
+    finished[id] += nodes[id];
+  }
+  finished_seconds += seconds;
+}
+
+unsigned NodeProfiler::register_node() {
+  return node_count++;
+}
+
+std::vector<NodeCounters> NodeProfiler::collect() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::vector<NodeCounters> total = finished;
+  total.resize(node_count);
+  for (unsigned id = 0; id < local.nodes.size(); id++) {
+    total[id] += local.nodes[id];
+  }
+
+  return total;
+}
+
+double NodeProfiler::total_seconds() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  return finished_seconds + local.seconds;
+}
+
+void NodeProfiler::reset() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  finished.clear();
+  finished_seconds = 0;
+  local.nodes.clear();
+  local.seconds = 0;
+}
+
+nlohmann::json NodeProfiler::tree(const RootObject& root) {
+  return annotate(root.top(), collect(), total_seconds());
+}
+
+void NodeProfiler::print_top(std::ostream& out, const RootObject& root, unsigned n) {
+  std::vector<NodeCounters> counters = collect();
+  double total = total_seconds();
+
+  std::vector<std::pair<std::string, const BaseObject*>> nodes;
+  flatten(root.top(), type_name(root.top()), nodes);
+
+  auto seconds = [&counters](const BaseObject* node) {
+    return node->profile_id < counters.size() ? counters[node->profile_id].seconds : 0;
+  };
+  std::stable_sort(nodes.begin(), nodes.end(), [&seconds](const auto& a, const auto& b) {
+    return seconds(a.second) > seconds(b.second);
+  });
+
+  out << std::right << std::setw(8) << "total" << std::setw(8) << "self" << std::setw(14) << "intersect" << std::setw(14) << "included"
+      << std::setw(14) << "points" << "  node" << std::endl;
+
+  for (unsigned k = 0; k < std::min<std::size_t>(n, nodes.size()); k++) {
+    const NodeCounters& count = counters[nodes[k].second->profile_id];
+
+    out << std::fixed << std::setprecision(1)
+        << std::setw(7) << (total > 0 ? 100 * count.seconds / total : 0) << "%"
+        << std::setw(7) << (total > 0 ? 100 * count.self_seconds / total : 0) << "%"
+        << std::setw(14) << count.intersect_calls << std::setw(14) << count.included_calls << std::setw(14) << count.points
+        << "  " << nodes[k].first << std::endl;
+  }
+}
@@ -1,4 +1,19 @@
 #include <objects.hpp>
+#include <render_stats.hpp>
+
+/**
+ * \brief Checks if a Ray hits part in front of distance.
+ */
+static bool blocks(const BaseObject* part, const Ray& r, double distance) {
+  std::vector<IntersectionPoint> intersection_points;
+
+  part->intersect(r, intersection_points);
+
+  return std::any_of(intersection_points.begin(), intersection_points.end(), [distance](const IntersectionPoint& ip) {
+    return ip.distance < distance;
+  });
+}
+
 
 IntersectionPoint::IntersectionPoint(Eigen::Vector4d point, Eigen::Vector4d normal, ColData color, float index, double distance, bool inside): point(point), normal(normal.normalized()), color(color), index(index), distance(distance), inside(inside) {
   CUSTOM_ASSERT(abs(point[3] - 1) < EPSILON);
@@ -34,20 +49,44 @@ bool BaseObject::included(const Eigen::Vector3d& point) {
   return included(point, (Eigen::Transform<double, 3, Eigen::Projective>) Eigen::DiagonalMatrix<double, 3>(1, 1, 1));
 }
 
+BaseObject* BaseObject::fold_transformations(Arena&) {
+  return this;
+}
+
+bool BaseObject::absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>&) {
+  return false;
+}
+
+BoundingBox BaseObject::bounds() const {
+  return BoundingBox::infinite();
+}
+
+BaseObject::BaseObject(): profile_id(NodeProfiler::register_node()) {}
+
+BaseObject::BaseObject(const BaseObject&): profile_id(NodeProfiler::register_node()) {}
+
+BaseObject& BaseObject::operator=(const BaseObject&) {
+  return *this;
+}
+
 BaseObject::~BaseObject() {}
 
-RootObject::RootObject(BaseObject* child): child(child) {}
+RootObject::RootObject(BaseObject* child): child(child), parts() {
+  split();
+}
 
-RootObject::~RootObject() {
-  #ifdef DEBUG
-    std::cout << "Destructing Root Object at " << this << std::endl;
-  #endif
+void RootObject::split() {
+  parts.clear();
 
   if (child != nullptr) {
-    delete child;
+    child->split(parts);
   }
 }
 
+const BaseObject* RootObject::top() const {
+  return child;
+}
+
 bool RootObject::intersect(const Ray& r, IntersectionPoint* dest) const {
   std::vector<IntersectionPoint> intersection_points;
 
@@ -68,6 +107,32 @@ bool RootObject::included(const Eigen::Vector4d& point) const {
   return child->included(point);
 }
 
+bool RootObject::occluded(const Ray& r, double distance, unsigned& occluder, unsigned skip) const {
+  for (unsigned k = 0; k < parts.size(); k++) {
+    if (k != skip and blocks(parts[k], r, distance)) {
+      occluder = k;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool RootObject::occluded_by(const Ray& r, double distance, unsigned occluder) const {
+  return blocks(parts.at(occluder), r, distance);
+}
+
+void RootObject::fold_transformations(Arena& arena) {
+  child = child->fold_transformations(arena);
+  split();
+}
+
+void BaseObject::split(std::vector<const BaseObject*>& parts) const {
+  parts.push_back(this);
+}
+
+void BaseObject::children(std::vector<const BaseObject*>&) const {}
+
 
 
 Primitive::Primitive(ColData col, float index):
@@ -78,6 +143,14 @@ Primitive::Primitive():
   Primitive(ColData(), 1.0)
   {}
 
+const ColData& Primitive::color() const {
+  return col;
+}
+
+float Primitive::refraction_index() const {
+  return index;
+}
+
 Primitive::~Primitive() {
   #ifdef DEBUG
     std::cout << "Destructing Primitive at " << this << std::endl;
@@ -94,7 +167,11 @@ Sphere::Sphere():
   {}
 
 bool Sphere::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   Ray modified = inverse_transform * r;
+  // object space is scaled relative to global space, distances are converted back with this factor
+  double scale = (inverse_transform * r.direction()).norm();
 
   Eigen::Vector4d lot =  Eigen::Vector3d::Zero().homogeneous() - modified.start_point();
   double dot = modified.direction().dot(lot);
@@ -115,7 +192,7 @@ bool Sphere::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Pr
         inside = true;
       }
 
-      dest.push_back(IntersectionPoint(P, normal, col, index, t, inside));
+      dest.push_back(IntersectionPoint(P, normal, col, index, t / scale, inside));
       found = true;
     }
   }
@@ -124,15 +201,21 @@ bool Sphere::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Pr
 }
 
 bool Sphere::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   Eigen::Vector4d modified = inverse_transform * point;
   
   double dist = abs((modified - Eigen::Vector3d::Zero().homogeneous()).norm());
   return dist < 1;
 }
 
+BoundingBox Sphere::bounds() const {
+  return BoundingBox(Eigen::Vector3d(-1, -1, -1), Eigen::Vector3d(1, 1, 1));
+}
+
 
 HalfSpace::HalfSpace(ColData col, float index, Eigen::Vector4d normal):
-  Primitive(col, index), normal(normal)
+  Primitive(col, index), normal(normal), offset(0)
   {
     CUSTOM_ASSERT(abs(this->normal[3] - 0) < EPSILON);
     this->normal.normalize();
@@ -143,10 +226,13 @@ HalfSpace::HalfSpace():
   {}
 
 bool HalfSpace::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   Ray modified = inverse_transform * r;
+  double scale = (inverse_transform * r.direction()).norm();
   
   if (normal.dot(modified.direction()) == 0) {
-    if (normal.dot(modified.start_point()) == 0) { // does the start point lie in the half-space?
+    if (normal.dot(modified.start_point()) + offset == 0) { // does the start point lie in the half-space?
       dest.push_back(IntersectionPoint(modified.start_point(), normal, col, index, 0, false));
       return true;
     }
@@ -154,7 +240,7 @@ bool HalfSpace::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen:
     return false;
   };
 
-  double t = normal.dot(Eigen::Vector3d::Zero().homogeneous() - modified.start_point()) / normal.dot(modified.direction());
+  double t = - (normal.dot(modified.start_point()) + offset) / normal.dot(modified.direction());
   
   if (t <= 0) return false;
 
@@ -165,15 +251,50 @@ bool HalfSpace::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen:
     inside = true;
   }
 
-  dest.push_back(IntersectionPoint(P, normal, col, index, t, inside));
+  dest.push_back(IntersectionPoint(P, normal, col, index, t / scale, inside));
   
   return true;
 }
 
 bool HalfSpace::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   Eigen::Vector4d modified = inverse_transform * point;
   
-  return normal.dot(Eigen::Vector3d::Zero().homogeneous() - modified) > 0;
+  return normal.dot(modified) + offset < 0;
+}
+
+BoundingBox HalfSpace::bounds() const {
+  BoundingBox box = BoundingBox::infinite();
+
+  // only planes perpendicular to an axis bound the space
+  for (unsigned i = 0; i < 3; i++) {
+    if (abs(abs(normal[i]) - 1) < EPSILON) {
+      Eigen::Vector3d min = box.min();
+      Eigen::Vector3d max = box.max();
+
+      if (normal[i] > 0) max[i] = - offset / normal[i];
+      else min[i] = - offset / normal[i];
+
+      box = BoundingBox(min, max);
+    }
+  }
+
+  return box;
+}
+
+bool HalfSpace::absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) {
+  Eigen::Vector4d plane = inverse.matrix().transpose() * plane_equation();
+  double length = plane.head<3>().norm();
+
+  normal = Eigen::Vector4d(plane[0], plane[1], plane[2], 0) / length;
+  offset = plane[3] / length;
+
+  return true;
+}
+
+Eigen::Vector4d HalfSpace::plane_equation() const {
+  return Eigen::Vector4d(normal[0], normal[1], normal[2], offset);
 }
 
 Cylinder::Cylinder(ColData col, float index):
@@ -185,7 +306,10 @@ Cylinder::Cylinder():
   {}
 
 bool Cylinder::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   Ray modified = inverse_transform * r;
+  double scale = (inverse_transform * r.direction()).norm();
 
   Eigen::Vector2d projected_P(modified.start_point()[0], modified.start_point()[1]);
   Eigen::Vector2d projected_d(modified.direction()[0], modified.direction()[1]);
@@ -218,7 +342,7 @@ bool Cylinder::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::
       inside = true;
     }
 
-    dest.push_back(IntersectionPoint(P, normal, col, index, t, inside));
+    dest.push_back(IntersectionPoint(P, normal, col, index, t / scale, inside));
     found = true;
   }
 
@@ -226,45 +350,410 @@ bool Cylinder::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::
 }
 
 bool Cylinder::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   Eigen::Vector4d modified = inverse_transform * point;
 
   return ((modified[0] * modified[0] + modified[1] * modified[1]) < 1); 
 }
 
+BoundingBox Cylinder::bounds() const {
+  double inf = std::numeric_limits<double>::infinity();
+  return BoundingBox(Eigen::Vector3d(-1, -1, -inf), Eigen::Vector3d(1, 1, inf));
+}
+
+Quadric* Quadric::UnitSphere(Arena& arena, ColData col, float index) {
+  return arena.create<Quadric>(col, index, Eigen::Vector4d(1, 1, 1, -1).asDiagonal());
+}
+
+Quadric* Quadric::UnitCylinder(Arena& arena, ColData col, float index) {
+  return arena.create<Quadric>(col, index, Eigen::Vector4d(1, 1, 0, -1).asDiagonal());
+}
+
+Quadric* Quadric::UnitCone(Arena& arena, ColData col, float index) {
+  return arena.create<Quadric>(col, index, Eigen::Vector4d(1, 1, -1, 0).asDiagonal());
+}
+
+Quadric* Quadric::UnitParaboloid(Arena& arena, ColData col, float index) {
+  Eigen::Matrix4d Q = Eigen::Vector4d(1, 1, 0, 0).asDiagonal();
+  Q(2, 3) = -0.5;
+  Q(3, 2) = -0.5;
+
+  return arena.create<Quadric>(col, index, Q);
+}
+
+Quadric::Quadric(ColData col, float index, const Eigen::Matrix4d& coefficients):
+  Primitive(col, index), coefficients(0.5 * (coefficients + coefficients.transpose()))
+  {}
+
+Quadric::Quadric():
+  Quadric(ColData(), 1.0, Eigen::Vector4d(1, 1, 1, -1).asDiagonal())
+  {}
+
+bool Quadric::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
+  Ray modified = inverse_transform * r;
+  double scale = (inverse_transform * r.direction()).norm();
+
+  const Eigen::Vector4d& S = modified.start_point();
+  const Eigen::Vector4d& d = modified.direction();
+
+  // solve a t^2 + 2 b t + c = 0 for (S + t d)^T Q (S + t d) = 0
+  Eigen::Vector4d Qd = coefficients * d;
+  double a = d.dot(Qd);
+  double b = S.dot(Qd);
+  double c = S.dot(coefficients * S);
+
+  std::array<double, 2> t_arr;
+  unsigned num_roots = 2;
+
+  if (abs(a) < EPSILON) {
+    if (abs(b) < EPSILON) return false;
+
+    t_arr[0] = - c / (2 * b);
+    num_roots = 1;
+  }
+  else {
+    double delta = b * b - a * c;
+
+    if (delta < 0) return false;
+
+    t_arr = {(- b - sqrtf64(delta)) / a, (- b + sqrtf64(delta)) / a};
+  }
+
+  bool found = false;
+
+  for (unsigned k = 0; k < num_roots; k++) {
+    double t = t_arr[k];
+
+    if (t <= 0) {
+      continue;
+    }
+
+    Eigen::Vector4d P = S + t * d;
+    Eigen::Vector4d normal = coefficients * P;
+    normal[3] = 0;
+
+    if (normal.isZero()) { // apex of a cone, the surface has no defined normal here
+      normal = -d;
+    }
+
+    bool inside = false;
+    if (normal.dot(d) > 0) {
+      inside = true;
+    }
+
+    dest.push_back(IntersectionPoint(P, normal, col, index, t / scale, inside));
+    found = true;
+  }
+
+  return found;
+}
+
+bool Quadric::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
+  Eigen::Vector4d modified = inverse_transform * point;
 
-Transformation* Transformation::Scaling(BaseObject* child, double ax, double ay, double az) {
-  return new Transformation(child, Eigen::DiagonalMatrix<double, 3>(ax, ay, az));
+  return modified.dot(coefficients * modified) < 0;
 }
 
-Transformation* Transformation::Rotation_X(BaseObject* child, double alpha) {
-  return new Transformation(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitX()));
+BoundingBox Quadric::bounds() const {
+  Eigen::Matrix3d A = coefficients.block<3, 3>(0, 0);
+  Eigen::Vector3d b = coefficients.block<3, 1>(0, 3);
+
+  Eigen::LLT<Eigen::Matrix3d> llt(A);
+  if (llt.info() != Eigen::Success) { // not an ellipsoid
+    return BoundingBox::infinite();
+  }
+
+  // x^T Q x = (x - c)^T A (x - c) - k
+  Eigen::Matrix3d A_inv = llt.solve(Eigen::Matrix3d::Identity());
+  Eigen::Vector3d center = - A_inv * b;
+  double k = b.dot(A_inv * b) - coefficients(3, 3);
+
+  if (k <= 0) {
+    return BoundingBox();
+  }
+
+  Eigen::Vector3d extent = (k * A_inv.diagonal()).cwiseSqrt();
+  return BoundingBox(center - extent, center + extent);
 }
-Transformation* Transformation::Rotation_Y(BaseObject* child, double alpha) {
-  return new Transformation(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitY()));
+
+bool Quadric::absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) {
+  coefficients = inverse.matrix().transpose() * coefficients * inverse.matrix();
+
+  return true;
 }
-Transformation* Transformation::Rotation_Z(BaseObject* child, double alpha) {
-  return new Transformation(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitZ()));
+
+const Eigen::Matrix4d& Quadric::matrix() const {
+  return coefficients;
 }
 
-Transformation* Transformation::Translation(BaseObject* child, double dx, double dy, double dz) {
-  return new Transformation(child, Eigen::Translation<double, 3>(dx, dy, dz));
+
+DistanceField::DistanceField(ColData col, float index, const SdfProgram& program, double lipschitz, unsigned max_iterations,
+                             const allocator_type& allocator):
+  Primitive(col, index), program(program, allocator), lipschitz(lipschitz), max_iterations(max_iterations) {
+  if (not program.complete()) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field has to describe exactly one shape");
+  }
+
+  if (lipschitz <= 0) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field needs a positive lipschitz constant");
+  }
 }
 
-Transformation::Transformation(BaseObject* child, Eigen::DiagonalMatrix<double, 3> scaling): child(child), transformation(scaling), inverse(scaling.inverse()) {}
-Transformation::Transformation(BaseObject* child, Eigen::AngleAxis<double> rotation): child(child), transformation(rotation), inverse(rotation.inverse()) {}
-Transformation::Transformation(BaseObject* child, Eigen::Translation<double, 3> translation): child(child), transformation(translation), inverse(translation.inverse()) {}
+bool DistanceField::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
 
-Transformation::~Transformation() {
-  #ifdef DEBUG
-    std::cout << "Destructing Transformation at " << this << std::endl;
-  #endif
-  
-  if(child != nullptr) {
-    delete child;
+  Ray modified = inverse_transform * r;
+  double scale = (inverse_transform * r.direction()).norm();
+
+  double t, t_far;
+  if (not program.bounds().clip(modified, t, t_far)) {
+    return false;
+  }
+
+  Eigen::Vector3d S = modified.start_point().head<3>();
+  Eigen::Vector3d d = modified.direction().head<3>();
+
+  double distance = program.evaluate(S + t * d);
+  // a Ray starting on the surface (e.g. a reflection) must not hit it again at its start point
+  bool on_surface = t == 0 and abs(distance) < SDF_HIT_EPSILON;
+  bool was_inside = distance < 0;
+
+  bool found = false;
+
+  for (unsigned i = 0; i < max_iterations and t <= t_far + SDF_HIT_EPSILON; i++) {
+    Eigen::Vector3d P = S + t * d;
+
+    if (on_surface) { // wait until the surface is left before accepting a new hit
+      if (abs(distance) >= SDF_HIT_EPSILON) {
+        on_surface = false;
+        was_inside = distance < 0;
+      }
+    }
+    // a changed sign means a step went through the surface, i.e. lipschitz is too small
+    else if (abs(distance) < SDF_HIT_EPSILON or (distance < 0) != was_inside) {
+      Eigen::Vector3d normal = program.gradient(P, SDF_HIT_EPSILON);
+
+      bool inside = false;
+      if (normal.dot(d) > 0) {
+        inside = true;
+      }
+
+      dest.push_back(IntersectionPoint(P, normal, col, index, t / scale, inside));
+      found = true;
+      on_surface = true;
+    }
+
+    t += std::max(abs(distance) / lipschitz, SDF_HIT_EPSILON);
+    distance = program.evaluate(S + t * d);
+  }
+
+  return found;
+}
+
+bool DistanceField::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
+  Eigen::Vector4d modified = inverse_transform * point;
+
+  return program.evaluate(modified.head<3>()) < 0;
+}
+
+DistanceField::DistanceField(ColData col, float index, const SdfProgram& program, const allocator_type& allocator):
+  DistanceField(col, index, program, 1, SDF_MAX_ITERATIONS, allocator) {}
+
+BoundingBox DistanceField::bounds() const {
+  return program.bounds();
+}
+
+
+ConvexPolyhedron::ConvexPolyhedron(const std::vector<const HalfSpace*>& half_spaces, const allocator_type& allocator):
+  plane_data(4 * half_spaces.size(), allocator), colors(allocator), indices(allocator) {
+  colors.reserve(half_spaces.size());
+  indices.reserve(half_spaces.size());
+
+  for (unsigned i = 0; i < half_spaces.size(); i++) {
+    planes().row(i) = half_spaces[i]->plane_equation().transpose();
+    colors.push_back(half_spaces[i]->color());
+    indices.push_back(half_spaces[i]->refraction_index());
+  }
+}
+
+Eigen::Map<const ConvexPolyhedron::PlaneMatrix> ConvexPolyhedron::planes() const {
+  return Eigen::Map<const PlaneMatrix>(plane_data.data(), plane_data.size() / 4, 4);
+}
+
+Eigen::Map<ConvexPolyhedron::PlaneMatrix> ConvexPolyhedron::planes() {
+  return Eigen::Map<PlaneMatrix>(plane_data.data(), plane_data.size() / 4, 4);
+}
+
+bool ConvexPolyhedron::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
+  Ray modified = inverse_transform * r;
+  double scale = (inverse_transform * r.direction()).norm();
+
+  const Eigen::Vector4d& S = modified.start_point();
+  const Eigen::Vector4d& d = modified.direction();
+  Eigen::Map<const PlaneMatrix> equations = planes();
+
+  double t_enter = - std::numeric_limits<double>::infinity();
+  double t_exit = std::numeric_limits<double>::infinity();
+  int enter_face = -1;
+  int exit_face = -1;
+
+  for (unsigned i = 0; i < equations.rows(); i++) {
+    double distance = equations.row(i).dot(S);
+    double speed = equations.row(i).dot(d);
+
+    if (speed == 0) {
+      if (distance >= 0) return false; // parallel and outside of this plane
+
+      continue;
+    }
+
+    double t = - distance / speed;
+
+    if (speed < 0 and t > t_enter) {
+      t_enter = t;
+      enter_face = i;
+    }
+    else if (speed > 0 and t < t_exit) {
+      t_exit = t;
+      exit_face = i;
+    }
+  }
+
+  if (t_enter >= t_exit) {
+    return false;
+  }
+
+  bool found = false;
+
+  std::array<std::pair<double, int>, 2> hits = {std::make_pair(t_enter, enter_face), std::make_pair(t_exit, exit_face)};
+  for (auto [t, face] : hits) {
+    if (face < 0 or t <= 0) {
+      continue;
+    }
+
+    Eigen::Vector4d P = S + t * d;
+    Eigen::Vector4d normal(equations(face, 0), equations(face, 1), equations(face, 2), 0);
+
+    dest.push_back(IntersectionPoint(P, normal, colors[face], indices[face], t / scale, face == exit_face));
+    found = true;
   }
+
+  return found;
+}
+
+bool ConvexPolyhedron::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
+  Eigen::Vector4d modified = inverse_transform * point;
+  Eigen::Map<const PlaneMatrix> equations = planes();
+
+  for (unsigned i = 0; i < equations.rows(); i++) {
+    if (equations.row(i).dot(modified) >= 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+BoundingBox ConvexPolyhedron::bounds() const {
+  // clip with a large box, so unbounded polyhedra have vertices as well
+  const double far = 1e6;
+  Eigen::Map<const PlaneMatrix> equations = planes();
+  Eigen::Matrix<double, Eigen::Dynamic, 4, Eigen::RowMajor> clipped(equations.rows() + 6, 4);
+  clipped << equations,
+             1, 0, 0, -far,   -1, 0, 0, -far,
+             0, 1, 0, -far,   0, -1, 0, -far,
+             0, 0, 1, -far,   0, 0, -1, -far;
+
+  BoundingBox box;
+
+  for (unsigned i = 0; i < clipped.rows(); i++) {
+    for (unsigned j = i + 1; j < clipped.rows(); j++) {
+      for (unsigned k = j + 1; k < clipped.rows(); k++) {
+        Eigen::Matrix3d A;
+        A << clipped.block<1, 3>(i, 0), clipped.block<1, 3>(j, 0), clipped.block<1, 3>(k, 0);
+
+        Eigen::FullPivLU<Eigen::Matrix3d> lu(A);
+        if (not lu.isInvertible()) {
+          continue;
+        }
+
+        Eigen::Vector3d vertex = lu.solve(- Eigen::Vector3d(clipped(i, 3), clipped(j, 3), clipped(k, 3)));
+
+        if ((clipped * vertex.homogeneous()).maxCoeff() > EPSILON) { // vertex lies outside of another plane
+          continue;
+        }
+
+        box = box.merged(BoundingBox(vertex, vertex));
+      }
+    }
+  }
+
+  if (box.empty()) {
+    return box;
+  }
+
+  Eigen::Vector3d min = box.min();
+  Eigen::Vector3d max = box.max();
+  for (unsigned i = 0; i < 3; i++) {
+    if (min[i] <= - far + EPSILON) min[i] = - std::numeric_limits<double>::infinity();
+    if (max[i] >= far - EPSILON) max[i] = std::numeric_limits<double>::infinity();
+  }
+
+  return BoundingBox(min, max);
+}
+
+bool ConvexPolyhedron::absorb_transformation(const Eigen::Transform<double, 3, Eigen::Projective>& inverse) {
+  Eigen::Map<PlaneMatrix> equations = planes();
+  equations = equations * inverse.matrix();
+
+  for (unsigned i = 0; i < equations.rows(); i++) {
+    equations.row(i) /= equations.block<1, 3>(i, 0).norm();
+  }
+
+  return true;
+}
+
+unsigned ConvexPolyhedron::faces() const {
+  return plane_data.size() / 4;
+}
+
+
+Transformation* Transformation::Scaling(Arena& arena, BaseObject* child, double ax, double ay, double az) {
+  return arena.create<Transformation>(child, Eigen::DiagonalMatrix<double, 3>(ax, ay, az));
+}
+
+Transformation* Transformation::Rotation_X(Arena& arena, BaseObject* child, double alpha) {
+  return arena.create<Transformation>(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitX()));
+}
+Transformation* Transformation::Rotation_Y(Arena& arena, BaseObject* child, double alpha) {
+  return arena.create<Transformation>(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitY()));
+}
+Transformation* Transformation::Rotation_Z(Arena& arena, BaseObject* child, double alpha) {
+  return arena.create<Transformation>(child, Eigen::AngleAxis<double>(alpha, Eigen::Vector3d::UnitZ()));
+}
+
+Transformation* Transformation::Translation(Arena& arena, BaseObject* child, double dx, double dy, double dz) {
+  return arena.create<Transformation>(child, Eigen::Translation<double, 3>(dx, dy, dz));
 }
 
+Transformation::Transformation(BaseObject* child, Eigen::DiagonalMatrix<double, 3> scaling): child(child), transformation(scaling), inverse(scaling.inverse()) {}
+Transformation::Transformation(BaseObject* child, Eigen::AngleAxis<double> rotation): child(child), transformation(rotation), inverse(rotation.inverse()) {}
+Transformation::Transformation(BaseObject* child, Eigen::Translation<double, 3> translation): child(child), transformation(translation), inverse(translation.inverse()) {}
+
 bool Transformation::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   Eigen::Transform<double, 3, Eigen::Projective> new_inverse_transform = inverse * inverse_transform;
 
   std::vector<IntersectionPoint> intersection_points;
@@ -279,11 +768,31 @@ bool Transformation::intersect(const Ray& r, const Eigen::Transform<double, 3, E
 }
 
 bool Transformation::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   Eigen::Transform<double, 3, Eigen::Projective> new_inverse = inverse * inverse_transform;
 
   return child->included(point, new_inverse);
 }
 
+BoundingBox Transformation::bounds() const {
+  return child->bounds().transformed(transformation);
+}
+
+BaseObject* Transformation::fold_transformations(Arena& arena) {
+  child = child->fold_transformations(arena);
+
+  if (not child->absorb_transformation(inverse)) {
+    return this;
+  }
+
+  return child;
+}
+
+void Transformation::children(std::vector<const BaseObject*>& dest) const {
+  dest.push_back(child);
+}
+
 const Eigen::Transform<double, 3, Eigen::Projective>& Transformation::matrix() const {
   return transformation;
 }
@@ -294,25 +803,25 @@ const Eigen::Transform<double, 3, Eigen::Projective>& Transformation::inverse_ma
 
 
 
-Combination::Combination(std::vector<BaseObject*> objects): objects(objects) {}
+Combination::Combination(const std::vector<BaseObject*>& objects, const allocator_type& allocator): objects(objects.begin(), objects.end(), allocator) {}
 
-Combination::~Combination() {
-  #ifdef DEBUG
-    std::cout << "Destructing Combination at " << this << std::endl;
-  #endif
-  
-  for (BaseObject* O : objects) {
-    if (O == nullptr) {
-      continue;
-    }
-
-    delete O;
+BaseObject* Combination::fold_transformations(Arena& arena) {
+  for (BaseObject*& O : objects) {
+    O = O->fold_transformations(arena);
   }
+
+  return this;
+}
+
+void Combination::children(std::vector<const BaseObject*>& dest) const {
+  dest.insert(dest.end(), objects.begin(), objects.end());
 }
 
-Union::Union(std::vector<BaseObject*> objects): Combination(objects) {}
+Union::Union(const std::vector<BaseObject*>& objects, const allocator_type& allocator): Combination(objects, allocator) {}
 
 bool Union::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   bool found = false;
   for (BaseObject* O : objects) {
     bool foundO = O->intersect(r, inverse_transform, dest);
@@ -323,6 +832,8 @@ bool Union::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Pro
 }
 
 bool Union::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   for (BaseObject* O : objects) {
     if (O->included(point, inverse_transform)) {
       return true;
@@ -332,10 +843,28 @@ bool Union::included(const Eigen::Vector4d& point, const Eigen::Transform<double
   return false;  
 }
 
+BoundingBox Union::bounds() const {
+  BoundingBox box;
+
+  for (BaseObject* O : objects) {
+    box = box.merged(O->bounds());
+  }
+
+  return box;
+}
 
-Intersection::Intersection(std::vector<BaseObject*> objects): Combination(objects) {}
+void Union::split(std::vector<const BaseObject*>& parts) const {
+  for (BaseObject* O : objects) {
+    O->split(parts);
+  }
+}
+
+
+Intersection::Intersection(const std::vector<BaseObject*>& objects, const allocator_type& allocator): Combination(objects, allocator) {}
 
 bool Intersection::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   bool found = false;
 
   for (BaseObject* O1 : objects) {
@@ -350,6 +879,7 @@ bool Intersection::intersect(const Ray& r, const Eigen::Transform<double, 3, Eig
           continue;
         }
 
+        RenderStats::count_csg_test();
         if (!O2->included(p.point)) {
           available = false;
           break;
@@ -367,6 +897,8 @@ bool Intersection::intersect(const Ray& r, const Eigen::Transform<double, 3, Eig
 }
 
 bool Intersection::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   if (objects.empty()) {
     return false;
   }
@@ -380,10 +912,47 @@ bool Intersection::included(const Eigen::Vector4d& point, const Eigen::Transform
   return true;
 }
 
+BaseObject* Intersection::fold_transformations(Arena& arena) {
+  Combination::fold_transformations(arena);
+
+  std::vector<const HalfSpace*> half_spaces;
+  for (BaseObject* O : objects) {
+    const HalfSpace* half_space = dynamic_cast<const HalfSpace*>(O);
+
+    if (half_space == nullptr) {
+      return this;
+    }
+
+    half_spaces.push_back(half_space);
+  }
+
+  if (half_spaces.empty()) {
+    return this;
+  }
+
+  return arena.create<ConvexPolyhedron>(half_spaces);
+}
+
+BoundingBox Intersection::bounds() const {
+  if (objects.empty()) {
+    return BoundingBox();
+  }
+
+  BoundingBox box = BoundingBox::infinite();
 
-Exclusion::Exclusion(std::vector<BaseObject*> objects): Combination(objects) {}
+  for (BaseObject* O : objects) {
+    box = box.intersected(O->bounds());
+  }
+
+  return box;
+}
+
+
+Exclusion::Exclusion(const std::vector<BaseObject*>& objects, const allocator_type& allocator): Combination(objects, allocator) {}
 
 bool Exclusion::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   bool found = false;
   
   for (BaseObject* O1 : objects) {
@@ -398,6 +967,7 @@ bool Exclusion::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen:
           continue;
         }
 
+        RenderStats::count_csg_test();
         if (O2->included(p.point)) {
           inclusions++;
         }
@@ -414,6 +984,8 @@ bool Exclusion::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen:
 }
 
 bool Exclusion::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   bool inc = false;
 
   for (BaseObject* O : objects) {
@@ -430,10 +1002,22 @@ bool Exclusion::included(const Eigen::Vector4d& point, const Eigen::Transform<do
   return inc;
 }
 
+BoundingBox Exclusion::bounds() const {
+  BoundingBox box;
 
-Subtraction::Subtraction(std::vector<BaseObject*> objects): Combination(objects) {}
+  for (BaseObject* O : objects) {
+    box = box.merged(O->bounds());
+  }
+
+  return box;
+}
+
+
+Subtraction::Subtraction(const std::vector<BaseObject*>& objects, const allocator_type& allocator): Combination(objects, allocator) {}
 
 bool Subtraction::intersect(const Ray& r, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform, std::vector<IntersectionPoint>& dest) const {
+  PROFILE_NODE_INTERSECT(dest);
+
   if (objects.empty()) {
     return false;
   }
@@ -450,6 +1034,7 @@ bool Subtraction::intersect(const Ray& r, const Eigen::Transform<double, 3, Eige
         continue;
       }
 
+      RenderStats::count_csg_test();
       if (O2->included(p.point)) {
         available = false;
         break;
@@ -471,6 +1056,7 @@ bool Subtraction::intersect(const Ray& r, const Eigen::Transform<double, 3, Eige
     O2->intersect(r, inverse_transform, O2_points);
 
     for (IntersectionPoint& p : O2_points) {
+      RenderStats::count_csg_test();
       if (objects[0]->included(p.point)) {
         found = true;
         dest.push_back(p);
@@ -482,6 +1068,8 @@ bool Subtraction::intersect(const Ray& r, const Eigen::Transform<double, 3, Eige
 }
 
 bool Subtraction::included(const Eigen::Vector4d& point, const Eigen::Transform<double, 3, Eigen::Projective>& inverse_transform) const {
+  PROFILE_NODE_INCLUDED();
+
   if (objects.empty()) {
     return false;
   }
@@ -501,4 +1089,12 @@ bool Subtraction::included(const Eigen::Vector4d& point, const Eigen::Transform<
   }
 
   return true;
+}
+
+BoundingBox Subtraction::bounds() const {
+  if (objects.empty()) {
+    return BoundingBox();
+  }
+
+  return objects[0]->bounds();
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include <occluder_cache.hpp>
+
+double OccluderReport::hit_rate() const {
+  if (cached_tests == 0) {
+    return 0;
+  }
+
+  return (double) cache_hits / cached_tests;
+}
+
+double OccluderReport::occlusion_rate() const {
+  if (shadow_rays == 0) {
+    return 0;
+  }
+
+  return (double) occluded_rays / shadow_rays;
+}
+
+OccluderReport& OccluderReport::operator+=(const OccluderReport& other) {
+  shadow_rays += other.shadow_rays;
+  occluded_rays += other.occluded_rays;
+  cached_tests += other.cached_tests;
+  cache_hits += other.cache_hits;
+
+  return *this;
+}
+
+std::ostream& operator<<(std::ostream& out, const OccluderReport& report) {
+  out << "tested shadow rays:      " << report.shadow_rays << "\n"
+      << "blocked shadow rays:     " << report.occluded_rays << " (" << 100 * report.occlusion_rate() << "%)\n"
+      << "tested cached occluders: " << report.cached_tests << "\n"
+      << "blocked by cached ones:  " << report.cache_hits << " (" << 100 * report.hit_rate() << "%)";
+
+  return out;
+}
+
+
+OccluderCache::OccluderCache(unsigned sources): occluders(sources, NO_OCCLUDER), counts() {}
+
+OccluderCache::OccluderCache(): OccluderCache(0) {}
+
+bool OccluderCache::occluded(const RootObject& objects, const Ray& r, double distance, unsigned source) {
+  counts.shadow_rays++;
+
+  unsigned& cached = occluders.at(source);
+  if (cached != NO_OCCLUDER) {
+    counts.cached_tests++;
+
+    if (objects.occluded_by(r, distance, cached)) {
+      counts.cache_hits++;
+      counts.occluded_rays++;
+      return true;
+    }
+  }
+
+  // the cached occluder is kept on a miss, as the next hit point may well be behind it again
+  unsigned occluder;
+  if (objects.occluded(r, distance, occluder, cached)) {
+    cached = occluder;
+    counts.occluded_rays++;
+    return true;
+  }
+
+  return false;
+}
+
+const OccluderReport& OccluderCache::report() const {
+  return counts;
+}
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <numeric>
+
+#include <optimizer.hpp>
+#include <objects.hpp>
+#include <timeline.hpp>
+
+/**
+ * \brief Estimated probability that a point lying somewhere in region is also inside of box.
+ *
+ * Without a finite, non-zero volume of region nothing can be said and 0.5 is returned.
+ */
+static double containment_probability(const BoundingBox& box, const BoundingBox& region) {
+  double region_volume = region.volume();
+
+  if (std::isinf(region_volume) or region_volume == 0) {
+    return 0.5;
+  }
+
+  return box.intersected(region).volume() / region_volume;
+}
+
+/**
+ * \brief Stable sort of objects[first:] in ascending order of cost / probability.
+ *
+ * \returns True, if the order changed.
+ */
+static bool sort_by_cost_and_probability(std::pmr::vector<BaseObject*>& objects, unsigned first, const std::vector<double>& probability) {
+  std::vector<double> key(objects.size());
+  for (unsigned i = first; i < objects.size(); i++) {
+    key[i] = probability[i] > 0 ? objects[i]->cost() / probability[i] : std::numeric_limits<double>::infinity();
+  }
+
+  std::vector<unsigned> order(objects.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin() + first, order.end(), [&key](unsigned a, unsigned b) {
+    return key[a] < key[b];
+  });
+
+  if (std::is_sorted(order.begin(), order.end())) {
+    return false;
+  }
+
+  std::vector<BaseObject*> sorted;
+  for (unsigned i : order) {
+    sorted.push_back(objects[i]);
+  }
+  objects.assign(sorted.begin(), sorted.end());
+
+  return true;
+}
+
+
+bool OptimizerReport::changed() const {
+  return flattened_combinations + collapsed_combinations + removed_transformations + merged_transformations
+         + reordered_combinations + removed_subtrees > 0;
+}
+
+std::ostream& operator<<(std::ostream& out, const OptimizerReport& report) {
+  out << "flattened combinations:  " << report.flattened_combinations << "\n"
+      << "collapsed combinations:  " << report.collapsed_combinations << "\n"
+      << "removed transformations: " << report.removed_transformations << "\n"
+      << "merged transformations:  " << report.merged_transformations << "\n"
+      << "reordered combinations:  " << report.reordered_combinations << "\n"
+      << "removed empty subtrees:  " << report.removed_subtrees;
+
+  return out;
+}
+
+
+double BaseObject::cost() const {
+  return 1;
+}
+
+BaseObject* BaseObject::optimize(OptimizerReport& report) {
+  if (bounds().empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  return this;
+}
+
+OptimizerReport RootObject::optimize(Arena& arena) {
+  OptimizerReport report;
+
+  {
+    TimelineSpan span("simplify", "optimizer");
+    child = child->optimize(report);
+
+    if (child == nullptr) { // the whole scene is empty
+      child = arena.create<Union>(std::vector<BaseObject*>());
+    }
+  }
+
+  TimelineSpan span("split", "acceleration");
+  split();
+
+  return report;
+}
+
+
+double DistanceField::cost() const {
+  // a Ray typically needs a few dozen steps, each evaluating every instruction
+  return 8.0 * program.size();
+}
+
+
+double Transformation::cost() const {
+  return child->cost() + 0.5;
+}
+
+BaseObject* Transformation::optimize(OptimizerReport& report) {
+  child = child->optimize(report);
+
+  if (child == nullptr) {
+    return nullptr;
+  }
+
+  // the child is already optimized, so there is at most one directly following Transformation
+  Transformation* inner = dynamic_cast<Transformation*>(child);
+  if (inner != nullptr) {
+    transformation = transformation * inner->transformation;
+    inverse = inner->inverse * inverse;
+
+    child = inner->child;
+
+    report.merged_transformations++;
+  }
+
+  if (transformation.matrix().isIdentity(EPSILON)) {
+    report.removed_transformations++;
+    return child;
+  }
+
+  return this;
+}
+
+
+double Combination::cost() const {
+  double sum = 0;
+
+  for (BaseObject* O : objects) {
+    sum += O->cost();
+  }
+
+  return sum;
+}
+
+void Combination::optimize_objects(OptimizerReport& report) {
+  for (BaseObject*& O : objects) {
+    O = O->optimize(report);
+  }
+}
+
+
+BaseObject* Union::optimize(OptimizerReport& report) {
+  if (objects.empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  optimize_objects(report);
+
+  std::vector<BaseObject*> flattened;
+  for (BaseObject* O : objects) {
+    if (O == nullptr) {
+      continue;
+    }
+
+    Union* inner = dynamic_cast<Union*>(O);
+    if (inner == nullptr) {
+      flattened.push_back(O);
+      continue;
+    }
+
+    flattened.insert(flattened.end(), inner->objects.begin(), inner->objects.end());
+
+    report.flattened_combinations++;
+  }
+  objects.assign(flattened.begin(), flattened.end());
+
+  if (objects.empty()) {
+    return nullptr;
+  }
+
+  if (objects.size() == 1) {
+    report.collapsed_combinations++;
+    return objects[0];
+  }
+
+  return this;
+}
+
+
+double Intersection::cost() const {
+  // every found point is checked against the remaining objects
+  return Combination::cost() * objects.size();
+}
+
+BaseObject* Intersection::optimize(OptimizerReport& report) {
+  if (objects.empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  optimize_objects(report);
+
+  if (std::find(objects.begin(), objects.end(), nullptr) != objects.end()) { // intersection with an empty object
+    return nullptr;
+  }
+
+  std::vector<BaseObject*> flattened;
+  for (BaseObject* O : objects) {
+    Intersection* inner = dynamic_cast<Intersection*>(O);
+    if (inner == nullptr) {
+      flattened.push_back(O);
+      continue;
+    }
+
+    flattened.insert(flattened.end(), inner->objects.begin(), inner->objects.end());
+
+    report.flattened_combinations++;
+  }
+  objects.assign(flattened.begin(), flattened.end());
+
+  if (bounds().empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  if (objects.size() == 1) {
+    report.collapsed_combinations++;
+    return objects[0];
+  }
+
+  BoundingBox region;
+  for (BaseObject* O : objects) {
+    region = region.merged(O->bounds());
+  }
+
+  std::vector<double> probability;
+  for (BaseObject* O : objects) {
+    BoundingBox box = O->bounds();
+
+    if (box.finite() and not region.finite()) { // a bounded object rejects almost all of an unbounded region
+      probability.push_back(1);
+    }
+    else {
+      probability.push_back(1 - containment_probability(box, region));
+    }
+  }
+
+  if (sort_by_cost_and_probability(objects, 0, probability)) {
+    report.reordered_combinations++;
+  }
+
+  return this;
+}
+
+
+double Exclusion::cost() const {
+  return Combination::cost() * objects.size();
+}
+
+BaseObject* Exclusion::optimize(OptimizerReport& report) {
+  if (objects.empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  optimize_objects(report);
+  objects.erase(std::remove(objects.begin(), objects.end(), nullptr), objects.end());
+
+  if (objects.empty()) {
+    return nullptr;
+  }
+
+  if (objects.size() == 1) {
+    report.collapsed_combinations++;
+    return objects[0];
+  }
+
+  return this;
+}
+
+
+double Subtraction::cost() const {
+  return Combination::cost() * objects.size();
+}
+
+BaseObject* Subtraction::optimize(OptimizerReport& report) {
+  if (objects.empty()) {
+    report.removed_subtrees++;
+    return nullptr;
+  }
+
+  optimize_objects(report);
+
+  if (objects[0] == nullptr) {
+    return nullptr;
+  }
+
+  BoundingBox region = objects[0]->bounds();
+
+  std::vector<BaseObject*> relevant = {objects[0]};
+  for (unsigned i = 1; i < objects.size(); i++) {
+    if (objects[i] == nullptr) {
+      continue;
+    }
+
+    if (objects[i]->bounds().intersected(region).empty()) { // can not remove anything from objects[0]
+      report.removed_subtrees++;
+      continue;
+    }
+
+    relevant.push_back(objects[i]);
+  }
+  objects.assign(relevant.begin(), relevant.end());
+
+  if (objects.size() == 1) {
+    report.collapsed_combinations++;
+    return objects[0];
+  }
+
+  std::vector<double> probability = {0};
+  for (unsigned i = 1; i < objects.size(); i++) {
+    // a point of objects[0] is removed, if it lies inside objects[i]
+    probability.push_back(containment_probability(objects[i]->bounds(), region));
+  }
+
+  if (sort_by_cost_and_probability(objects, 1, probability)) {
+    report.reordered_combinations++;
+  }
+
+  return this;
+}
@@ -0,0 +1,5 @@
+#include <pixel_cost.hpp>
+
+const std::string PixelCost::channel_names = "primary shadow secondary included seconds";
+
+thread_local PixelCost* PixelCost::recording = nullptr;
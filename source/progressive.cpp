@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+
+#include <progressive.hpp>
+#include <scene.hpp>
+
+/**
+ * \brief How far a pixel is rendered by Scene::generate_progressive().
+ */
+enum PixelState : unsigned char {
+  /** \brief The pixel takes the color of a neighbor. */
+  UNTRACED = 0,
+  /** \brief The pixel is traced through its center, but waits for anti-aliasing. */
+  CENTERED = 1,
+  /** \brief The pixel has all of its samples. */
+  FINISHED = 2
+};
+
+ProgressiveFrame Scene::generate_progressive(const RenderOptions& options, const std::function<void(const ProgressiveFrame&)>& callback) {
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start = clock::now();
+  TimelineSpan span("render", "render");
+  clock::time_point mark = start;
+
+  begin_render(options);
+  render_stats.add_phase("setup", mark);
+
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+  unsigned pixels = rows * columns;
+  bool antialiased = std::max(options.min_samples, options.max_samples) > 1;
+
+  std::vector<LightIntensity> values(pixels);
+  std::vector<unsigned char> state(pixels, UNTRACED);
+  unsigned finished = 0;
+  std::vector<unsigned> steps; // of all started passes, coarse to fine
+  unsigned passes = 0;
+
+  auto elapsed = [start]() {
+    return std::chrono::duration<double>(clock::now() - start).count();
+  };
+
+  auto done = [&]() {
+    return (float) finished / pixels >= options.coverage_target or (options.time_budget > 0 and elapsed() >= options.time_budget);
+  };
+
+  auto frame = [&]() {
+    ProgressiveFrame F;
+    F.image = cv::Mat_<cv::Vec3b>(rows, columns);
+    F.coverage = cv::Mat_<cv::Vec3b>(rows, columns);
+
+    // the frame is written in its memory order, its first row shows the last row of the screen
+    for (unsigned r = 0; r < rows; r++) {
+      for (unsigned j = 0; j < columns; j++) {
+        unsigned i = rows - r - 1;
+        unsigned p = i * columns + j;
+
+        // the finest traced pixel of the block containing p, the first pass covers every block
+        LightIntensity val = values[p];
+        for (auto step = steps.rbegin(); state[p] == UNTRACED and step != steps.rend(); step++) {
+          unsigned q = (i - i % *step) * columns + j - j % *step;
+          if (state[q] != UNTRACED) {
+            val = values[q];
+            break;
+          }
+        }
+
+        float shade = state[p] / 2.0;
+        store_pixel(F.image, i, j, val);
+        store_pixel(F.coverage, i, j, LightIntensity(shade, shade, shade));
+      }
+    }
+
+    F.passes = passes;
+    F.finished = (float) finished / pixels;
+    F.elapsed = elapsed();
+    F.complete = finished == pixels;
+
+    return F;
+  };
+
+  bool stopped = false;
+  std::vector<LightIntensity> traced;
+
+  for (unsigned step = std::max(1u, options.progressive_step); step > 0 and not stopped; step /= 2) {
+    TimelineSpan span("pass", "render", "step", step);
+    std::vector<PixelSample> centers;
+    for (unsigned i = 0; i < rows; i += step) {
+      for (unsigned j = 0; j < columns; j += step) {
+        if (state[i * columns + j] == UNTRACED) {
+          centers.push_back({i * columns + j, 0.5, 0.5});
+        }
+      }
+    }
+
+    steps.push_back(step);
+    passes++;
+
+    for (unsigned first = 0; first < centers.size(); first += PROGRESSIVE_CHUNK) {
+      unsigned last = std::min<unsigned>(centers.size(), first + PROGRESSIVE_CHUNK);
+      std::vector<PixelSample> chunk(centers.begin() + first, centers.begin() + last);
+
+      trace_samples(chunk, traced, options);
+
+      for (unsigned s = 0; s < chunk.size(); s++) {
+        values[chunk[s].pixel] = traced[s];
+        state[chunk[s].pixel] = antialiased ? CENTERED : FINISHED;
+        finished += antialiased ? 0 : 1;
+      }
+
+      // the first pass is never interrupted, so every pixel has a color
+      if ((passes > 1 or last == centers.size()) and done()) {
+        stopped = true;
+        break;
+      }
+    }
+
+    if (not stopped and (step > 1 or antialiased) and callback) {
+      callback(frame());
+    }
+  }
+
+  render_stats.add_phase("trace", mark);
+
+  if (not stopped and antialiased) {
+    TimelineSpan span("antialias", "render");
+    std::vector<PixelSample> samples = refinement_samples(values, options);
+    passes++;
+
+    std::vector<bool> refined(pixels, false);
+    for (const PixelSample& S : samples) {
+      refined[S.pixel] = true;
+    }
+    for (unsigned p = 0; p < pixels; p++) {
+      if (not refined[p]) {
+        state[p] = FINISHED;
+        finished++;
+      }
+    }
+
+    // chunks end between two pixels, so every chunk can be averaged on its own
+    unsigned first = 0;
+    while (first < samples.size() and not done()) {
+      unsigned last = std::min<unsigned>(samples.size(), first + PROGRESSIVE_CHUNK);
+      while (last < samples.size() and samples[last].pixel == samples[last - 1].pixel) {
+        last++;
+      }
+      std::vector<PixelSample> chunk(samples.begin() + first, samples.begin() + last);
+
+      trace_samples(chunk, traced, options);
+      average_samples(chunk, traced, values);
+
+      for (unsigned s = 0; s < chunk.size(); s++) {
+        if (state[chunk[s].pixel] != FINISHED) {
+          state[chunk[s].pixel] = FINISHED;
+          finished++;
+        }
+      }
+
+      first = last;
+    }
+
+    render_stats.add_phase("antialias", mark);
+  }
+
+  ProgressiveFrame F = frame();
+  if (callback) {
+    callback(F);
+  }
+
+  end_render(options);
+
+  return F;
+}
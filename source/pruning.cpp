@@ -0,0 +1,14 @@
+#include <pruning.hpp>
+
+unsigned long PruningReport::pruned() const {
+  return black_rays + negligible_rays + roulette_rays;
+}
+
+std::ostream& operator<<(std::ostream& out, const PruningReport& report) {
+  out << "traced secondary rays:   " << report.traced_rays << "\n"
+      << "skipped black rays:      " << report.black_rays << "\n"
+      << "skipped negligible rays: " << report.negligible_rays << "\n"
+      << "terminated by roulette:  " << report.roulette_rays;
+
+  return out;
+}
@@ -0,0 +1,88 @@
+#include <render.hpp>
+
+/**
+ * \brief Every second bit of code, starting at the lowest, moved together.
+ */
+static unsigned compact_bits(unsigned code) {
+  code &= 0x55555555;
+  code = (code | (code >> 1)) & 0x33333333;
+  code = (code | (code >> 2)) & 0x0f0f0f0f;
+  code = (code | (code >> 4)) & 0x00ff00ff;
+  code = (code | (code >> 8)) & 0x0000ffff;
+
+  return code;
+}
+
+/**
+ * \brief Position (x, y) of step d on the Hilbert curve through a square of side x side cells, side a power of 2.
+ */
+static void hilbert_position(unsigned side, unsigned d, unsigned& x, unsigned& y) {
+  x = 0;
+  y = 0;
+
+  for (unsigned s = 1; s < side; s *= 2) {
+    unsigned rx = 1 & (d / 2);
+    unsigned ry = 1 & (d ^ rx);
+
+    // the sub-curves of the lower quadrants are rotated, so the curve stays connected
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+
+    x += s * rx;
+    y += s * ry;
+    d /= 4;
+  }
+}
+
+
+std::vector<unsigned> pixel_traversal(unsigned rows, unsigned columns, PixelOrder order, unsigned tile_size) {
+  unsigned tile_rows = tile_size > 0 ? tile_size : rows;
+  unsigned tile_columns = tile_size > 0 ? tile_size : columns;
+
+  std::vector<unsigned> pixels;
+  pixels.reserve((std::size_t) rows * columns);
+
+  for (unsigned i0 = 0; i0 < rows; i0 += tile_rows) {
+    for (unsigned j0 = 0; j0 < columns; j0 += tile_columns) {
+      unsigned height = std::min(tile_rows, rows - i0);
+      unsigned width = std::min(tile_columns, columns - j0);
+
+      if (order == PixelOrder::SCANLINE) {
+        for (unsigned i = i0; i < i0 + height; i++) {
+          for (unsigned j = j0; j < j0 + width; j++) {
+            pixels.push_back(i * columns + j);
+          }
+        }
+        continue;
+      }
+
+      // both curves fill a square of a power of 2, the steps outside of the tile are skipped
+      unsigned side = 1;
+      while (side < std::max(height, width)) {
+        side *= 2;
+      }
+
+      for (unsigned long d = 0; d < (unsigned long) side * side; d++) {
+        unsigned x, y;
+        if (order == PixelOrder::MORTON) {
+          x = compact_bits(d);
+          y = compact_bits(d >> 1);
+        }
+        else {
+          hilbert_position(side, d, x, y);
+        }
+
+        if (y < height and x < width) {
+          pixels.push_back((i0 + y) * columns + j0 + x);
+        }
+      }
+    }
+  }
+
+  return pixels;
+}
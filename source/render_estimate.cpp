@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include <render_estimate.hpp>
+#include <scene.hpp>
+
+/**
+ * \brief Mean of values and half the width of its confidence interval, for values drawn without replacement from population.
+ */
+static std::pair<double, double> mean_interval(const std::vector<double>& values, unsigned long population) {
+  unsigned n = values.size();
+  if (n == 0) {
+    return {0, 0};
+  }
+
+  double mean = 0;
+  for (double v : values) {
+    mean += v;
+  }
+  mean /= n;
+
+  if (n < 2) {
+    return {mean, 0};
+  }
+
+  double variance = 0;
+  for (double v : values) {
+    variance += (v - mean) * (v - mean);
+  }
+  variance /= n - 1;
+
+  // the finite population correction, sampling every stratum makes the estimate exact
+  double correction = population > 1 ? std::max(0.0, (double) (population - n) / (population - 1)) : 0;
+
+  return {mean, ESTIMATE_Z * std::sqrt(variance / n * correction)};
+}
+
+/**
+ * \brief Total of a per sample quantity over all samples of the image, given the interval of the number of samples.
+ */
+static EstimateInterval extrapolate(const std::pair<double, double>& per_sample, const EstimateInterval& samples) {
+  auto [mean, half_width] = per_sample;
+
+  return {samples.value * mean, samples.low * std::max(0.0, mean - half_width), samples.high * (mean + half_width)};
+}
+
+
+nlohmann::json EstimateInterval::json() const {
+  return {{"value", value}, {"low", low}, {"high", high}};
+}
+
+nlohmann::json RenderEstimate::json() const {
+  return {
+    {"confidence", ESTIMATE_CONFIDENCE},
+    {"pixels", pixels},
+    {"strata", strata},
+    {"traced_pixels", traced_pixels},
+    {"refined_fraction", refined_fraction.json()},
+    {"samples_per_pixel", samples_per_pixel.json()},
+    {"rays", {{"primary", primary_rays.json()}, {"secondary", secondary_rays.json()}, {"shadow", shadow_rays.json()}}},
+    {"csg_tests", csg_tests.json()},
+    {"seconds", seconds.json()},
+    {"memory_kb", memory_kb},
+    {"sampling_seconds", sampling_seconds}
+  };
+}
+
+std::ostream& operator<<(std::ostream& out, const RenderEstimate& estimate) {
+  auto interval = [&out](const EstimateInterval& I) {
+    out << std::llround(I.value) << " (" << std::llround(I.low) << " - " << std::llround(I.high) << ")";
+  };
+
+  out << "render time:     " << estimate.seconds.value << "s (" << estimate.seconds.low << "s - " << estimate.seconds.high << "s)\n";
+  out << "primary rays:    ";
+  interval(estimate.primary_rays);
+  out << "\nsecondary rays:  ";
+  interval(estimate.secondary_rays);
+  out << "\nshadow rays:     ";
+  interval(estimate.shadow_rays);
+  out << "\nCSG tests:       ";
+  interval(estimate.csg_tests);
+  out << "\npeak memory:     " << estimate.memory_kb << " kB\n"
+      << "traced " << estimate.traced_pixels << " of " << estimate.pixels << " pixels in " << estimate.sampling_seconds << "s, "
+      << "intervals at " << 100 * ESTIMATE_CONFIDENCE << "% confidence";
+
+  return out;
+}
+
+
+RenderEstimate Scene::estimate(const RenderOptions& options, float fraction) {
+  TimelineSpan span("estimate", "render");
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+  unsigned long pixels = (unsigned long) rows * columns;
+  bool antialiased = std::max(options.min_samples, options.max_samples) > 1;
+
+  RenderEstimate E;
+  E.pixels = pixels;
+  if (pixels == 0) {
+    return E;
+  }
+
+  // the costs of every traced pixel are recorded like for the cost map
+  RenderOptions sampling = options;
+  sampling.mode = RenderMode::PIXEL;
+  sampling.cost_map = true;
+  begin_render(sampling);
+
+  // one random pixel of every stratum, together with its neighbors, if their contrast decides about anti-aliasing
+  unsigned long wanted = std::clamp<unsigned long>(std::ceil(fraction * pixels), std::min<unsigned long>(ESTIMATE_MIN_STRATA, pixels), pixels);
+  unsigned side = std::max(1.0, std::floor(std::sqrt((double) pixels / wanted)));
+
+  std::minstd_rand random(ESTIMATE_SEED);
+  std::vector<unsigned> chosen;
+  for (unsigned i0 = 0; i0 < rows; i0 += side) {
+    for (unsigned j0 = 0; j0 < columns; j0 += side) {
+      std::uniform_int_distribution<unsigned> row(i0, std::min(rows, i0 + side) - 1);
+      std::uniform_int_distribution<unsigned> column(j0, std::min(columns, j0 + side) - 1);
+
+      unsigned i = row(random);
+      unsigned j = column(random);
+      chosen.push_back(i * columns + j);
+    }
+  }
+
+  auto neighbors = [rows, columns](unsigned p) {
+    unsigned i = p / columns;
+    unsigned j = p % columns;
+
+    return std::array<unsigned, 4>{i > 0 ? p - columns : p, i + 1 < rows ? p + columns : p, j > 0 ? p - 1 : p, j + 1 < columns ? p + 1 : p};
+  };
+
+  std::vector<unsigned> traced = chosen;
+  if (antialiased) {
+    for (unsigned p : chosen) {
+      for (unsigned q : neighbors(p)) {
+        traced.push_back(q);
+      }
+    }
+  }
+  std::sort(traced.begin(), traced.end());
+  traced.erase(std::unique(traced.begin(), traced.end()), traced.end());
+
+  std::vector<PixelSample> samples;
+  for (unsigned p : traced) {
+    samples.push_back({p, 0.5, 0.5});
+  }
+
+  std::vector<LightIntensity> traced_values;
+  trace_samples(samples, traced_values, sampling);
+
+  std::vector<LightIntensity> values(pixels);
+  for (unsigned s = 0; s < samples.size(); s++) {
+    values[samples[s].pixel] = traced_values[s];
+  }
+
+  // every stratum is a single observation: the average cost of its traced pixels, and whether its pixel is refined
+  std::vector<double> refined, seconds, secondary, shadow, csg;
+  for (unsigned p : chosen) {
+    std::vector<unsigned> group = {p};
+    float contrast = 0;
+
+    if (antialiased) {
+      for (unsigned q : neighbors(p)) {
+        group.push_back(q);
+        for (unsigned k = 0; k < NUM_COL; k++) {
+          contrast = std::max(contrast, std::abs(values[p].at(k) - values[q].at(k)));
+        }
+      }
+    }
+    std::sort(group.begin(), group.end());
+    group.erase(std::unique(group.begin(), group.end()), group.end());
+
+    double group_seconds = 0, group_secondary = 0, group_shadow = 0, group_csg = 0;
+    for (unsigned q : group) {
+      group_seconds += pixel_costs[q].seconds;
+      group_secondary += pixel_costs[q].secondary;
+      group_shadow += pixel_costs[q].shadow;
+      group_csg += pixel_costs[q].included;
+    }
+
+    refined.push_back(contrast > options.contrast_threshold ? 1 : 0);
+    seconds.push_back(group_seconds / group.size());
+    secondary.push_back(group_secondary / group.size());
+    shadow.push_back(group_shadow / group.size());
+    csg.push_back(group_csg / group.size());
+  }
+
+  E.strata = chosen.size();
+  E.traced_pixels = traced.size();
+
+  // the samples of a pixel: its center, and a square grid of anti-aliasing samples, see refinement_samples()
+  auto grid = [](unsigned needed) {
+    unsigned strata = std::sqrt(needed);
+    return strata < 2 ? 0.0 : (double) strata * strata;
+  };
+  double flat_samples = 1 + grid(options.min_samples);
+  double refined_samples = 1 + grid(std::max(options.min_samples, options.max_samples));
+
+  auto [fraction_mean, fraction_half_width] = mean_interval(refined, pixels);
+  if (antialiased) {
+    E.refined_fraction = {fraction_mean, std::max(0.0, fraction_mean - fraction_half_width), std::min(1.0, fraction_mean + fraction_half_width)};
+  }
+
+  auto per_pixel = [flat_samples, refined_samples](double f) {
+    return (1 - f) * flat_samples + f * refined_samples;
+  };
+  E.samples_per_pixel = {per_pixel(E.refined_fraction.value), per_pixel(E.refined_fraction.low), per_pixel(E.refined_fraction.high)};
+  E.primary_rays = {pixels * E.samples_per_pixel.value, pixels * E.samples_per_pixel.low, pixels * E.samples_per_pixel.high};
+
+  // every anti-aliasing sample is assumed to cost as much as the center of a pixel
+  E.secondary_rays = extrapolate(mean_interval(secondary, pixels), E.primary_rays);
+  E.shadow_rays = extrapolate(mean_interval(shadow, pixels), E.primary_rays);
+  E.csg_tests = extrapolate(mean_interval(csg, pixels), E.primary_rays);
+  E.seconds = extrapolate(mean_interval(seconds, pixels), E.primary_rays);
+
+  double bytes = pixels * (sizeof(cv::Vec3b) + sizeof(LightIntensity) + sizeof(PixelSample) + sizeof(unsigned) + (options.cost_map ? sizeof(PixelCost) : 0))
+               + (E.primary_rays.value - pixels) * (sizeof(LightIntensity) + sizeof(PixelSample));
+
+  if (options.mode == RenderMode::WAVEFRONT) {
+    unsigned threads = options.thread_count();
+    E.seconds = {E.seconds.value / threads, E.seconds.low / threads, E.seconds.high / threads};
+
+    double batch = std::min<double>(std::max(1u, options.batch_size), E.primary_rays.value);
+    double shadows_per_sample = E.primary_rays.value > 0 ? E.shadow_rays.value / E.primary_rays.value : 0;
+    bytes += batch * ((max_recursion_depth + 1) * sizeof(WavefrontRay) + shadows_per_sample * sizeof(ShadowRay));
+  }
+
+  end_render(sampling);
+  pixel_costs.clear();
+
+  E.memory_kb = RenderStats::peak_memory() + (long) (bytes / 1024);
+  E.sampling_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  return E;
+}
@@ -0,0 +1,156 @@
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+
+#include <render_stats.hpp>
+
+/**
+ * \brief Writes the HELP and TYPE lines of a Prometheus metric.
+ */
+static void prometheus_header(std::ostream& out, const std::string& metric, const std::string& type, const std::string& help) {
+  out << "# HELP " << metric << " " << help << "\n"
+      << "# TYPE " << metric << " " << type << "\n";
+}
+
+/**
+ * \brief Writes a single Prometheus sample, labels is a list of name="value" pairs without braces.
+ */
+static void prometheus_sample(std::ostream& out, const std::string& metric, std::string labels, const std::string& scene, double value) {
+  if (not scene.empty()) {
+    labels = "scene=\"" + scene + "\"" + (labels.empty() ? "" : "," + labels);
+  }
+
+  std::ostringstream number;
+  number << std::setprecision(17) << value;
+
+  out << metric << (labels.empty() ? "" : "{" + labels + "}") << " " << number.str() << "\n";
+}
+
+
+std::atomic<unsigned long> RenderStats::finished_csg_tests(0);
+thread_local RenderStats::ThreadCsgTests RenderStats::local_csg_tests;
+
+RenderStats::ThreadCsgTests::~ThreadCsgTests() {
+  finished_csg_tests += count;
+}
+
+unsigned long RenderStats::csg_test_count() {
+  return finished_csg_tests + local_csg_tests.count;
+}
+
+void RenderStats::reset_csg_tests() {
+  finished_csg_tests = 0;
+  local_csg_tests.count = 0;
+}
+
+long RenderStats::peak_memory() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+double RenderStats::occlusion_rate() const {
+  if (shadow_rays == 0) {
+    return 0;
+  }
+
+  return (double) occluded_rays / shadow_rays;
+}
+
+double RenderStats::hit_rate() const {
+  if (primary_rays + secondary_rays == 0) {
+    return 0;
+  }
+
+  return (double) hits / (primary_rays + secondary_rays);
+}
+
+double RenderStats::seconds() const {
+  double total = 0;
+  for (const auto& [_, phase_seconds] : phases) {
+    total += phase_seconds;
+  }
+
+  return total;
+}
+
+void RenderStats::add_phase(const std::string& name, std::chrono::steady_clock::time_point& mark) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  phases.emplace_back(name, std::chrono::duration<double>(now - mark).count());
+  mark = now;
+}
+
+nlohmann::json RenderStats::json() const {
+  nlohmann::json phase_data = nlohmann::json::object();
+  for (const auto& [name, phase_seconds] : phases) {
+    phase_data[name] = phase_seconds;
+  }
+
+  return {
+    {"rays", {{"primary", primary_rays}, {"secondary", secondary_rays}, {"shadow", shadow_rays}}},
+    {"hits", hits},
+    {"hit_rate", hit_rate()},
+    {"max_depth", max_depth},
+    {"csg_tests", csg_tests},
+    {"occluded_shadow_rays", occluded_rays},
+    {"occlusion_rate", occlusion_rate()},
+    {"phases", phase_data},
+    {"seconds", seconds()},
+    {"peak_memory_kb", peak_memory_kb}
+  };
+}
+
+void RenderStats::write_prometheus(std::ostream& out, const std::string& scene) const {
+  prometheus_header(out, "raytracing_rays_total", "counter", "Rays traced during the render, by type.");
+  prometheus_sample(out, "raytracing_rays_total", "type=\"primary\"", scene, primary_rays);
+  prometheus_sample(out, "raytracing_rays_total", "type=\"secondary\"", scene, secondary_rays);
+  prometheus_sample(out, "raytracing_rays_total", "type=\"shadow\"", scene, shadow_rays);
+
+  prometheus_header(out, "raytracing_hits_total", "counter", "Primary and secondary rays, that hit the scene.");
+  prometheus_sample(out, "raytracing_hits_total", "", scene, hits);
+
+  prometheus_header(out, "raytracing_max_depth", "gauge", "Largest recursion depth of a traced ray.");
+  prometheus_sample(out, "raytracing_max_depth", "", scene, max_depth);
+
+  prometheus_header(out, "raytracing_csg_tests_total", "counter", "Points tested by CSG combinations for being included in one of their elements.");
+  prometheus_sample(out, "raytracing_csg_tests_total", "", scene, csg_tests);
+
+  prometheus_header(out, "raytracing_occluded_shadow_rays_total", "counter", "Shadow rays blocked by the scene.");
+  prometheus_sample(out, "raytracing_occluded_shadow_rays_total", "", scene, occluded_rays);
+
+  prometheus_header(out, "raytracing_occlusion_ratio", "gauge", "Fraction of the shadow rays blocked by the scene.");
+  prometheus_sample(out, "raytracing_occlusion_ratio", "", scene, occlusion_rate());
+
+  prometheus_header(out, "raytracing_phase_seconds", "gauge", "Wall-clock seconds of every phase of the render.");
+  for (const auto& [name, phase_seconds] : phases) {
+    prometheus_sample(out, "raytracing_phase_seconds", "phase=\"" + name + "\"", scene, phase_seconds);
+  }
+
+  prometheus_header(out, "raytracing_render_seconds", "gauge", "Wall-clock seconds of the whole render.");
+  prometheus_sample(out, "raytracing_render_seconds", "", scene, seconds());
+
+  prometheus_header(out, "raytracing_peak_memory_bytes", "gauge", "Largest resident set size of the process.");
+  prometheus_sample(out, "raytracing_peak_memory_bytes", "", scene, 1024.0 * peak_memory_kb);
+}
+
+std::ostream& operator<<(std::ostream& out, const RenderStats& stats) {
+  out << "primary rays:        " << stats.primary_rays << "\n"
+      << "secondary rays:      " << stats.secondary_rays << "\n"
+      << "shadow rays:         " << stats.shadow_rays << " (" << 100 * stats.occlusion_rate() << "% blocked)\n"
+      << "hits:                " << stats.hits << " (" << 100 * stats.hit_rate() << "% of primary and secondary rays)\n"
+      << "deepest recursion:   " << stats.max_depth << "\n"
+      << "CSG tests:           " << stats.csg_tests << "\n";
+
+  for (const auto& [name, phase_seconds] : stats.phases) {
+    out << std::left << std::setw(21) << (name + " time:") << std::right << phase_seconds << "s\n";
+  }
+
+  out << "peak memory:         " << stats.peak_memory_kb << " kB";
+
+  return out;
+}
@@ -1,48 +1,199 @@
+#include <chrono>
+#include <cstdint>
+
 #include <scene.hpp>
 
+/**
+ * \brief False color of a cost t in [0, 1], going from black over blue, red and yellow to white.
+ */
+static LightIntensity heat_color(float t) {
+  static const std::array<LightIntensity, 5> stops = {
+    LightIntensity(0, 0, 0), LightIntensity(0, 0, 1), LightIntensity(1, 0, 0), LightIntensity(1, 1, 0), LightIntensity(1, 1, 1)
+  };
+
+  float position = std::clamp(t, 0.0f, 1.0f) * (stops.size() - 1);
+  unsigned k = std::min<unsigned>(position, stops.size() - 2);
+  float f = position - k;
+
+  return LightIntensity(
+    (1 - f) * stops[k].at(0) + f * stops[k + 1].at(0),
+    (1 - f) * stops[k].at(1) + f * stops[k + 1].at(1),
+    (1 - f) * stops[k].at(2) + f * stops[k + 1].at(2)
+  );
+}
+
+/**
+ * \brief Seed for the samples of a LightSource at a hit point, by FNV-1a hashing of their coordinates.
+ */
+static unsigned sample_seed(const Eigen::Vector4d& point, unsigned source) {
+  uint64_t hash = 14695981039346656037ull;
+
+  auto mix = [&hash](const unsigned char* bytes, size_t size) {
+    for (size_t k = 0; k < size; k++) {
+      hash = (hash ^ bytes[k]) * 1099511628211ull;
+    }
+  };
+
+  for (unsigned i = 0; i < 3; i++) {
+    double coordinate = point[i];
+    mix(reinterpret_cast<const unsigned char*>(&coordinate), sizeof(coordinate));
+  }
+  mix(reinterpret_cast<const unsigned char*>(&source), sizeof(source));
+
+  return (unsigned) (hash ^ (hash >> 32));
+}
+
+/**
+ * \brief Average of several LightSamples of an area light.
+ */
+struct AreaSum {
+  /** \brief Number of added samples. */
+  unsigned count = 0;
+  /** \brief Number of added samples, that are not occluded. */
+  unsigned lit = 0;
+  /** \brief Number of added samples, that cause a specular highlight. */
+  unsigned highlighted = 0;
+  /** \brief Sums of the diffuse and specular light per color channel. */
+  std::array<double, NUM_COL> diffuse{}, specular{};
+
+  /** \brief Adds a single sample. */
+  void add(const LightSample& sample) {
+    count++;
+
+    if (sample.lit) {
+      lit++;
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        diffuse[k] += sample.diffuse.at(k);
+      }
+    }
+    if (sample.highlighted) {
+      highlighted++;
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        specular[k] += sample.specular.at(k);
+      }
+    }
+  }
+
+  /** \brief Average of all added samples, occluded ones count as dark. */
+  LightSample average() const {
+    LightSample sample;
+    std::array<float, NUM_COL> rgb;
+
+    sample.lit = lit > 0;
+    for (unsigned k = 0; k < NUM_COL; k++) {
+      rgb[k] = diffuse[k] / count;
+    }
+    sample.diffuse = LightIntensity(rgb);
+
+    sample.highlighted = highlighted > 0;
+    for (unsigned k = 0; k < NUM_COL; k++) {
+      rgb[k] = specular[k] / count;
+    }
+    sample.specular = LightIntensity(rgb);
+
+    return sample;
+  }
+};
+
 Scene::Scene(float dpi, float L_x, float L_y,
             Eigen::Vector4d position, Eigen::Vector4d observer,
             LightIntensity ambient_light, float global_index,
             unsigned max_recursion_depth,
-            std::vector<LightSource*> sources, RootObject* objects):  
+            std::vector<LightSource*> sources, RootObject* objects,
+            std::unique_ptr<Arena> arena,
+            OptimizerReport optimizer_report,
+            float contribution_threshold, float roulette_threshold,
+            RenderOptions render_options):  
           dpi(dpi), L_x(L_x), L_y(L_y), position(position), observer(observer), 
           ambient_light(ambient_light), global_index(global_index), object_indexs(), 
-          max_recursion_depth(max_recursion_depth), sources(sources), objects(objects)
-          {}
+          max_recursion_depth(max_recursion_depth),
+          contribution_threshold(contribution_threshold), roulette_threshold(roulette_threshold),
+          roulette_random(ROULETTE_SEED), pruning_report(), render_options(render_options),
+          light_samples(render_options.light_samples), light_random(LIGHT_SEED),
+          arena(std::move(arena)), sources(sources), light_tree(), light_grid(sources.size()),
+          occluder_cache(sources.size()), occluder_report(), objects(objects),
+          optimizer_report(optimizer_report)
+          {
+  CUSTOM_ASSERT(max_recursion_depth < TRACE_STACK_SIZE);
+
+  TimelineSpan span("light tree", "acceleration");
+  light_tree = LightTree(sources);
+}
 
 Scene::Scene():
   Scene(1, 1, 1, Eigen::Vector4d(-0.5, -0.5, 0, 1), Eigen::Vector4d(0, 0, -1, 1),
-        LightIntensity(), 1.0, 1, {}, nullptr) {}
+        LightIntensity(), 1.0, 1, {}, nullptr, std::make_unique<Arena>()) {}
 
 Scene::~Scene() {
   #ifdef DEBUG
     std::cout << "\nDestructing Scene at " << this << std::endl;
   #endif
+}
 
-  for (LightSource* source : sources) {
-    if (source == nullptr) {
-      continue;
-    }
 
-    delete source;
+
+LightIntensity Scene::amplified(const LightIntensity& li, float factor) {
+  std::array<float, NUM_COL> rgb;
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    rgb[k] = li.at(k) * factor;
+  }
+
+  return LightIntensity(rgb);
+}
+
+unsigned Scene::light_count(const std::vector<unsigned>& lights) const {
+  if (light_samples == 0 or light_samples >= lights.size()) {
+    return lights.size();
   }
 
-  if (objects != nullptr) {
-    delete objects;
+  return light_samples;
+}
+
+LightChoice Scene::choose_light(const Eigen::Vector4d& point, unsigned k, const std::vector<unsigned>& lights) {
+  if (light_count(lights) == lights.size()) { // exact
+    return {lights[k], 1};
   }
+
+  double probability;
+  double u = std::uniform_real_distribution<double>(0, 1)(light_random);
+  unsigned source = light_tree.sample(point.head<3>(), u, probability);
+
+  return {source, (float) (1 / (probability * light_samples))};
 }
 
+float Scene::survival(const LightIntensity& coefficient, const LightIntensity& weight) {
+  if (coefficient.maximum() == 0) { // adds exactly nothing
+    pruning_report.black_rays++;
+    return 0;
+  }
+
+  float contribution = weight.maximum();
+  if (contribution < contribution_threshold) {
+    pruning_report.negligible_rays++;
+    return 0;
+  }
 
+  if (contribution < roulette_threshold) {
+    float probability = contribution / roulette_threshold;
 
-LightIntensity Scene::trace_ray(const Ray& ray, unsigned depth) {
-  IntersectionPoint ip;
+    if (std::uniform_real_distribution<float>(0, 1)(roulette_random) >= probability) {
+      pruning_report.roulette_rays++;
+      return 0;
+    }
 
-  if (!objects->intersect(ray, &ip)) {
-    return LightIntensity();
+    pruning_report.traced_rays++;
+    return 1 / probability;
   }
 
-  ColData texture = ip.color;
+  pruning_report.traced_rays++;
+  return 1;
+}
 
+LightIntensity Scene::trace_ray(const Ray& ray, unsigned depth) {
+  return trace_ray(ray, depth, LightIntensity::white());
+}
+
+float Scene::medium_index(const IntersectionPoint& ip) {
   float index = global_index;
   if (ip.inside) {
     try {
@@ -74,64 +225,299 @@ LightIntensity Scene::trace_ray(const Ray& ray, unsigned depth) {
     }
   }
 
-  LightIntensity value = texture.ambient * ambient_light;
-  
-  for (LightSource* ls : sources) {
-    Eigen::Vector4d light_dir = ls->pos() - ip.point;
+  return index;
+}
 
-    if (light_dir == Eigen::Vector4d::Zero()) {
-      continue;
+LightSample Scene::connect_light(const Ray& ray, const IntersectionPoint& ip, unsigned source, const Eigen::Vector4d& target, OccluderCache& cache) const {
+  const LightSource& ls = *sources[source];
+  LightSample sample;
+  const ColData& texture = ip.color;
+
+  Eigen::Vector4d light_dir = target - ip.point;
+
+  if (light_dir == Eigen::Vector4d::Zero()) {
+    return sample;
+  }
+
+  // out of range, no shadow ray needed
+  float attenuation = ls.attenuation(light_dir.norm());
+  if (attenuation == 0) {
+    return sample;
+  }
+
+  Ray light_connection;
+  // to combat shadow acne
+  Ray light_connection1(ip.point + EPSILON * ip.normal, light_dir, ray.index());
+  Ray light_connection2(ip.point - EPSILON * ip.normal, light_dir, ray.index()); // if light source is inside object
+
+  PixelCost::count_shadow();
+  if (cache.occluded(*objects, light_connection1, light_dir.norm(), source)) {
+    // light_connection1 is discarded
+    PixelCost::count_shadow();
+    if (cache.occluded(*objects, light_connection2, light_dir.norm(), source)) {
+      // both are not valid
+      return sample;
     }
 
-    Ray light_connection;
-    // to combat shadow acne
-    Ray light_connection1(ip.point + EPSILON * ip.normal, light_dir, ray.index());
-    Ray light_connection2(ip.point - EPSILON * ip.normal, light_dir, ray.index()); // if light source is inside object
+    light_connection = light_connection2;
+  }
+  else {
+    light_connection = light_connection1;
+  }
+
+  Ray light_reflection = (-light_connection).reflect(ip.point, ip.normal);
 
-    IntersectionPoint light_ip1; IntersectionPoint light_ip2;
-    if (objects->intersect(light_connection1, &light_ip1) && light_ip1.distance < light_dir.norm()) {
-      // light_ip1 is discarded
-      if (objects->intersect(light_connection2, &light_ip2) && light_ip2.distance < light_dir.norm()) {
-        // both are not valid
+  const LightIntensity& light = ls.ranged() ? ls.rgb() * attenuation : ls.rgb();
+
+  sample.lit = true;
+  sample.diffuse = texture.diffuse * light * abs(light_connection.direction().dot(ip.normal));
+
+  if (light_reflection.direction().dot((-ray).direction()) > 0) {
+    sample.highlighted = true;
+    sample.specular = texture.specular * light * (double) powf64(light_reflection.direction().dot((-ray).direction()), texture.shininess);
+  }
+
+  return sample;
+}
+
+LightSample Scene::sample_light(const Ray& ray, const IntersectionPoint& ip, unsigned source, OccluderCache& cache) const {
+  const LightSource& ls = *sources[source];
+
+  if (ls.shape() == LightShape::POINT) {
+    return connect_light(ray, ip, source, ls.pos(), cache);
+  }
+
+  std::minstd_rand random(sample_seed(ip.point, source));
+  std::uniform_real_distribution<double> jitter(0, 1);
+
+  // every stratum of the refined grid holds at most one sample
+  std::array<bool, AREA_LIGHT_MAX_STRATA * AREA_LIGHT_MAX_STRATA> covered{};
+  AreaSum sum;
+
+  for (unsigned a = 0; a < AREA_LIGHT_STRATA; a++) {
+    for (unsigned b = 0; b < AREA_LIGHT_STRATA; b++) {
+      double s = (a + jitter(random)) / AREA_LIGHT_STRATA;
+      double t = (b + jitter(random)) / AREA_LIGHT_STRATA;
+
+      covered[(unsigned) (s * AREA_LIGHT_MAX_STRATA) * AREA_LIGHT_MAX_STRATA + (unsigned) (t * AREA_LIGHT_MAX_STRATA)] = true;
+      sum.add(connect_light(ray, ip, source, ls.sample_point(ip.point, s, t), cache));
+    }
+  }
+
+  // fully lit and fully shadowed points are done, only the penumbra is refined
+  if (sum.lit == 0 or sum.lit == sum.count) {
+    return sum.average();
+  }
+
+  for (unsigned c = 0; c < AREA_LIGHT_MAX_STRATA; c++) {
+    for (unsigned d = 0; d < AREA_LIGHT_MAX_STRATA; d++) {
+      if (covered[c * AREA_LIGHT_MAX_STRATA + d]) {
         continue;
       }
 
-      light_connection = light_connection2;
-    }
-    else {
-      light_connection = light_connection1;
+      double s = (c + jitter(random)) / AREA_LIGHT_MAX_STRATA;
+      double t = (d + jitter(random)) / AREA_LIGHT_MAX_STRATA;
+
+      sum.add(connect_light(ray, ip, source, ls.sample_point(ip.point, s, t), cache));
     }
+  }
+
+  return sum.average();
+}
 
-    Ray light_reflection = (-light_connection).reflect(ip.point, ip.normal);
+bool Scene::shade(TraceTask& task, const std::vector<unsigned>& lights) {
+  const Ray& ray = task.ray;
+  IntersectionPoint ip;
 
-    value += texture.diffuse * ls->rgb() * abs(light_connection.direction().dot(ip.normal));
+  render_stats.max_depth = std::max(render_stats.max_depth, task.depth);
+  if (!objects->intersect(ray, &ip)) {
+    return false;
+  }
+  render_stats.hits++;
+
+  float index = medium_index(ip);
+
+  LightIntensity value = ip.color.ambient * ambient_light;
+  
+  LightSum sum;
+  unsigned count = light_count(lights);
+  for (unsigned k = 0; k < count; k++) {
+    LightChoice choice = choose_light(ip.point, k, lights);
+
+    sum.add(value, sample_light(ray, ip, choice.source, occluder_cache), choice.weight);
+  }
+  sum.finish(value);
 
-    if (light_reflection.direction().dot((-ray).direction()) > 0) {
-      value += texture.specular * ls->rgb() * (double) powf64(light_reflection.direction().dot((-ray).direction()), texture.shininess);
+  task.point = ip.point;
+  task.normal = ip.normal;
+  task.reflected = ip.color.reflected;
+  task.refracted = ip.color.refracted;
+  task.index = index;
+  task.value = value;
+
+  return true;
+}
+
+bool Scene::spawn(TraceStack& stack, TraceTask& task, const LightIntensity& coefficient, const Ray& secondary) {
+  float factor = survival(coefficient, task.weight * coefficient);
+  if (factor == 0) {
+    return false;
+  }
+
+  PixelCost::count_secondary();
+  task.coefficient = amplified(coefficient, factor);
+  stack.push(TraceTask(secondary, task.weight * task.coefficient, task.depth + 1));
+
+  return true;
+}
+
+LightIntensity Scene::trace_ray(const Ray& ray, unsigned depth, const LightIntensity& weight) {
+  return trace_ray(ray, depth, weight, light_grid.all());
+}
+
+LightIntensity Scene::trace_ray(const Ray& ray, unsigned depth, const LightIntensity& weight, const std::vector<unsigned>& lights) {
+  // every thread traces on its own stack, there is no recursion into trace_ray
+  static thread_local TraceStack stack;
+
+  CUSTOM_ASSERT(stack.empty() and depth <= max_recursion_depth);
+
+  stack.push(TraceTask(ray, weight, depth));
+
+  while (true) {
+    TraceTask& task = stack.top();
+
+    switch (task.stage) {
+      case TraceStage::SHADE:
+        task.stage = TraceStage::FINISH;
+
+        if (shade(task, stack.size() == 1 ? lights : light_grid.all()) and task.depth < max_recursion_depth) {
+          task.stage = TraceStage::REFRACT;
+          spawn(stack, task, task.reflected, task.ray.reflect(task.point, task.normal));
+        }
+        break;
+
+      case TraceStage::REFRACT:
+        task.stage = TraceStage::FINISH;
+
+        if (task.ray.index() < task.index || acosf64(task.ray.direction().dot(task.normal)) < asinf64(task.ray.index() / task.index)) { // otherwise we have total reflection
+          spawn(stack, task, task.refracted, task.ray.refract(task.point, task.normal, task.index));
+        }
+        break;
+
+      case TraceStage::FINISH: {
+        LightIntensity value = task.value;
+        stack.pop();
+
+        if (stack.empty()) {
+          return value;
+        }
+
+        // the screen blend is not linear, so secondary rays are added to their parent after they are finished
+        TraceTask& parent = stack.top();
+        parent.value += parent.coefficient * value;
+
+        if(parent.value.at(0) < -EPSILON) {
+          std::cout << "Negative value after " << (parent.stage == TraceStage::REFRACT ? "reflected: " : "refrected: ") << parent.value << std::endl;
+          exit(1);
+        }
+        break;
+      }
     }
   }
+}
+
+const OptimizerReport& Scene::optimizations() const {
+  return optimizer_report;
+}
+
+const RenderOptions& Scene::options() const {
+  return render_options;
+}
+
+const PruningReport& Scene::pruning() const {
+  return pruning_report;
+}
+
+cv::Mat_<cv::Vec3b> Scene::sample_image() const {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+  cv::Mat_<cv::Vec3b> image(rows, columns);
+
+  unsigned most = sample_counts.empty() ? 1 : *std::max_element(sample_counts.begin(), sample_counts.end());
+
+  for (unsigned p = 0; p < sample_counts.size(); p++) {
+    float shade = most > 1 ? (float) (sample_counts[p] - 1) / (most - 1) : 0;
+    store_pixel(image, p / columns, p % columns, LightIntensity(shade, shade, shade));
+  }
+
+  return image;
+}
+
+const RenderStats& Scene::statistics() const {
+  return render_stats;
+}
+
+const std::vector<PixelCost>& Scene::costs() const {
+  return pixel_costs;
+}
+
+cv::Mat_<cv::Vec3b> Scene::cost_image() const {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+  cv::Mat_<cv::Vec3b> image(rows, columns, cv::Vec3b(0, 0, 0));
+
+  std::vector<double> seconds;
+  for (const PixelCost& cost : pixel_costs) {
+    seconds.push_back(cost.seconds);
+  }
 
-  if (depth == max_recursion_depth) {
-    return value;
+  double most = 0;
+  if (not seconds.empty()) {
+    auto quantile = seconds.begin() + (std::size_t) (COST_MAP_PERCENTILE * (seconds.size() - 1));
+    std::nth_element(seconds.begin(), quantile, seconds.end());
+    most = *quantile;
   }
 
-  Ray reflection = ray.reflect(ip.point, ip.normal);
-  value += texture.reflected * trace_ray(reflection, depth+1);
-  if(value.at(0) < -EPSILON) {
-    std::cout << "Negative value after reflected: " << value << std::endl;
-    exit(1);
+  for (unsigned p = 0; p < pixel_costs.size(); p++) {
+    store_pixel(image, p / columns, p % columns, heat_color(most > 0 ? pixel_costs[p].seconds / most : 0));
   }
 
-  if (ray.index() < index || acosf64(ray.direction().dot(ip.normal)) < asinf64(ray.index() / index)) { // otherwise we have total reflection
-    Ray refraction = ray.refract(ip.point, ip.normal, index);
-    value += texture.refracted * trace_ray(refraction, depth+1);
-    if(value.at(0) < -EPSILON) {
-      std::cout << "Negative value after refrected: " << value << std::endl;
-      exit(1);
+  return image;
+}
+
+void Scene::write_costs(std::ostream& out) const {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+
+  out << "cost " << rows << " " << columns << " " << PixelCost::channel_names << "\n";
+
+  if (pixel_costs.empty()) {
+    return;
+  }
+
+  // the same orientation as the image, see store_pixel()
+  for (unsigned i = rows; i-- > 0;) {
+    for (unsigned j = 0; j < columns; j++) {
+      const PixelCost& cost = pixel_costs[i * columns + j];
+      std::array<float, PixelCost::channels> data = {
+        (float) cost.primary, (float) cost.shadow, (float) cost.secondary, (float) cost.included, (float) cost.seconds
+      };
+
+      out.write(reinterpret_cast<const char*>(data.data()), sizeof(data));
     }
   }
+}
+
+const OccluderReport& Scene::occluders() const {
+  return occluder_report;
+}
+
+const RootObject& Scene::tree() const {
+  return *objects;
+}
 
-  return value;
+unsigned long Scene::primary_rays() const {
+  return traced_samples;
 }
 
 // credit to leemes on stackoverflow for the implementation (https://stackoverflow.com/questions/14539867/how-to-display-a-progress-indicator-in-pure-c-c-cout-printf)
@@ -154,26 +540,286 @@ void Scene::progress_bar(float progress) {
   std::cout << "] " << int(progress * 100.0) << "%\r" << std::flush;
 }
 
-cv::Mat_<cv::Vec3b> Scene::generate() {
-  cv::Mat_<cv::Vec3b> pixel_data(dpi * L_x, dpi * L_y);
+Ray Scene::primary_ray(unsigned i, unsigned j) const {
+  return primary_ray(i, j, 0.5, 0.5);
+}
+
+Ray Scene::primary_ray(unsigned i, unsigned j, float dx, float dy) const {
+  Eigen::Vector4d Pij = position + 1.0 / dpi * (i * Eigen::Vector4d::UnitX() + j * Eigen::Vector4d::UnitY()) + dx / dpi * Eigen::Vector4d::UnitX() + dy / dpi * Eigen::Vector4d::UnitY();
+
+  return Ray(observer, Pij - observer, global_index);
+}
+
+Ray Scene::primary_ray(const PixelSample& sample) const {
+  unsigned width = dpi * L_y;
 
-  for (unsigned i = 0; i < dpi * L_x; i++) {
-    for (unsigned j = 0; j < dpi * L_y; j++) {
-      Eigen::Vector4d Pij = position + 1.0 / dpi * (i * Eigen::Vector4d::UnitX() + j * Eigen::Vector4d::UnitY()) + 1 / (2*dpi) * (Eigen::Vector4d::UnitX() + Eigen::Vector4d::UnitY());
-      Ray ray(observer, Pij - observer, global_index);
+  return primary_ray(sample.pixel / width, sample.pixel % width, sample.dx, sample.dy);
+}
+
+void Scene::store_pixel(cv::Mat_<cv::Vec3b>& pixel_data, unsigned i, unsigned j, const LightIntensity& val) const {
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    pixel_data(dpi * L_x - i - 1, j)[k] = 255 * val.at(NUM_COL - k - 1);
+  }
+}
 
-      LightIntensity val = trace_ray(ray, 0);
+void Scene::store_image(cv::Mat_<cv::Vec3b>& pixel_data, const std::vector<LightIntensity>& values) const {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
 
+  // the image is written in its memory order, its first row shows the last row of the screen, see store_pixel()
+  for (unsigned r = 0; r < rows; r++) {
+    const LightIntensity* row = &values[(rows - r - 1) * columns];
+
+    for (unsigned j = 0; j < columns; j++) {
+      cv::Vec3b& pixel = pixel_data(r, j);
       for (unsigned k = 0; k < NUM_COL; k++) {
-        pixel_data(dpi * L_x - i - 1, j)[k] = 255 * val.at(NUM_COL - k - 1);
+        pixel[k] = 255 * row[j].at(NUM_COL - k - 1);
+      }
+    }
+  }
+}
+
+void Scene::cull_lights(unsigned threads) {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+
+  if (std::none_of(sources.begin(), sources.end(), [](const LightSource* ls) { return ls->ranged(); })) {
+    light_grid = LightGrid(sources.size());
+    return;
+  }
+
+  TimelineSpan span("cull lights", "acceleration");
+  light_grid = LightGrid(sources.size(), rows, columns);
+  unsigned tile_columns = (columns + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+
+  parallel_for(light_grid.size(), threads, [this, rows, columns, tile_columns](unsigned begin, unsigned end) {
+    TimelineSpan tiles_span("cull tiles", "acceleration", "first tile", begin);
+
+    for (unsigned t = begin; t < end; t++) {
+      unsigned i0 = (t / tile_columns) * LIGHT_TILE_SIZE;
+      unsigned j0 = (t % tile_columns) * LIGHT_TILE_SIZE;
+
+      BoundingBox geometry;
+      for (unsigned i = i0; i < std::min(rows, i0 + LIGHT_TILE_SIZE); i++) {
+        for (unsigned j = j0; j < std::min(columns, j0 + LIGHT_TILE_SIZE); j++) {
+          IntersectionPoint ip;
+          if (objects->intersect(primary_ray(i, j), &ip)) {
+            Eigen::Vector3d point = ip.point.head<3>();
+            geometry = geometry.merged(BoundingBox(point, point));
+          }
+        }
       }
 
-      float progress = (float) i / (dpi * L_x) + (float) j / (dpi * dpi * L_x * L_y);
-      progress_bar(progress);
+      light_grid.cull(t, geometry, sources);
+    }
+  });
+
+  #ifdef DEBUG
+    unsigned total = 0;
+    for (unsigned t = 0; t < light_grid.size(); t++) {
+      total += light_grid.lights(t).size();
     }
+    std::cout << "Average lights per tile: " << (float) total / light_grid.size() << std::endl;
+  #endif
+}
+
+void Scene::trace_pixels(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values) {
+  unsigned width = dpi * L_y;
+
+  // every width samples, i.e. a row of the screen in scanline order, are an event of the Timeline
+  double run_start = Timeline::now();
+
+  for (unsigned s = 0; s < samples.size(); s++) {
+    unsigned i = samples[s].pixel / width;
+    unsigned j = samples[s].pixel % width;
+
+    if (s > 0 and s % width == 0) {
+      Timeline::record("pixels", "render", run_start, Timeline::now(), "first sample", s - width);
+      run_start = Timeline::now();
+    }
+
+    // everything counted while tracing the sample belongs to its pixel
+    PixelCost* cost = pixel_costs.empty() ? nullptr : &pixel_costs[samples[s].pixel];
+    PixelCost::recording = cost;
+    std::chrono::steady_clock::time_point start = cost != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    values[s] = trace_ray(primary_ray(samples[s]), 0, LightIntensity::white(), light_grid.lights(light_grid.tile(i, j)));
+
+    if (cost != nullptr) {
+      cost->primary++;
+      cost->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    progress_bar((float) s / samples.size());
   }
 
+  if (not samples.empty()) {
+    Timeline::record("pixels", "render", run_start, Timeline::now(), "first sample", (samples.size() - 1) / width * width);
+  }
+
+  PixelCost::recording = nullptr;
+}
+
+void Scene::trace_samples(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values, const RenderOptions& options) {
+  values.resize(samples.size());
+  traced_samples += samples.size();
+
+  if (options.mode == RenderMode::WAVEFRONT) {
+    trace_wavefront(samples, values, options);
+  }
+  else {
+    trace_pixels(samples, values);
+  }
+}
+
+std::vector<PixelSample> Scene::refinement_samples(const std::vector<LightIntensity>& values, const RenderOptions& options) const {
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+
+  // the contrast is judged on the centers only, so refining one pixel does not change the decision for its neighbors
+  std::vector<PixelSample> samples;
+  for (unsigned p = 0; p < values.size(); p++) {
+    unsigned i = p / columns;
+    unsigned j = p % columns;
+
+    float contrast = 0;
+    for (unsigned q : {i > 0 ? p - columns : p, i + 1 < rows ? p + columns : p, j > 0 ? p - 1 : p, j + 1 < columns ? p + 1 : p}) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        contrast = std::max(contrast, std::abs(values[p].at(k) - values[q].at(k)));
+      }
+    }
+
+    unsigned needed = contrast > options.contrast_threshold ? std::max(options.min_samples, options.max_samples) : options.min_samples;
+    unsigned strata = std::sqrt(needed);
+    if (strata < 2) {
+      continue;
+    }
+
+    std::minstd_rand random(AA_SEED + p);
+    std::uniform_real_distribution<float> jitter(0, 1);
+    for (unsigned u = 0; u < strata; u++) {
+      for (unsigned v = 0; v < strata; v++) {
+        float dx = (u + jitter(random)) / strata;
+        float dy = (v + jitter(random)) / strata;
+        samples.push_back({p, dx, dy});
+      }
+    }
+  }
+
+  return samples;
+}
+
+void Scene::average_samples(const std::vector<PixelSample>& samples, const std::vector<LightIntensity>& refined, std::vector<LightIntensity>& values) {
+  // the samples of a pixel are consecutive and replace its center
+  for (unsigned s = 0; s < samples.size(); ) {
+    unsigned p = samples[s].pixel;
+    unsigned n = 0;
+    while (s + n < samples.size() and samples[s + n].pixel == p) {
+      n++;
+    }
+
+    std::array<float, NUM_COL> average{};
+    for (unsigned t = s; t < s + n; t++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        average[k] += refined[t].at(k) / n;
+      }
+    }
+    values[p] = LightIntensity(average);
+    sample_counts[p] = n;
+
+    s += n;
+  }
+}
+
+void Scene::antialias(std::vector<LightIntensity>& values, const RenderOptions& options) {
+  TimelineSpan span("antialias", "render");
+  std::vector<PixelSample> samples = refinement_samples(values, options);
+
+  if (samples.empty()) {
+    return;
+  }
+
+  std::vector<LightIntensity> refined;
+  trace_samples(samples, refined, options);
+
+  average_samples(samples, refined, values);
+}
+
+void Scene::begin_render(const RenderOptions& options) {
+  pruning_report = PruningReport();
+  render_stats = RenderStats();
+  RenderStats::reset_csg_tests();
+  occluder_report = OccluderReport();
+  // every render of the scene gives the same image
+  roulette_random.seed(ROULETTE_SEED);
+  light_random.seed(LIGHT_SEED);
+  light_samples = options.light_samples;
+  cull_lights(options.thread_count());
+
+  sample_counts.assign((unsigned) (dpi * L_x) * (unsigned) (dpi * L_y), 1);
+  traced_samples = 0;
+  pixel_costs.clear();
+  if (options.cost_map and options.mode == RenderMode::PIXEL) {
+    pixel_costs.resize(sample_counts.size());
+  }
+  NodeProfiler::reset();
+  occluder_cache = OccluderCache(sources.size());
+}
+
+void Scene::end_render(const RenderOptions& options) {
+  if (options.mode != RenderMode::WAVEFRONT) {
+    occluder_report = occluder_cache.report();
+  }
+
+  render_stats.primary_rays = traced_samples;
+  render_stats.secondary_rays = pruning_report.traced_rays;
+  render_stats.shadow_rays = occluder_report.shadow_rays;
+  render_stats.occluded_rays = occluder_report.occluded_rays;
+  render_stats.csg_tests = RenderStats::csg_test_count();
+  render_stats.peak_memory_kb = RenderStats::peak_memory();
+
+  light_samples = render_options.light_samples;
+
   std::cout << std::endl;
+}
+
+cv::Mat_<cv::Vec3b> Scene::generate() {
+  return generate(render_options);
+}
+
+cv::Mat_<cv::Vec3b> Scene::generate(const RenderOptions& options) {
+  TimelineSpan span("render", "render");
+  std::chrono::steady_clock::time_point mark = std::chrono::steady_clock::now();
+  cv::Mat_<cv::Vec3b> pixel_data(dpi * L_x, dpi * L_y);
+
+  begin_render(options);
+  render_stats.add_phase("setup", mark);
+
+  unsigned rows = dpi * L_x;
+  unsigned columns = dpi * L_y;
+  std::vector<PixelSample> centers;
+  for (unsigned p : pixel_traversal(rows, columns, options.pixel_order, options.tile_size)) {
+    centers.push_back({p, 0.5, 0.5});
+  }
+
+  std::vector<LightIntensity> traced;
+  trace_samples(centers, traced, options);
+
+  std::vector<LightIntensity> values(centers.size());
+  for (unsigned s = 0; s < centers.size(); s++) {
+    values[centers[s].pixel] = traced[s];
+  }
+  render_stats.add_phase("trace", mark);
+
+  if (std::max(options.min_samples, options.max_samples) > 1) {
+    antialias(values, options);
+    render_stats.add_phase("antialias", mark);
+  }
+
+  store_image(pixel_data, values);
+  render_stats.add_phase("store", mark);
+
+  end_render(options);
 
   return pixel_data;
-}
\ No newline at end of file
+}
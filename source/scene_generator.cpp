@@ -0,0 +1,137 @@
+#include <sstream>
+
+#include <scene_generator.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * \brief Random vector with coordinates in [low, high).
+ */
+static json random_vector(std::mt19937& random, double low, double high) {
+  std::uniform_real_distribution<double> uniform(low, high);
+
+  double x = uniform(random);
+  double y = uniform(random);
+  double z = uniform(random);
+
+  return {x, y, z};
+}
+
+/**
+ * \brief Random mostly diffuse color data, that reflects a little.
+ */
+static json random_color(std::mt19937& random) {
+  json base = random_vector(random, 0.2, 1);
+  json diffuse = {0.8 * base[0].get<double>(), 0.8 * base[1].get<double>(), 0.8 * base[2].get<double>()};
+  json ambient = {0.2 * base[0].get<double>(), 0.2 * base[1].get<double>(), 0.2 * base[2].get<double>()};
+
+  return {
+    {"ambient", ambient},
+    {"diffuse", diffuse},
+    {"specular", {0.5, 0.5, 0.5}},
+    {"reflected", {0.2, 0.2, 0.2}},
+    {"refracted", "black"},
+    {"shininess", 8}
+  };
+}
+
+/**
+ * \brief Sphere with the color of the surrounding object, used as operand of the CSG operations.
+ */
+static json csg_sphere(const json& center, double radius, const json& color) {
+  return {{"sphere", {{"position", center}, {"radius", radius}, {"color", color}, {"index", 1}}}};
+}
+
+json SceneGenerator::describe(const GeneratorOptions& options) {
+  std::mt19937 random(options.seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+
+  json data;
+  data["screen"] = {
+    {"dpi", options.dpi},
+    {"dimensions", {4, 4}},
+    {"position", {-2, -2, -10}},
+    {"observer", {0, 0, -20}}
+  };
+  data["medium"] = {
+    {"ambient", {0.1, 0.1, 0.1}},
+    {"index", 1},
+    {"recursion", options.recursion}
+  };
+
+  data["sources"] = json::array();
+  for (unsigned k = 0; k < options.lights; k++) {
+    json position = random_vector(random, -6, 6);
+    position[2] = -12 + 6 * uniform(random);
+    double brightness = 0.3 + 0.5 * uniform(random);
+
+    data["sources"].push_back({{"position", position}, {"intensity", {brightness, brightness, brightness}}});
+  }
+
+  // every kind in a fixed order, so adding objects of one kind does not change the others
+  std::vector<std::string> kinds;
+  kinds.insert(kinds.end(), options.spheres, "sphere");
+  kinds.insert(kinds.end(), options.cylinders, "cylinder");
+  kinds.insert(kinds.end(), options.cubes, "cube");
+  kinds.insert(kinds.end(), options.triforces, "triforce");
+
+  data["objects"] = json::array();
+  for (const std::string& kind : kinds) {
+    json center = random_vector(random, -3, 3);
+    double size = 0.3 + 0.7 * uniform(random);
+    json color = random_color(random);
+
+    json object;
+    if (kind == "sphere") {
+      object = {{"sphere", {{"position", center}, {"radius", size}, {"color", color}, {"index", 1}}}};
+    }
+    else if (kind == "cylinder") {
+      object = {{"cylinder", {{"position", center}, {"radius", 0.3 * size}, {"axis", random_vector(random, -1, 1)}, {"color", color}, {"index", 1}}}};
+    }
+    else if (kind == "cube") {
+      object = {{"cube", {{"position", center}, {"dimensions", {size, size, size}}, {"color", color}, {"index", 1}}}};
+    }
+    else {
+      object = {{"triforce", {{"position", center}, {"color", color}, {"index", 1}}}};
+      size = 1;
+    }
+
+    // carve a notch out of the object and round it off, alternately
+    for (unsigned level = 0; level < options.csg_depth; level++) {
+      if (level % 2 == 0) {
+        json notch = center;
+        for (unsigned i = 0; i < 3; i++) {
+          notch[i] = center[i].get<double>() + size * (uniform(random) - 0.5);
+        }
+        object = {{"subtraction", {object, csg_sphere(notch, 0.4 * size, color)}}};
+      }
+      else {
+        object = {{"intersection", {object, csg_sphere(center, (0.9 + 0.3 * uniform(random)) * size, color)}}};
+      }
+    }
+
+    // small transformations, so the object stays close to its place
+    for (unsigned link = 0; link < options.transform_chain; link++) {
+      if (link % 3 == 0) {
+        std::uniform_int_distribution<unsigned> direction(0, 2);
+        object = {{"rotation", {{"angle", 30 * (uniform(random) - 0.5)}, {"direction", direction(random)}, {"subject", object}}}};
+      }
+      else if (link % 3 == 1) {
+        object = {{"scaling", {{"factors", random_vector(random, 0.9, 1.1)}, {"subject", object}}}};
+      }
+      else {
+        object = {{"translation", {{"factors", random_vector(random, -0.2, 0.2)}, {"subject", object}}}};
+      }
+    }
+
+    data["objects"].push_back(object);
+  }
+
+  return data;
+}
+
+Scene SceneGenerator::build(const GeneratorOptions& options) {
+  std::istringstream description(describe(options).dump());
+
+  return Scene::read_parameters(description);
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+
+#include <sdf.hpp>
+
+/**
+ * \brief Box grown by margin into every direction.
+ */
+static BoundingBox grown(const BoundingBox& box, const Eigen::Vector3d& margin) {
+  if (box.empty()) {
+    return box;
+  }
+
+  return BoundingBox(box.min() - margin, box.max() + margin);
+}
+
+
+SdfProgram::SdfProgram(const allocator_type& allocator):
+  instructions(allocator), bound_stack(allocator), open_transformations(allocator), open_depths(allocator) {}
+
+SdfProgram::SdfProgram(const SdfProgram& other, const allocator_type& allocator):
+  instructions(other.instructions, allocator), bound_stack(other.bound_stack, allocator),
+  open_transformations(other.open_transformations, allocator), open_depths(other.open_depths, allocator) {}
+
+void SdfProgram::push(const SdfInstruction& instruction, const BoundingBox& box) {
+  if (bound_stack.size() >= SDF_STACK_SIZE) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field is nested too deep");
+  }
+
+  instructions.push_back(instruction);
+  bound_stack.push_back(box);
+}
+
+void SdfProgram::begin_transformation(const SdfInstruction& instruction) {
+  if (open_transformations.size() + 1 >= SDF_STACK_SIZE) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field is nested too deep");
+  }
+
+  instructions.push_back(instruction);
+  open_transformations.push_back(instruction);
+  open_depths.push_back(bound_stack.size());
+}
+
+SdfInstruction SdfProgram::end_transformation(SdfOpcode expected) {
+  if (open_transformations.empty() or open_transformations.back().op != expected) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field ends a transformation, that was not started");
+  }
+
+  SdfInstruction begin = open_transformations.back();
+  unsigned depth = open_depths.back();
+  open_transformations.pop_back();
+  open_depths.pop_back();
+
+  if (bound_stack.size() != depth + 1) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field transformation has to enclose exactly one shape");
+  }
+
+  return begin;
+}
+
+
+void SdfProgram::sphere(const Eigen::Vector3d& center, double radius) {
+  push({SdfOpcode::SPHERE, center, Eigen::Vector3d(radius, 0, 0)},
+       BoundingBox(center.array() - radius, center.array() + radius));
+}
+
+void SdfProgram::box(const Eigen::Vector3d& center, const Eigen::Vector3d& half_size) {
+  push({SdfOpcode::BOX, center, half_size.cwiseAbs()},
+       BoundingBox(center - half_size.cwiseAbs(), center + half_size.cwiseAbs()));
+}
+
+void SdfProgram::torus(const Eigen::Vector3d& center, double major_radius, double minor_radius) {
+  Eigen::Vector3d extent(major_radius + minor_radius, major_radius + minor_radius, minor_radius);
+
+  push({SdfOpcode::TORUS, center, Eigen::Vector3d(major_radius, minor_radius, 0)},
+       BoundingBox(center - extent, center + extent));
+}
+
+void SdfProgram::combine(SdfOpcode op, double smoothing) {
+  if (op != SdfOpcode::UNION and op != SdfOpcode::INTERSECTION and op != SdfOpcode::SUBTRACTION and op != SdfOpcode::SMOOTH_UNION) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field operation is no combination");
+  }
+
+  unsigned depth = open_depths.empty() ? 0 : open_depths.back();
+
+  if (bound_stack.size() < depth + 2) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field combination needs two operands");
+  }
+
+  if (op == SdfOpcode::SMOOTH_UNION and smoothing <= 0) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field smooth union needs a positive smoothing");
+  }
+
+  BoundingBox b = bound_stack.back();
+  bound_stack.pop_back();
+  BoundingBox a = bound_stack.back();
+  bound_stack.pop_back();
+
+  BoundingBox combined;
+  switch (op) {
+    case SdfOpcode::UNION:
+      combined = a.merged(b);
+      break;
+    case SdfOpcode::INTERSECTION:
+      combined = a.intersected(b);
+      break;
+    case SdfOpcode::SUBTRACTION:
+      combined = a;
+      break;
+    case SdfOpcode::SMOOTH_UNION:
+      // the smooth minimum is at most smoothing / 4 below the exact one
+      combined = grown(a.merged(b), Eigen::Vector3d::Constant(smoothing / 4));
+      break;
+    default:
+      break;
+  }
+
+  instructions.push_back({op, Eigen::Vector3d::Zero(), Eigen::Vector3d(smoothing, 0, 0)});
+  bound_stack.push_back(combined);
+}
+
+
+void SdfProgram::begin_translation(const Eigen::Vector3d& offset) {
+  begin_transformation({SdfOpcode::PUSH_TRANSLATION, offset, Eigen::Vector3d::Zero()});
+}
+
+void SdfProgram::end_translation() {
+  SdfInstruction begin = end_transformation(SdfOpcode::PUSH_TRANSLATION);
+
+  instructions.push_back({SdfOpcode::POP_POINT, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()});
+
+  BoundingBox& box = bound_stack.back();
+  if (not box.empty()) {
+    box = BoundingBox(box.min() + begin.vector, box.max() + begin.vector);
+  }
+}
+
+void SdfProgram::begin_scaling(double factor) {
+  if (factor <= 0) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field scaling factor has to be positive");
+  }
+
+  begin_transformation({SdfOpcode::PUSH_SCALING, Eigen::Vector3d::Zero(), Eigen::Vector3d(factor, 0, 0)});
+}
+
+void SdfProgram::end_scaling() {
+  SdfInstruction begin = end_transformation(SdfOpcode::PUSH_SCALING);
+  double factor = begin.scalars[0];
+
+  instructions.push_back({SdfOpcode::POP_SCALING, Eigen::Vector3d::Zero(), Eigen::Vector3d(factor, 0, 0)});
+
+  BoundingBox& box = bound_stack.back();
+  if (not box.empty()) {
+    box = BoundingBox(box.min() * factor, box.max() * factor);
+  }
+}
+
+void SdfProgram::begin_repetition(const Eigen::Vector3d& spacing, const Eigen::Vector3i& count) {
+  if ((spacing.array() <= 0).any() or (count.array() < 0).any()) {
+    throw Cpp_Raytracing_INVALID_INPUT("signed distance field repetition needs positive spacing and counts");
+  }
+
+  begin_transformation({SdfOpcode::PUSH_REPETITION, spacing, count.cast<double>()});
+}
+
+void SdfProgram::end_repetition() {
+  SdfInstruction begin = end_transformation(SdfOpcode::PUSH_REPETITION);
+
+  instructions.push_back({SdfOpcode::POP_POINT, Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()});
+
+  bound_stack.back() = grown(bound_stack.back(), begin.vector.cwiseProduct(begin.scalars));
+}
+
+
+bool SdfProgram::complete() const {
+  return bound_stack.size() == 1 and open_transformations.empty();
+}
+
+unsigned SdfProgram::size() const {
+  return instructions.size();
+}
+
+const BoundingBox& SdfProgram::bounds() const {
+  CUSTOM_ASSERT(complete());
+
+  return bound_stack.back();
+}
+
+
+double SdfProgram::evaluate(const Eigen::Vector3d& p) const {
+  double values[SDF_STACK_SIZE];
+  Eigen::Vector3d points[SDF_STACK_SIZE];
+
+  unsigned v = 0; // number of distances on the stack
+  unsigned q = 0; // index of the current point
+  points[0] = p;
+
+  for (const SdfInstruction& I : instructions) {
+    const Eigen::Vector3d& P = points[q];
+
+    switch (I.op) {
+      case SdfOpcode::SPHERE:
+        values[v++] = (P - I.vector).norm() - I.scalars[0];
+        break;
+
+      case SdfOpcode::BOX: {
+        Eigen::Vector3d d = (P - I.vector).cwiseAbs() - I.scalars;
+        values[v++] = d.cwiseMax(0).norm() + std::min(d.maxCoeff(), 0.0);
+        break;
+      }
+
+      case SdfOpcode::TORUS: {
+        Eigen::Vector3d local = P - I.vector;
+        Eigen::Vector2d d(local.head<2>().norm() - I.scalars[0], local[2]);
+        values[v++] = d.norm() - I.scalars[1];
+        break;
+      }
+
+      case SdfOpcode::UNION:
+        v--;
+        values[v - 1] = std::min(values[v - 1], values[v]);
+        break;
+
+      case SdfOpcode::INTERSECTION:
+        v--;
+        values[v - 1] = std::max(values[v - 1], values[v]);
+        break;
+
+      case SdfOpcode::SUBTRACTION:
+        v--;
+        values[v - 1] = std::max(values[v - 1], - values[v]);
+        break;
+
+      case SdfOpcode::SMOOTH_UNION: {
+        v--;
+        double a = values[v - 1];
+        double b = values[v];
+        double k = I.scalars[0];
+
+        double h = std::clamp(0.5 + 0.5 * (b - a) / k, 0.0, 1.0);
+        values[v - 1] = b + h * (a - b) - k * h * (1 - h);
+        break;
+      }
+
+      case SdfOpcode::PUSH_TRANSLATION:
+        points[q + 1] = P - I.vector;
+        q++;
+        break;
+
+      case SdfOpcode::PUSH_SCALING:
+        points[q + 1] = P / I.scalars[0];
+        q++;
+        break;
+
+      case SdfOpcode::PUSH_REPETITION: {
+        Eigen::Vector3d cell = (P.array() / I.vector.array()).round();
+        cell = cell.cwiseMax(- I.scalars).cwiseMin(I.scalars);
+        points[q + 1] = P - I.vector.cwiseProduct(cell);
+        q++;
+        break;
+      }
+
+      case SdfOpcode::POP_POINT:
+        q--;
+        break;
+
+      case SdfOpcode::POP_SCALING:
+        values[v - 1] *= I.scalars[0];
+        q--;
+        break;
+    }
+  }
+
+  return values[0];
+}
+
+Eigen::Vector3d SdfProgram::gradient(const Eigen::Vector3d& p, double h) const {
+  // tetrahedral finite differences need only four evaluations
+  const Eigen::Vector3d k0(1, -1, -1), k1(-1, -1, 1), k2(-1, 1, -1), k3(1, 1, 1);
+
+  Eigen::Vector3d g = k0 * evaluate(p + h * k0) + k1 * evaluate(p + h * k1)
+                    + k2 * evaluate(p + h * k2) + k3 * evaluate(p + h * k3);
+
+  return g.normalized();
+}
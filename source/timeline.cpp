@@ -0,0 +1,119 @@
+#include <string>
+
+#include <timeline.hpp>
+
+std::atomic<bool> Timeline::active(false);
+std::atomic<unsigned> Timeline::generation(0);
+std::atomic<Timeline::Buffer*> Timeline::buffers(nullptr);
+std::atomic<unsigned> Timeline::lanes(0);
+std::chrono::steady_clock::time_point Timeline::origin = std::chrono::steady_clock::now();
+std::thread::id Timeline::main_thread;
+thread_local Timeline::LocalBuffer Timeline::local;
+
+Timeline::LocalBuffer::~LocalBuffer() {
+  if (buffer != nullptr and generation == Timeline::generation.load(std::memory_order_acquire)) {
+    buffer->in_use.store(false, std::memory_order_release);
+  }
+}
+
+Timeline::Buffer& Timeline::buffer() {
+  unsigned current = generation.load(std::memory_order_acquire);
+  if (local.buffer != nullptr and local.generation == current) {
+    return *local.buffer;
+  }
+
+  // the buffer of an ended thread is reused, so its lane continues, only the main thread keeps a lane of its own
+  bool main = std::this_thread::get_id() == main_thread;
+  Buffer* claimed = nullptr;
+  for (Buffer* B = main ? nullptr : buffers.load(std::memory_order_acquire); B != nullptr and claimed == nullptr; B = B->next) {
+    bool expected = false;
+    if (B->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      claimed = B;
+    }
+  }
+
+  if (claimed == nullptr) {
+    claimed = new Buffer();
+    claimed->lane = lanes.fetch_add(1);
+    claimed->main = main;
+    claimed->in_use.store(true, std::memory_order_relaxed);
+
+    claimed->next = buffers.load(std::memory_order_relaxed);
+    while (not buffers.compare_exchange_weak(claimed->next, claimed, std::memory_order_release, std::memory_order_relaxed)) {}
+  }
+
+  local.buffer = claimed;
+  local.generation = current;
+
+  return *claimed;
+}
+
+void Timeline::start() {
+  active.store(false);
+
+  Buffer* B = buffers.exchange(nullptr);
+  while (B != nullptr) {
+    Buffer* next = B->next;
+    delete B;
+    B = next;
+  }
+  lanes.store(0);
+  generation.fetch_add(1, std::memory_order_release);
+
+  main_thread = std::this_thread::get_id();
+  origin = std::chrono::steady_clock::now();
+
+  active.store(true);
+}
+
+void Timeline::stop() {
+  active.store(false);
+}
+
+double Timeline::now() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Timeline::record(const char* name, const char* category, double start, double end, const char* arg_name, long arg) {
+  if (not enabled()) {
+    return;
+  }
+
+  buffer().events.push_back({name, category, start, end - start, arg_name, arg});
+}
+
+std::size_t Timeline::size() {
+  std::size_t count = 0;
+  for (Buffer* B = buffers.load(std::memory_order_acquire); B != nullptr; B = B->next) {
+    count += B->events.size();
+  }
+
+  return count;
+}
+
+nlohmann::json Timeline::trace() {
+  nlohmann::json events = nlohmann::json::array();
+
+  for (Buffer* B = buffers.load(std::memory_order_acquire); B != nullptr; B = B->next) {
+    std::string thread = B->main ? "main" : "worker " + std::to_string(B->lane);
+    events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", B->lane}, {"args", {{"name", thread}}}});
+    events.push_back({{"name", "thread_sort_index"}, {"ph", "M"}, {"pid", 1}, {"tid", B->lane}, {"args", {{"sort_index", B->main ? -1 : (int) B->lane}}}});
+
+    for (const TimelineEvent& E : B->events) {
+      nlohmann::json event = {
+        {"name", E.name}, {"cat", E.category}, {"ph", "X"}, {"ts", E.start}, {"dur", E.duration}, {"pid", 1}, {"tid", B->lane}
+      };
+      if (E.arg_name != nullptr) {
+        event["args"] = {{E.arg_name, E.arg}};
+      }
+
+      events.push_back(event);
+    }
+  }
+
+  return {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+}
+
+void Timeline::write(std::ostream& out) {
+  out << trace().dump() << std::endl;
+}
@@ -0,0 +1,88 @@
+#include <trace.hpp>
+
+Medium::Medium(): indices(), counts(), size(0) {}
+
+float Medium::enter(float index) {
+  unsigned i = 0;
+  while (i < size and indices[i] < index) {
+    i++;
+  }
+
+  if (i < size and indices[i] == index) {
+    counts[i]++;
+    return index;
+  }
+
+  if (size == MEDIUM_DEPTH) { // nested too deep, forget about this object
+    return index;
+  }
+
+  for (unsigned k = size; k > i; k--) {
+    indices[k] = indices[k - 1];
+    counts[k] = counts[k - 1];
+  }
+  indices[i] = index;
+  counts[i] = 1;
+  size++;
+
+  return index;
+}
+
+float Medium::leave(float index, float global_index) {
+  unsigned i = 0;
+  while (i < size and indices[i] != index) {
+    i++;
+  }
+
+  if (i == size) { // left an object, that was never entered
+    return global_index;
+  }
+
+  if (--counts[i] == 0) {
+    for (unsigned k = i + 1; k < size; k++) {
+      indices[k - 1] = indices[k];
+      counts[k - 1] = counts[k];
+    }
+    size--;
+  }
+
+  return size == 0 ? global_index : indices[0];
+}
+
+
+TraceTask::TraceTask(const Ray& ray, const LightIntensity& weight, unsigned depth):
+  ray(ray), weight(weight), depth(depth), stage(TraceStage::SHADE),
+  point(Eigen::Vector4d::Zero()), normal(Eigen::Vector4d::Zero()),
+  reflected(), refracted(), index(1), value(), coefficient()
+  {}
+
+TraceTask::TraceTask(): TraceTask(Ray(), LightIntensity(), 0) {}
+
+
+TraceStack::TraceStack(): tasks(), count(0) {}
+
+void TraceStack::push(const TraceTask& task) {
+  CUSTOM_ASSERT(count < TRACE_STACK_SIZE);
+
+  tasks[count++] = task;
+}
+
+void TraceStack::pop() {
+  CUSTOM_ASSERT(count > 0);
+
+  count--;
+}
+
+TraceTask& TraceStack::top() {
+  CUSTOM_ASSERT(count > 0);
+
+  return tasks[count - 1];
+}
+
+bool TraceStack::empty() const {
+  return count == 0;
+}
+
+unsigned TraceStack::size() const {
+  return count;
+}
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <numeric>
+#include <mutex>
+
+#include <wavefront.hpp>
+#include <render.hpp>
+#include <scene.hpp>
+
+WavefrontRay::WavefrontRay(const Ray& ray, const LightIntensity& weight, unsigned parent, const LightIntensity& coefficient, const Medium& medium, unsigned sequence):
+  ray(ray), weight(weight), parent(parent), coefficient(coefficient), medium(medium), sequence(sequence),
+  hit(false), ip(), index(0), shadows(0), lights(0), value()
+  {}
+
+/**
+ * \brief Spreads the lowest 9 bits of v, so that two zero bits follow each of them.
+ */
+static unsigned spread_bits(unsigned v) {
+  v &= 0x1ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+
+  return v;
+}
+
+unsigned coherence_key(const Ray& ray, const Eigen::Vector3d& min, const Eigen::Vector3d& max) {
+  unsigned octant = 0;
+  unsigned morton = 0;
+
+  for (unsigned i = 0; i < 3; i++) {
+    if (ray.direction()[i] < 0) {
+      octant |= 1 << i;
+    }
+
+    double extent = max[i] - min[i];
+    double cell = extent > 0 ? (ray.start_point()[i] - min[i]) / extent * 511 : 0;
+    morton |= spread_bits((unsigned) std::clamp(cell, 0.0, 511.0)) << i;
+  }
+
+  return octant << 27 | morton;
+}
+
+void sort_coherent(std::vector<WavefrontRay>& queue, std::vector<WavefrontRay>& scratch) {
+  if (queue.size() < 2) {
+    return;
+  }
+
+  Eigen::Vector3d min = queue[0].ray.start_point().head<3>();
+  Eigen::Vector3d max = min;
+  for (const WavefrontRay& R : queue) {
+    min = min.cwiseMin(R.ray.start_point().head<3>());
+    max = max.cwiseMax(R.ray.start_point().head<3>());
+  }
+
+  // counting sort into bins of the highest key bits
+  std::vector<unsigned> bins(queue.size());
+  std::vector<unsigned> offsets((1 << COHERENCE_BIN_BITS) + 1, 0);
+  for (unsigned r = 0; r < queue.size(); r++) {
+    bins[r] = coherence_key(queue[r].ray, min, max) >> (30 - COHERENCE_BIN_BITS);
+    offsets[bins[r] + 1]++;
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  scratch.resize(queue.size(), queue[0]);
+  for (unsigned r = 0; r < queue.size(); r++) {
+    scratch[offsets[bins[r]]++] = queue[r];
+  }
+  queue.swap(scratch);
+}
+
+void Scene::intersect_stage(std::vector<WavefrontRay>& queue, unsigned threads) const {
+  parallel_for(queue.size(), threads, [this, &queue](unsigned begin, unsigned end) {
+    TimelineSpan span("intersect", "wavefront", "first ray", begin);
+
+    for (unsigned r = begin; r < end; r++) {
+      WavefrontRay& R = queue[r];
+
+      R.hit = objects->intersect(R.ray, &R.ip);
+      if (not R.hit) {
+        continue;
+      }
+
+      // every path keeps track of its own medium, so rays can be processed in any order
+      R.index = R.ip.inside ? R.medium.leave(R.ip.index, global_index) : R.medium.enter(R.ip.index);
+    }
+  });
+}
+
+void Scene::shadow_stage(std::vector<WavefrontRay>& queue, std::vector<ShadowRay>& shadows, unsigned threads, const std::vector<PixelSample>* primaries) {
+  unsigned width = dpi * L_y;
+
+  // choose_light() draws random numbers, so the shadow rays are emitted sequentially
+  double emit_start = Timeline::now();
+  shadows.clear();
+  for (unsigned r = 0; r < queue.size(); r++) {
+    WavefrontRay& R = queue[r];
+    if (not R.hit) {
+      continue;
+    }
+    render_stats.hits++;
+
+    unsigned pixel = primaries != nullptr ? (*primaries)[R.parent].pixel : 0;
+    const std::vector<unsigned>& lights = primaries != nullptr ? light_grid.lights(light_grid.tile(pixel / width, pixel % width)) : light_grid.all();
+
+    R.shadows = shadows.size();
+    R.lights = light_count(lights);
+    for (unsigned k = 0; k < R.lights; k++) {
+      shadows.push_back({r, choose_light(R.ip.point, k, lights), LightSample()});
+    }
+  }
+  Timeline::record("emit shadow rays", "wavefront", emit_start, Timeline::now());
+
+  // every range is traced by its own thread, with its own cache of occluders
+  std::mutex report_mutex;
+  parallel_for(shadows.size(), threads, [this, &queue, &shadows, &report_mutex](unsigned begin, unsigned end) {
+    TimelineSpan span("shadow rays", "wavefront", "first ray", begin);
+    OccluderCache cache(sources.size());
+
+    for (unsigned k = begin; k < end; k++) {
+      const WavefrontRay& R = queue[shadows[k].ray];
+      shadows[k].sample = sample_light(R.ray, R.ip, shadows[k].light.source, cache);
+    }
+
+    std::lock_guard<std::mutex> lock(report_mutex);
+    occluder_report += cache.report();
+  });
+
+  // the lights are added in the same order as by trace_ray, as the screen blend is only commutative up to rounding
+  parallel_for(queue.size(), threads, [this, &queue, &shadows](unsigned begin, unsigned end) {
+    TimelineSpan span("shade", "wavefront", "first ray", begin);
+
+    for (unsigned r = begin; r < end; r++) {
+      WavefrontRay& R = queue[r];
+      if (not R.hit) {
+        continue;
+      }
+
+      R.value = R.ip.color.ambient * ambient_light;
+
+      LightSum lights;
+      for (unsigned k = 0; k < R.lights; k++) {
+        const ShadowRay& shadow = shadows[R.shadows + k];
+        lights.add(R.value, shadow.sample, shadow.light.weight);
+      }
+      lights.finish(R.value);
+    }
+  });
+}
+
+void Scene::secondary_stage(std::vector<WavefrontRay>& queue, std::vector<WavefrontRay>& secondary) {
+  TimelineSpan span("emit secondary rays", "wavefront");
+  secondary.clear();
+
+  // survival() draws random numbers and counts, so the secondary rays are emitted sequentially
+  for (unsigned r = 0; r < queue.size(); r++) {
+    const WavefrontRay& R = queue[r];
+    if (not R.hit) {
+      continue;
+    }
+
+    const ColData& texture = R.ip.color;
+
+    float factor = survival(texture.reflected, R.weight * texture.reflected);
+    if (factor > 0) {
+      LightIntensity coefficient = amplified(texture.reflected, factor);
+      secondary.emplace_back(R.ray.reflect(R.ip.point, R.ip.normal), R.weight * coefficient, r, coefficient, R.medium, secondary.size());
+    }
+
+    if (R.ray.index() < R.index || acosf64(R.ray.direction().dot(R.ip.normal)) < asinf64(R.ray.index() / R.index)) { // otherwise we have total reflection
+      factor = survival(texture.refracted, R.weight * texture.refracted);
+      if (factor > 0) {
+        LightIntensity coefficient = amplified(texture.refracted, factor);
+        secondary.emplace_back(R.ray.refract(R.ip.point, R.ip.normal, R.index), R.weight * coefficient, r, coefficient, R.medium, secondary.size());
+      }
+    }
+  }
+}
+
+void Scene::trace_wavefront(const std::vector<PixelSample>& samples, std::vector<LightIntensity>& values, const RenderOptions& options) {
+  unsigned count = samples.size();
+  unsigned threads = options.thread_count();
+  unsigned batch_size = std::max(1u, options.batch_size);
+
+  // one queue of rays per recursion depth, reused for every batch
+  std::vector<std::vector<WavefrontRay>> queues(max_recursion_depth + 1);
+  std::vector<ShadowRay> shadows;
+  std::vector<WavefrontRay> scratch;
+
+  for (unsigned first = 0; first < count; first += batch_size) {
+    unsigned last = std::min(count, first + batch_size);
+    TimelineSpan span("batch", "wavefront", "first sample", first);
+
+    queues[0].clear();
+    for (unsigned s = first; s < last; s++) {
+      queues[0].emplace_back(primary_ray(samples[s]), LightIntensity::white(), s, LightIntensity::white(), Medium(), s - first);
+    }
+
+    for (unsigned depth = 0; depth <= max_recursion_depth; depth++) {
+      render_stats.max_depth = std::max(render_stats.max_depth, depth);
+      intersect_stage(queues[depth], threads);
+      shadow_stage(queues[depth], shadows, threads, depth == 0 ? &samples : nullptr);
+
+      if (depth == max_recursion_depth) {
+        break;
+      }
+
+      secondary_stage(queues[depth], queues[depth + 1]);
+
+      if (queues[depth + 1].empty()) {
+        break;
+      }
+
+      if (options.sort_secondary) {
+        sort_coherent(queues[depth + 1], scratch);
+      }
+    }
+
+    // the screen blend is not linear, so secondary rays are added to their parents from the deepest queue upwards,
+    // every parent receives its reflected ray before its refracted ray
+    std::vector<unsigned> emitted;
+    for (unsigned depth = max_recursion_depth; depth > 0; depth--) {
+      std::vector<WavefrontRay>& queue = queues[depth];
+
+      emitted.resize(queue.size());
+      for (unsigned r = 0; r < queue.size(); r++) {
+        emitted[queue[r].sequence] = r;
+      }
+
+      for (unsigned r : emitted) {
+        queues[depth - 1][queue[r].parent].value += queue[r].coefficient * queue[r].value;
+      }
+      queue.clear();
+    }
+
+    for (const WavefrontRay& R : queues[0]) {
+      values[R.parent] = R.value;
+    }
+
+    progress_bar((float) last / count);
+  }
+}
@@ -19,6 +19,23 @@ std::string scene_str = ""
 "\"ambient\": \"white\", \"diffuse\": [1, 1, 1], \"specular\": [1, 1, 1], \"reflected\": [1, 1, 1], \"refracted\": \"white\", \"shininess\": 1}, "
 "\"index\": 1}}]}";
 
+std::string shadow_str = ""
+"{\"screen\": {\"dpi\": 8, \"dimensions\": [8, 8], \"position\": [-4, -4, -10], \"observer\": [0, 0, -20]}, "
+"\"medium\": {\"ambient\": \"black\", \"index\": 1, \"recursion\": 0}, "
+"\"sources\": [{\"position\": [0, 0, -6], \"intensity\": [0.8, 0.8, 0.8]}], "
+"\"objects\": [{\"halfSpace\": {\"position\": [0, 0, 0], \"normal\": [0, 0, -1], \"color\": {"
+"\"ambient\": \"black\", \"diffuse\": \"white\", \"specular\": \"black\", \"reflected\": \"black\", \"refracted\": \"black\", \"shininess\": 1}, \"index\": 1}}, "
+"{\"sphere\": {\"position\": [0, 0, -2], \"radius\": 1, \"color\": {"
+"\"ambient\": \"black\", \"diffuse\": \"white\", \"specular\": \"black\", \"reflected\": \"black\", \"refracted\": \"black\", \"shininess\": 1}, \"index\": 1}}]}";
+
+std::string mirror_str = ""
+"{\"screen\": {\"dpi\": 1, \"dimensions\": [1, 1], \"position\": [-0.5, -0.5, -10], \"observer\": [0, 0, -20]}, "
+"\"medium\": {\"ambient\": [0.2, 0.2, 0.2], \"index\": 1, \"recursion\": 4, \"threshold\": 0.1}, "
+"\"sources\": [{\"position\": [0, 0, -20],\"intensity\": [1, 1, 1]}], "
+"\"objects\": [{\"sphere\": {\"position\": [0, 0, 0], \"radius\": 50, \"color\": {"
+"\"ambient\": \"white\", \"diffuse\": [0.5, 0.5, 0.5], \"specular\": [0, 0, 0], \"reflected\": [0.2, 0.2, 0.2], \"refracted\": \"black\", \"shininess\": 1}, "
+"\"index\": 1}}]}";
+
 int main() {
   std::cout << scene_str << std::endl;
 
@@ -30,5 +47,336 @@ int main() {
   
   CUSTOM_ASSERT(li.at(0) == 1 and li.at(1) == 1 and li.at(2) == 1);
 
+  std::istringstream mirror_buf(mirror_str);
+  Scene mirror = Scene::read_parameters(mirror_buf);
+  mirror.generate();
+
+  // the observer is inside of a mirroring sphere:
+  // the first reflection has weight 0.2, the second only 0.04 < threshold and both refractions are black
+  const PruningReport& pruning = mirror.pruning();
+  CUSTOM_ASSERT(pruning.traced_rays == 1);
+  CUSTOM_ASSERT(pruning.negligible_rays == 1);
+  CUSTOM_ASSERT(pruning.black_rays == 2);
+  CUSTOM_ASSERT(pruning.roulette_rays == 0 and pruning.pruned() == 3);
+  CUSTOM_ASSERT(mirror.statistics().secondary_rays == 1 and mirror.statistics().max_depth == 1 and mirror.statistics().hits == 2);
+
+  std::string roulette_str = mirror_str;
+  roulette_str.replace(roulette_str.find("\"threshold\": 0.1"), 16, "\"roulette\": 0.9");
+  std::istringstream roulette_buf(roulette_str);
+  Scene roulette = Scene::read_parameters(roulette_buf);
+
+  cv::Mat_<cv::Vec3b> img1 = roulette.generate();
+  PruningReport first = roulette.pruning();
+  cv::Mat_<cv::Vec3b> img2 = roulette.generate();
+
+  // every path is ended by the roulette or the recursion depth and rendering is reproducible
+  CUSTOM_ASSERT(first.roulette_rays + first.traced_rays > 0 and first.negligible_rays == 0);
+  CUSTOM_ASSERT(roulette.pruning().roulette_rays == first.roulette_rays and roulette.pruning().traced_rays == first.traced_rays);
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    CUSTOM_ASSERT(img1(0, 0)[k] == img2(0, 0)[k]);
+  }
+
+  std::string wavefront_str = scene_str;
+  wavefront_str.replace(wavefront_str.find("\"recursion\": 0"), 14, "\"recursion\": 3");
+  wavefront_str.replace(wavefront_str.find("\"refracted\": \"white\""), 20, "\"refracted\": \"black\"");
+  wavefront_str.replace(wavefront_str.find("\"dpi\": 128"), 10, "\"dpi\": 16");
+  wavefront_str.insert(1, "\"render\": {\"mode\": \"wavefront\", \"threads\": 3, \"batch\": 1024, \"sort\": true}, ");
+  std::istringstream wavefront_buf(wavefront_str);
+  Scene wavefront = Scene::read_parameters(wavefront_buf);
+
+  cv::Mat_<cv::Vec3b> wavefront_img = wavefront.generate();
+  PruningReport wavefront_pruning = wavefront.pruning();
+  OccluderReport wavefront_occluders = wavefront.occluders();
+  cv::Mat_<cv::Vec3b> pixel_img = wavefront.generate(RenderOptions());
+
+  // without refraction both modes give the same image, sorting the secondary rays changes nothing
+  CUSTOM_ASSERT(wavefront_img.rows == 32 and wavefront_img.cols == 64);
+  for (int i = 0; i < pixel_img.rows; i++) {
+    for (int j = 0; j < pixel_img.cols; j++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        CUSTOM_ASSERT(wavefront_img(i, j)[k] == pixel_img(i, j)[k]);
+      }
+    }
+  }
+  CUSTOM_ASSERT(wavefront_pruning.traced_rays == wavefront.pruning().traced_rays);
+  CUSTOM_ASSERT(wavefront_pruning.black_rays == wavefront.pruning().black_rays);
+
+  // both modes test the same shadow rays, the cached occluders of the reflected rays block many of them
+  CUSTOM_ASSERT(wavefront_occluders.shadow_rays == wavefront.occluders().shadow_rays);
+  CUSTOM_ASSERT(wavefront.occluders().cache_hits > 0 and wavefront.occluders().hit_rate() <= 1);
+
+  std::string lights_str = wavefront_str;
+  lights_str.replace(lights_str.find("\"sources\": ["), 12, "\"sources\": [{\"position\": [5, 5, -20], \"intensity\": [0.3, 0.3, 0.3]}, "
+                                                             "{\"position\": [-5, 5, -20], \"intensity\": [0.3, 0.3, 0.3]}, ");
+  lights_str.replace(lights_str.find("\"ambient\": \"white\""), 18, "\"ambient\": \"black\"");
+  std::istringstream lights_buf(lights_str);
+  Scene lights = Scene::read_parameters(lights_buf);
+
+  RenderOptions sampled;
+  sampled.light_samples = 1;
+  cv::Mat_<cv::Vec3b> exact_img = lights.generate();
+  cv::Mat_<cv::Vec3b> sampled_img1 = lights.generate(sampled);
+  cv::Mat_<cv::Vec3b> sampled_img2 = lights.generate(sampled);
+
+  // choosing one of three lights is noisy, but reproducible and about as bright as shading by all of them
+  double exact_brightness = 0, sampled_brightness = 0;
+  for (int i = 0; i < exact_img.rows; i++) {
+    for (int j = 0; j < exact_img.cols; j++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        CUSTOM_ASSERT(sampled_img1(i, j)[k] == sampled_img2(i, j)[k]);
+        exact_brightness += exact_img(i, j)[k];
+        sampled_brightness += sampled_img1(i, j)[k];
+      }
+    }
+  }
+  CUSTOM_ASSERT(abs(sampled_brightness / exact_brightness - 1) < 0.1);
+
+  std::string ranged_str = wavefront_str;
+  ranged_str.replace(ranged_str.find("\"sources\": ["), 12, "\"sources\": [{\"position\": [0, 0, -200], \"intensity\": [1, 1, 1], \"radius\": 10}, ");
+  std::istringstream ranged_buf(ranged_str);
+  Scene ranged = Scene::read_parameters(ranged_buf);
+
+  std::string faded_str = wavefront_str;
+  faded_str.replace(faded_str.find("\"intensity\": [1, 1, 1]"), 22, "\"intensity\": [1, 1, 1], \"radius\": 30");
+  faded_str.replace(faded_str.find("\"ambient\": \"white\""), 18, "\"ambient\": \"black\"");
+  std::istringstream faded_buf(faded_str);
+  Scene faded = Scene::read_parameters(faded_buf);
+  std::string unfaded_str = faded_str;
+  unfaded_str.replace(unfaded_str.find(", \"radius\": 30"), 14, "");
+  std::istringstream unfaded_buf(unfaded_str);
+  Scene unfaded = Scene::read_parameters(unfaded_buf);
+
+  RenderOptions wavefront_options;
+  wavefront_options.mode = RenderMode::WAVEFRONT;
+  wavefront_options.threads = 3;
+
+  // a light out of range of the whole scene changes nothing, a light with falloff is dimmer
+  for (const RenderOptions& options : {RenderOptions(), wavefront_options}) {
+    cv::Mat_<cv::Vec3b> plain_img = wavefront.generate(options);
+    cv::Mat_<cv::Vec3b> ranged_img = ranged.generate(options);
+    cv::Mat_<cv::Vec3b> faded_img = faded.generate(options);
+    cv::Mat_<cv::Vec3b> unfaded_img = unfaded.generate(options);
+
+    double faded_brightness = 0, unfaded_brightness = 0;
+    for (int i = 0; i < plain_img.rows; i++) {
+      for (int j = 0; j < plain_img.cols; j++) {
+        for (unsigned k = 0; k < NUM_COL; k++) {
+          CUSTOM_ASSERT(ranged_img(i, j)[k] == plain_img(i, j)[k]);
+          CUSTOM_ASSERT(faded_img(i, j)[k] <= unfaded_img(i, j)[k]);
+          faded_brightness += faded_img(i, j)[k];
+          unfaded_brightness += unfaded_img(i, j)[k];
+        }
+      }
+    }
+    CUSTOM_ASSERT(faded_brightness > 0 and faded_brightness < 0.8 * unfaded_brightness);
+  }
+
+  std::string negative_str = ranged_str;
+  negative_str.replace(negative_str.find("\"radius\": 10"), 12, "\"radius\": 0");
+  std::istringstream negative_buf(negative_str);
+  bool rejected = false;
+  try {
+    Scene::read_parameters(negative_buf);
+  }
+  catch (Cpp_Raytracing_INVALID_INPUT&) {
+    rejected = true;
+  }
+  CUSTOM_ASSERT(rejected);
+
+  std::istringstream shadow_buf(shadow_str);
+  Scene hard = Scene::read_parameters(shadow_buf);
+  std::string soft_str = shadow_str;
+  soft_str.replace(soft_str.find("\"intensity\": [0.8, 0.8, 0.8]"), 28, "\"intensity\": [0.8, 0.8, 0.8], \"rectangle\": [[2, 0, 0], [0, 2, 0]]");
+  std::istringstream soft_buf(soft_str);
+  Scene soft = Scene::read_parameters(soft_buf);
+
+  cv::Mat_<cv::Vec3b> hard_img = hard.generate();
+  cv::Mat_<cv::Vec3b> soft_img = soft.generate();
+  cv::Mat_<cv::Vec3b> soft_wavefront_img = soft.generate(wavefront_options);
+
+  // the area light lights part of the hard shadow, refining only there, and both modes sample it identically
+  unsigned penumbra = 0;
+  for (int i = 0; i < hard_img.rows; i++) {
+    for (int j = 0; j < hard_img.cols; j++) {
+      if (hard_img(i, j)[0] == 0 and soft_img(i, j)[0] > 0) {
+        penumbra++;
+      }
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        CUSTOM_ASSERT(soft_img(i, j)[k] == soft_wavefront_img(i, j)[k]);
+      }
+    }
+  }
+  CUSTOM_ASSERT(penumbra > 0);
+  CUSTOM_ASSERT(soft.occluders().shadow_rays < 8 * hard.occluders().shadow_rays);
+
+  // the order of the pixels changes nothing, not even the samples of the area light
+  for (PixelOrder order : {PixelOrder::MORTON, PixelOrder::HILBERT}) {
+    RenderOptions tiled_options;
+    tiled_options.pixel_order = order;
+    tiled_options.tile_size = 16;
+    RenderOptions tiled_wavefront_options = wavefront_options;
+    tiled_wavefront_options.pixel_order = order;
+    tiled_wavefront_options.tile_size = 16;
+
+    cv::Mat_<cv::Vec3b> tiled_img = soft.generate(tiled_options);
+    cv::Mat_<cv::Vec3b> tiled_wavefront_img = soft.generate(tiled_wavefront_options);
+    for (int i = 0; i < soft_img.rows; i++) {
+      for (int j = 0; j < soft_img.cols; j++) {
+        for (unsigned k = 0; k < NUM_COL; k++) {
+          CUSTOM_ASSERT(tiled_img(i, j)[k] == soft_img(i, j)[k] and tiled_wavefront_img(i, j)[k] == soft_img(i, j)[k]);
+        }
+      }
+    }
+  }
+
+  std::string spiral_str = shadow_str;
+  spiral_str.insert(1, "\"render\": {\"order\": \"spiral\"}, ");
+  std::istringstream spiral_buf(spiral_str);
+  bool unknown_order = false;
+  try {
+    Scene::read_parameters(spiral_buf);
+  }
+  catch (Cpp_Raytracing_INVALID_INPUT&) {
+    unknown_order = true;
+  }
+  CUSTOM_ASSERT(unknown_order);
+
+  RenderOptions aa_options;
+  aa_options.max_samples = 16;
+  RenderOptions aa_wavefront_options = wavefront_options;
+  aa_wavefront_options.max_samples = 16;
+
+  cv::Mat_<cv::Vec3b> aa_img = hard.generate(aa_options);
+  cv::Mat_<cv::Vec3b> samples_img = hard.sample_image();
+  cv::Mat_<cv::Vec3b> aa_again_img = hard.generate(aa_options);
+  cv::Mat_<cv::Vec3b> aa_wavefront_img = hard.generate(aa_wavefront_options);
+  unsigned long aa_primary_rays = hard.primary_rays();
+  hard.generate();
+  CUSTOM_ASSERT(hard.primary_rays() == (unsigned long) (hard_img.rows * hard_img.cols) and aa_primary_rays > hard.primary_rays());
+
+  // only the edges of the sphere and its shadow are refined, reproducibly and identically in both modes
+  unsigned refined = 0;
+  for (int i = 0; i < hard_img.rows; i++) {
+    for (int j = 0; j < hard_img.cols; j++) {
+      CUSTOM_ASSERT(samples_img(i, j)[0] == 0 or samples_img(i, j)[0] == 255);
+      if (samples_img(i, j)[0] == 255) {
+        refined++;
+      }
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        if (samples_img(i, j)[0] == 0) {
+          CUSTOM_ASSERT(aa_img(i, j)[k] == hard_img(i, j)[k]);
+        }
+        CUSTOM_ASSERT(aa_img(i, j)[k] == aa_again_img(i, j)[k]);
+        CUSTOM_ASSERT(aa_img(i, j)[k] == aa_wavefront_img(i, j)[k]);
+      }
+    }
+  }
+  CUSTOM_ASSERT(refined > 0 and refined < (unsigned) (hard_img.rows * hard_img.cols) / 4);
+
+  // without limits, progressive rendering ends with the complete image after a frame per pass
+  std::vector<float> progress;
+  ProgressiveFrame full = hard.generate_progressive(aa_options, [&progress](const ProgressiveFrame& F) {
+    progress.push_back(F.finished);
+  });
+  CUSTOM_ASSERT(full.complete and full.passes == 5 and progress.size() == 5);
+  CUSTOM_ASSERT(std::is_sorted(progress.begin(), progress.end()) and progress.back() == 1);
+
+  // the first pass is always completed, later ones stop as soon as the time budget is used up or the target is reached
+  RenderOptions budget_options;
+  budget_options.time_budget = 1e-9;
+  ProgressiveFrame coarse = hard.generate_progressive(budget_options);
+  CUSTOM_ASSERT(coarse.passes == 1 and not coarse.complete);
+  CUSTOM_ASSERT(coarse.finished * PROGRESSIVE_STEP * PROGRESSIVE_STEP == 1);
+
+  RenderOptions target_options;
+  target_options.coverage_target = 0.2;
+  ProgressiveFrame partial = hard.generate_progressive(target_options);
+  CUSTOM_ASSERT(partial.finished >= 0.2 and not partial.complete);
+
+  for (int i = 0; i < hard_img.rows; i++) {
+    for (int j = 0; j < hard_img.cols; j++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        CUSTOM_ASSERT(full.image(i, j)[k] == aa_img(i, j)[k] and full.coverage(i, j)[k] == 255);
+        if (partial.coverage(i, j)[k] == 255) {
+          CUSTOM_ASSERT(partial.image(i, j)[k] == hard_img(i, j)[k]);
+        }
+      }
+    }
+  }
+
+  // the cost map records the work of every pixel without changing the image
+  RenderOptions cost_options = aa_options;
+  cost_options.cost_map = true;
+  cv::Mat_<cv::Vec3b> cost_img = hard.generate(cost_options);
+  std::vector<PixelCost> costs = hard.costs();
+  CUSTOM_ASSERT(costs.size() == (std::size_t) (hard_img.rows * hard_img.cols));
+
+  unsigned long cost_primary = 0;
+  unsigned long cost_shadow = 0;
+  for (const PixelCost& cost : costs) {
+    CUSTOM_ASSERT(cost.primary >= 1 and cost.secondary == 0 and cost.included == 0 and cost.seconds > 0);
+    cost_primary += cost.primary;
+    cost_shadow += cost.shadow;
+  }
+  CUSTOM_ASSERT(cost_primary == hard.primary_rays() and cost_shadow == hard.occluders().shadow_rays);
+
+  for (int i = 0; i < hard_img.rows; i++) {
+    for (int j = 0; j < hard_img.cols; j++) {
+      for (unsigned k = 0; k < NUM_COL; k++) {
+        CUSTOM_ASSERT(cost_img(i, j)[k] == aa_img(i, j)[k]);
+      }
+    }
+  }
+
+  std::ostringstream raw_costs;
+  hard.write_costs(raw_costs);
+  std::string cost_header = "cost 64 64 " + PixelCost::channel_names + "\n";
+  CUSTOM_ASSERT(raw_costs.str().rfind(cost_header, 0) == 0);
+  CUSTOM_ASSERT(raw_costs.str().size() == cost_header.size() + costs.size() * PixelCost::channels * sizeof(float));
+
+  hard.generate(wavefront_options);
+  CUSTOM_ASSERT(hard.costs().empty());
+
+  // every ray hits the half space, the sphere blocks some of the shadow rays, both modes count the same
+  RenderStats wavefront_stats = hard.statistics();
+  hard.generate();
+  const RenderStats& stats = hard.statistics();
+  CUSTOM_ASSERT(stats.primary_rays == 64 * 64 and stats.hits == stats.primary_rays and stats.secondary_rays == 0 and stats.max_depth == 0);
+  CUSTOM_ASSERT(stats.shadow_rays == hard.occluders().shadow_rays and stats.occlusion_rate() > 0 and stats.occlusion_rate() < 1);
+  CUSTOM_ASSERT(stats.hits == wavefront_stats.hits and stats.shadow_rays == wavefront_stats.shadow_rays and stats.occluded_rays == wavefront_stats.occluded_rays);
+  CUSTOM_ASSERT(stats.phases.size() == 3 and stats.phases[1].first == "trace" and stats.seconds() > 0 and stats.peak_memory_kb > 0);
+  CUSTOM_ASSERT(stats.json()["rays"]["primary"] == 64 * 64 and stats.json()["phases"].contains("store"));
+
+  std::ostringstream prometheus;
+  stats.write_prometheus(prometheus, "hard");
+  CUSTOM_ASSERT(prometheus.str().find("# TYPE raytracing_rays_total counter\n") != std::string::npos);
+  CUSTOM_ASSERT(prometheus.str().find("raytracing_rays_total{scene=\"hard\",type=\"primary\"} 4096\n") != std::string::npos);
+
+  // without anti-aliasing every pixel has one primary ray, the estimated work is close to the actual one
+  double actual_shadow_rays = stats.shadow_rays;
+  RenderEstimate estimate = hard.estimate(hard.options());
+  CUSTOM_ASSERT(estimate.pixels == 64 * 64 and estimate.strata >= ESTIMATE_MIN_STRATA and estimate.traced_pixels < estimate.pixels);
+  CUSTOM_ASSERT(estimate.primary_rays.low == 64 * 64 and estimate.primary_rays.high == 64 * 64 and estimate.refined_fraction.value == 0);
+  CUSTOM_ASSERT(estimate.shadow_rays.low <= estimate.shadow_rays.value and estimate.shadow_rays.value <= estimate.shadow_rays.high);
+  CUSTOM_ASSERT(abs(estimate.shadow_rays.value - actual_shadow_rays) < 0.05 * actual_shadow_rays);
+  CUSTOM_ASSERT(estimate.seconds.value > 0 and estimate.memory_kb > 0 and estimate.json()["rays"]["primary"]["value"] == 64 * 64);
+  CUSTOM_ASSERT(hard.costs().empty() and hard.statistics().primary_rays == estimate.traced_pixels);
+
+  RenderEstimate aa_estimate = hard.estimate(aa_options);
+  CUSTOM_ASSERT(aa_estimate.refined_fraction.value > 0 and aa_estimate.traced_pixels > estimate.traced_pixels);
+  CUSTOM_ASSERT(aa_estimate.primary_rays.low <= aa_primary_rays and aa_primary_rays <= aa_estimate.primary_rays.high);
+
+  std::string deep_str = mirror_str;
+  deep_str.replace(deep_str.find("\"recursion\": 4"), 14, "\"recursion\": " + std::to_string(TRACE_STACK_SIZE));
+  std::istringstream deep_buf(deep_str);
+  bool thrown = false;
+  try {
+    Scene::read_parameters(deep_buf);
+  }
+  catch (Cpp_Raytracing_INVALID_INPUT&) {
+    thrown = true;
+  }
+  CUSTOM_ASSERT(thrown);
+
   return 0;
 }
\ No newline at end of file
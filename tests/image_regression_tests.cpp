@@ -0,0 +1,76 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include <image_comparison.hpp>
+#include <scene.hpp>
+#include <custom_exceptions.hpp>
+#include <defines.h>
+
+/**
+ * Renders examples and compares them to their reference images resources/example<n>_output.png.
+ *
+ * usage: image_regression_tests [--update] [example ...]
+ *
+ * Like the benchmarks, it runs in the build directory. Without examples, all are checked. If a render is not
+ * within the ImageTolerance, its amplified difference to the reference is written to example<n>_diff.png.
+ * With --update, the references are replaced by the renders instead, e.g. after an intended change of the images.
+ */
+
+int main(int argc, char** argv) {
+  bool update = false;
+  std::vector<int> examples;
+
+  for (int k = 1; k < argc; k++) {
+    std::string arg = argv[k];
+    if (arg == "--update") {
+      update = true;
+    }
+    else {
+      examples.push_back(std::stoi(arg));
+    }
+  }
+
+  if (examples.empty()) {
+    for (int k = 1; k <= NUM_EXAMPLES; k++) {
+      examples.push_back(k);
+    }
+  }
+
+  ImageTolerance tolerance;
+  bool passed = true;
+
+  for (int example : examples) {
+    std::string name = "example" + std::to_string(example);
+    std::ifstream input("../examples/" + name + ".json");
+    CUSTOM_ASSERT(input.is_open());
+
+    Scene scene = Scene::read_parameters(input);
+    cv::Mat_<cv::Vec3b> image = scene.generate();
+
+    std::string reference_path = "../resources/" + name + "_output.png";
+    if (update) {
+      cv::imwrite(reference_path, image);
+      std::cout << "Updated " << reference_path << "." << std::endl;
+      continue;
+    }
+
+    cv::Mat_<cv::Vec3b> reference = cv::imread(reference_path, cv::IMREAD_COLOR);
+    CUSTOM_ASSERT(not reference.empty());
+
+    ImageComparison comparison = ImageComparison::compare(image, reference, tolerance.pixel_error);
+    std::cout << name << ":\n" << comparison << std::endl;
+
+    if (not comparison.within(tolerance)) {
+      cv::imwrite(name + "_diff.png", ImageComparison::difference(image, reference));
+      std::cout << name << " drifted from " << reference_path << ", the difference can be found as \"" << name << "_diff.png\"." << std::endl;
+      passed = false;
+    }
+  }
+
+  CUSTOM_ASSERT(passed);
+
+  return 0;
+}
@@ -1,18 +1,23 @@
 #include <Dense>
 #include <cassert>
+#include <map>
+#include <set>
 
 #include <composite.hpp>
 #include <light.hpp>
 #include <objects.hpp>
 #include <ray.hpp>
 #include <scene.hpp>
+#include <scene_generator.hpp>
 #include <custom_exceptions.hpp>
 #include <defines.h>
 
 int main() {
+  Arena arena;
+
   // interHalfSpace.md
-  BaseObject* obj1 = new HalfSpace(ColData(), 1, Eigen::Vector4d(0, 1, 0, 0));
-  RootObject* root = new RootObject(obj1);
+  BaseObject* obj1 = arena.create<HalfSpace>(ColData(), 1, Eigen::Vector4d(0, 1, 0, 0));
+  RootObject* root = arena.create<RootObject>(obj1);
   IntersectionPoint p;
 
   Ray r1(Eigen::Vector4d(-1, 1, 0, 1), Eigen::Vector4d(sqrtf64(2) / 2, - sqrtf64(2) / 2, 0, 0), 1);
@@ -27,13 +32,11 @@ int main() {
   root->intersect(r1, &p);
   CUSTOM_ASSERT((p.point - Eigen::Vector4d(-1, 0, 0, 1)).norm() < EPSILON);
 
-  delete root;
-
   
   // interModHalfSpace.md
-  obj1 = new HalfSpace(ColData(), 1, Eigen::Vector4d(0, 1, 0, 0));
-  BaseObject* obj2 = Transformation::Translation(obj1, 0, 1, 0);
-  root = new RootObject(obj2);
+  obj1 = arena.create<HalfSpace>(ColData(), 1, Eigen::Vector4d(0, 1, 0, 0));
+  BaseObject* obj2 = Transformation::Translation(arena, obj1, 0, 1, 0);
+  root = arena.create<RootObject>(obj2);
 
   r1 = Ray(Eigen::Vector4d(1, 2, 0, 1), Eigen::Vector4d(0, -1, 0, 0), 1);
   root->intersect(r1, &p);
@@ -43,12 +46,10 @@ int main() {
   root->intersect(r1, &p);
   CUSTOM_ASSERT((p.point - Eigen::Vector4d(0, 1, 0, 1)).norm() < EPSILON);
 
-  delete root;
-
 
   // interSphere.md
-  obj1 = new Sphere(ColData(), 1);
-  root = new RootObject(obj1);
+  obj1 = arena.create<Sphere>(ColData(), 1);
+  root = arena.create<RootObject>(obj1);
 
   r1 = Ray(Eigen::Vector4d(-3, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
   root->intersect(r1, &p);
@@ -58,7 +59,207 @@ int main() {
   root->intersect(r1, &p);
   CUSTOM_ASSERT((p.point - Eigen::Vector4d(sqrtf64(2) / 2, sqrtf64(2) / 2, 0, 1)).norm() < EPSILON);
 
-  delete root;
+
+  // folded quadric
+  obj1 = Quadric::UnitSphere(arena, ColData(), 1);
+  obj2 = Transformation::Scaling(arena, obj1, 2, 2, 2);
+  root = arena.create<RootObject>(Transformation::Translation(arena, obj2, 1, 0, 0));
+  root->fold_transformations(arena);
+
+  r1 = Ray(Eigen::Vector4d(-5, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(-1, 0, 0, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT(abs(p.distance - 4) < EPSILON);
+  CUSTOM_ASSERT((p.normal - Eigen::Vector4d(-1, 0, 0, 0)).norm() < EPSILON);
+  CUSTOM_ASSERT(root->included(Eigen::Vector4d(2.5, 0, 0, 1)));
+
+
+  // optimizer
+  obj1 = arena.create<Union>(std::vector<BaseObject*>{
+    arena.create<Union>(std::vector<BaseObject*>{arena.create<Sphere>(ColData(), 1)}),
+    Transformation::Scaling(arena, arena.create<Sphere>(ColData(), 1), 1, 1, 1)
+  });
+  obj2 = arena.create<Intersection>(std::vector<BaseObject*>{
+    Transformation::Translation(arena, arena.create<Sphere>(ColData(), 1), 3, 0, 0),
+    arena.create<Sphere>(ColData(), 1)
+  });
+  root = arena.create<RootObject>(arena.create<Union>(std::vector<BaseObject*>{obj1, obj2}));
+  OptimizerReport report = root->optimize(arena);
+
+  CUSTOM_ASSERT(report.flattened_combinations == 1);
+  CUSTOM_ASSERT(report.collapsed_combinations == 1);
+  CUSTOM_ASSERT(report.removed_transformations == 1);
+  CUSTOM_ASSERT(report.removed_subtrees == 1);
+
+  r1 = Ray(Eigen::Vector4d(-5, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(-1, 0, 0, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT(not root->included(Eigen::Vector4d(3, 0, 0, 1)));
+
+
+  // convex polyhedron
+  obj1 = Transformation::Translation(arena, Transformation::Scaling(arena, Composites::Cube(arena, ColData(), 1), 2, 2, 2), 1, 0, 0);
+  obj2 = obj1->fold_transformations(arena);
+  ConvexPolyhedron* poly = dynamic_cast<ConvexPolyhedron*>(obj2);
+  CUSTOM_ASSERT(poly != nullptr and poly->faces() == 6);
+  CUSTOM_ASSERT((poly->bounds().min() - Eigen::Vector3d(0, -1, -1)).norm() < EPSILON);
+
+  root = arena.create<RootObject>(obj2);
+
+  r1 = Ray(Eigen::Vector4d(-5, 0.5, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(0, 0.5, 0, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT((p.normal - Eigen::Vector4d(-1, 0, 0, 0)).norm() < EPSILON);
+  CUSTOM_ASSERT(not p.inside);
+
+  r1 = Ray(Eigen::Vector4d(1, 0, 0, 1), Eigen::Vector4d(0, 1, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(1, 1, 0, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT(p.inside);
+  CUSTOM_ASSERT(root->included(Eigen::Vector4d(1.5, 0.5, 0.5, 1)));
+  CUSTOM_ASSERT(not root->included(Eigen::Vector4d(2.5, 0, 0, 1)));
+
+
+  // signed distance field
+  SdfProgram program;
+  program.sphere(Eigen::Vector3d(0, 0, 0), 1);
+  program.box(Eigen::Vector3d(1, 0, 0), Eigen::Vector3d(1, 1, 1));
+  program.combine(SdfOpcode::SUBTRACTION);
+
+  obj1 = Transformation::Scaling(arena, arena.create<DistanceField>(ColData(), 1, program), 2, 2, 2);
+  root = arena.create<RootObject>(arena.create<Union>(std::vector<BaseObject*>{obj1}));
+  root->optimize(arena);
+  root->fold_transformations(arena);
+
+  r1 = Ray(Eigen::Vector4d(-5, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(-2, 0, 0, 1)).norm() < 10 * SDF_HIT_EPSILON);
+  CUSTOM_ASSERT(abs(p.distance - 3) < 10 * SDF_HIT_EPSILON);
+  CUSTOM_ASSERT((p.normal - Eigen::Vector4d(-1, 0, 0, 0)).norm() < 0.01);
+
+  r1 = Ray(Eigen::Vector4d(-1, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(0, 0, 0, 1)).norm() < 10 * SDF_HIT_EPSILON);
+  CUSTOM_ASSERT(p.inside);
+  CUSTOM_ASSERT(root->included(Eigen::Vector4d(-1, 0, 0, 1)));
+  CUSTOM_ASSERT(not root->included(Eigen::Vector4d(1, 0, 0, 1)));
+
+  SdfProgram ball;
+  ball.sphere(Eigen::Vector3d(2, 0, 0), 1);
+
+  obj1 = arena.create<Subtraction>(std::vector<BaseObject*>{
+    Transformation::Scaling(arena, Quadric::UnitSphere(arena, ColData(), 1), 2, 2, 2),
+    arena.create<DistanceField>(ColData(), 1, ball)
+  });
+  root = arena.create<RootObject>(obj1);
+
+  r1 = Ray(Eigen::Vector4d(5, 0, 0, 1), Eigen::Vector4d(-1, 0, 0, 0), 1);
+  root->intersect(r1, &p);
+  CUSTOM_ASSERT((p.point - Eigen::Vector4d(1, 0, 0, 1)).norm() < 10 * SDF_HIT_EPSILON);
+  CUSTOM_ASSERT(root->included(Eigen::Vector4d(-1, 0, 0, 1)));
+  CUSTOM_ASSERT(not root->included(Eigen::Vector4d(1.5, 0, 0, 1)));
+
+  // occluder cache tests
+  root = arena.create<RootObject>(arena.create<Union>(std::vector<BaseObject*>{
+    Transformation::Translation(arena, arena.create<Sphere>(ColData(), 1), 3, 0, 0),
+    Transformation::Translation(arena, arena.create<Sphere>(ColData(), 1), -3, 0, 0)
+  }));
+  Ray from_right(Eigen::Vector4d(10, 0, 0, 1), Eigen::Vector4d(-1, 0, 0, 0), 1);
+  Ray from_left(Eigen::Vector4d(-10, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1);
+  Ray missing(Eigen::Vector4d(10, 5, 0, 1), Eigen::Vector4d(-1, 0, 0, 0), 1);
+
+  unsigned occluder;
+  CUSTOM_ASSERT(root->occluded(from_right, 20, occluder, 2) and occluder == 0);
+  CUSTOM_ASSERT(root->occluded(from_right, 20, occluder, 0) and occluder == 1);
+  CUSTOM_ASSERT(not root->occluded(from_right, 6, occluder, 2));
+  CUSTOM_ASSERT(root->occluded_by(from_left, 7, 1) and not root->occluded_by(from_left, 7, 0));
+
+  OccluderCache cache(1);
+  CUSTOM_ASSERT(cache.occluded(*root, from_right, 20, 0)); // searches the whole scene
+  CUSTOM_ASSERT(cache.occluded(*root, from_right, 20, 0)); // blocked by the cached sphere
+  CUSTOM_ASSERT(cache.occluded(*root, from_left, 20, 0)); // blocked by the cached sphere from behind
+  CUSTOM_ASSERT(cache.occluded(*root, from_left, 7, 0)); // the cached sphere is too far away, the other one is cached now
+  CUSTOM_ASSERT(not cache.occluded(*root, missing, 20, 0));
+  CUSTOM_ASSERT(cache.report().shadow_rays == 5 and cache.report().cached_tests == 4 and cache.report().cache_hits == 2);
+  CUSTOM_ASSERT(abs(cache.report().hit_rate() - 0.5) < EPSILON);
+  CUSTOM_ASSERT(cache.report().occluded_rays == 4 and abs(cache.report().occlusion_rate() - 0.8) < EPSILON);
+
+  // scene generator
+  GeneratorOptions generator_options;
+  generator_options.csg_depth = 2;
+  generator_options.transform_chain = 3;
+  generator_options.lights = 5;
+  nlohmann::json generated = SceneGenerator::describe(generator_options);
+
+  CUSTOM_ASSERT(generated == SceneGenerator::describe(generator_options)); // reproducible
+  CUSTOM_ASSERT(generated.at("objects").size() == 15 and generated.at("sources").size() == 5);
+  CUSTOM_ASSERT(generated.at("objects")[0].contains("translation")); // the last of rotation, scaling and translation is outermost
+
+  generator_options.seed++;
+  CUSTOM_ASSERT(generated != SceneGenerator::describe(generator_options));
+
+  Scene generated_scene = SceneGenerator::build(generator_options);
+  CUSTOM_ASSERT(generated_scene.options().mode == RenderMode::PIXEL);
+
+  // the CSG tests of the worker threads are counted, when they end
+  GeneratorOptions csg_options;
+  csg_options.csg_depth = 2;
+  csg_options.dpi = 16;
+  Scene csg_scene = SceneGenerator::build(csg_options);
+  csg_scene.generate();
+  unsigned long csg_tests = csg_scene.statistics().csg_tests;
+  RenderOptions csg_wavefront;
+  csg_wavefront.mode = RenderMode::WAVEFRONT;
+  csg_wavefront.threads = 4;
+  csg_scene.generate(csg_wavefront);
+  CUSTOM_ASSERT(csg_tests > 0 and csg_scene.statistics().csg_tests == csg_tests);
+
+  // node profiler
+  BaseObject* near = arena.create<Sphere>(ColData(), 1);
+  BaseObject* far = Transformation::Translation(arena, arena.create<Sphere>(ColData(), 1), 5, 0, 0);
+  RootObject profiled(arena.create<Union>(std::vector<BaseObject*>{near, far}));
+
+  NodeProfiler::reset();
+  profiled.intersect(Ray(Eigen::Vector4d(-10, 0, 0, 1), Eigen::Vector4d(1, 0, 0, 0), 1));
+  nlohmann::json profile = NodeProfiler::tree(profiled);
+
+  CUSTOM_ASSERT(profile["type"] == "Union" and profile["children"].size() == 2);
+  CUSTOM_ASSERT(profile["children"][1]["type"] == "Transformation" and profile["children"][1]["children"][0]["type"] == "Sphere");
+  #ifdef PROFILE_NODES
+    // the ray passes through both spheres, the union is the only node called from outside of the tree
+    CUSTOM_ASSERT(profile["intersect_calls"] == 1 and profile["points"] == 4 and profile["share"] == 1.0);
+    CUSTOM_ASSERT(profile["children"][1]["children"][0]["intersect_calls"] == 1 and profile["children"][1]["children"][0]["points"] == 2);
+    CUSTOM_ASSERT(profile["self_seconds"] <= profile["seconds"]);
+  #endif
+
+  // timeline
+  Timeline::record("ignored", "test", 0, 1);
+  Timeline::start();
+  CUSTOM_ASSERT(Timeline::size() == 0);
+
+  Scene timed_scene = SceneGenerator::build(generator_options);
+  for (unsigned k = 0; k < 2; k++) {
+    parallel_for(4 * PARALLEL_MIN_CHUNK, 4, [](unsigned begin, unsigned) {
+      TimelineSpan span("chunk", "test", "first", begin);
+    });
+  }
+  Timeline::stop();
+  Timeline::record("ignored", "test", 0, 1);
+
+  nlohmann::json timeline = Timeline::trace();
+  std::map<std::string, unsigned> phases;
+  std::set<unsigned> lanes;
+  for (const nlohmann::json& event : timeline["traceEvents"]) {
+    if (event["ph"] == "X") {
+      phases[event["name"]]++;
+      lanes.insert(event["tid"].get<unsigned>());
+      CUSTOM_ASSERT(event["dur"] >= 0 and event["ts"] >= 0);
+    }
+  }
+  CUSTOM_ASSERT(phases["parse"] == 1 and phases["build tree"] == 1 and phases["simplify"] == 1 and phases["light tree"] == 1);
+  CUSTOM_ASSERT(phases["chunk"] == 8 and phases.count("ignored") == 0);
+  // the workers of the second parallel_for reuse the lanes of the first one
+  CUSTOM_ASSERT(lanes.size() >= 2 and lanes.size() <= 4);
 
   return 0;
-}
\ No newline at end of file
+}
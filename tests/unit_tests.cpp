@@ -2,6 +2,7 @@
 #include <cassert>
 
 #include <composite.hpp>
+#include <image_comparison.hpp>
 #include <light.hpp>
 #include <objects.hpp>
 #include <ray.hpp>
@@ -78,5 +79,267 @@ int main() {
   CUSTOM_ASSERT((ip3.point - Eigen::Vector4d(1, 4, 1, 1)).norm() < EPSILON);
   CUSTOM_ASSERT((ip3.normal - Eigen::Vector4d(1, 0, 0, 0)).norm() < EPSILON);
 
+  // arena tests
+  Arena arena(1024);
+  char* c1 = arena.create<char>('a');
+  double* d1 = arena.create<double>(1.5);
+  CUSTOM_ASSERT(*c1 == 'a' and *d1 == 1.5);
+  CUSTOM_ASSERT((std::size_t) d1 % alignof(double) == 0);
+  CUSTOM_ASSERT((char*) d1 - c1 < 16); // allocated next to each other
+  CUSTOM_ASSERT(arena.block_count() == 1);
+
+  Union* u1 = arena.create<Union>(std::vector<BaseObject*>{arena.create<Sphere>(ColData(), 1)});
+  CUSTOM_ASSERT(u1->bounds().finite());
+  void* large = arena.allocate(4096);
+  CUSTOM_ASSERT(large != nullptr and arena.block_count() == 2);
+  arena.create<double>(0);
+  CUSTOM_ASSERT(arena.block_count() == 2); // the first block is still used after the large request
+
+  // quadric tests
+  Eigen::Transform<double, 3, Eigen::Projective> identity = Eigen::Transform<double, 3, Eigen::Projective>::Identity();
+  Quadric* q1 = Quadric::UnitSphere(arena, ColData(), 1);
+  CUSTOM_ASSERT(q1->included(Eigen::Vector4d(0.5, 0.5, 0, 1), identity));
+  CUSTOM_ASSERT(not q1->included(Eigen::Vector4d(1, 1, 0, 1), identity));
+
+  q1->absorb_transformation(Eigen::Transform<double, 3, Eigen::Projective>(Eigen::Translation<double, 3>(-3, 0, 0)));
+  CUSTOM_ASSERT(q1->included(Eigen::Vector4d(3.5, 0, 0, 1), identity));
+  CUSTOM_ASSERT(not q1->included(Eigen::Vector4d(0, 0, 0, 1), identity));
+
+  Quadric* q2 = Quadric::UnitCone(arena, ColData(), 1);
+  CUSTOM_ASSERT(q2->included(Eigen::Vector4d(0.5, 0, 1, 1), identity));
+  CUSTOM_ASSERT(not q2->included(Eigen::Vector4d(1.5, 0, 1, 1), identity));
+
+  // bounding box tests
+  BoundingBox bb1(Eigen::Vector3d(-1, -1, -1), Eigen::Vector3d(1, 1, 1));
+  CUSTOM_ASSERT(not bb1.empty() and bb1.finite());
+  CUSTOM_ASSERT(abs(bb1.volume() - 8) < EPSILON);
+
+  BoundingBox bb2 = bb1.transformed(Eigen::Transform<double, 3, Eigen::Projective>(Eigen::Translation<double, 3>(3, 0, 0)));
+  CUSTOM_ASSERT(bb1.intersected(bb2).empty());
+  CUSTOM_ASSERT(abs(bb1.merged(bb2).volume() - 20) < EPSILON);
+
+  BoundingBox bb3 = HalfSpace(ColData(), 1, Eigen::Vector4d(0, 1, 0, 0)).bounds();
+  CUSTOM_ASSERT(not bb3.finite() and abs(bb3.max()[1]) < EPSILON);
+  CUSTOM_ASSERT(bb3.transformed(Eigen::Transform<double, 3, Eigen::Projective>(Eigen::Translation<double, 3>(0, 2, 0))).intersected(bb2).empty() == false);
+
+  BoundingBox bb4 = Quadric(ColData(), 1, Eigen::Vector4d(0.25, 1, 1, -1).asDiagonal()).bounds();
+  CUSTOM_ASSERT((bb4.max() - Eigen::Vector3d(2, 1, 1)).norm() < EPSILON);
+
+  double t_near, t_far;
+  CUSTOM_ASSERT(bb1.clip(Ray(Eigen::Vector3d(-5, 0.5, 0), Eigen::Vector3d(1, 0, 0), 1), t_near, t_far));
+  CUSTOM_ASSERT(abs(t_near - 4) < EPSILON and abs(t_far - 6) < EPSILON);
+  CUSTOM_ASSERT(not bb1.clip(Ray(Eigen::Vector3d(-5, 1.5, 0), Eigen::Vector3d(1, 0, 0), 1), t_near, t_far));
+  CUSTOM_ASSERT(not bb1.clip(Ray(Eigen::Vector3d(5, 0, 0), Eigen::Vector3d(1, 0, 0), 1), t_near, t_far));
+
+  BoundingBox unit(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(1, 1, 1));
+  CUSTOM_ASSERT(unit.squared_distance(Eigen::Vector3d(0.5, 0.5, 0.5)) == 0);
+  CUSTOM_ASSERT(abs(unit.squared_distance(Eigen::Vector3d(3, -1, 0.5)) - 5) < EPSILON);
+
+  // signed distance field tests
+  SdfProgram sdf1;
+  sdf1.begin_translation(Eigen::Vector3d(1, 0, 0));
+  sdf1.sphere(Eigen::Vector3d(0, 0, 0), 1);
+  sdf1.box(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(0.5, 2, 0.5));
+  sdf1.combine(SdfOpcode::UNION);
+  sdf1.end_translation();
+  CUSTOM_ASSERT(sdf1.complete());
+  CUSTOM_ASSERT(abs(sdf1.evaluate(Eigen::Vector3d(3, 0, 0)) - 1) < EPSILON);
+  CUSTOM_ASSERT(abs(sdf1.evaluate(Eigen::Vector3d(1, 3, 0)) - 1) < EPSILON);
+  CUSTOM_ASSERT(abs(sdf1.evaluate(Eigen::Vector3d(1, 0, 0)) + 1) < EPSILON);
+  CUSTOM_ASSERT((sdf1.bounds().min() - Eigen::Vector3d(0, -2, -1)).norm() < EPSILON);
+  CUSTOM_ASSERT((sdf1.gradient(Eigen::Vector3d(2, 0, 0), SDF_HIT_EPSILON) - Eigen::Vector3d(1, 0, 0)).norm() < 0.01);
+
+  SdfProgram sdf2;
+  sdf2.begin_scaling(2);
+  sdf2.begin_repetition(Eigen::Vector3d(1, 1, 1), Eigen::Vector3i(1, 0, 0));
+  sdf2.sphere(Eigen::Vector3d(0, 0, 0), 0.25);
+  sdf2.end_repetition();
+  sdf2.end_scaling();
+  CUSTOM_ASSERT(abs(sdf2.evaluate(Eigen::Vector3d(2, 0, 0)) + 0.5) < EPSILON);
+  CUSTOM_ASSERT(abs(sdf2.evaluate(Eigen::Vector3d(5, 0, 0)) - 2.5) < EPSILON);
+  CUSTOM_ASSERT((sdf2.bounds().max() - Eigen::Vector3d(2.5, 0.5, 0.5)).norm() < EPSILON);
+
+  SdfProgram sdf3;
+  sdf3.sphere(Eigen::Vector3d(0, 0, 0), 1);
+  bool thrown = false;
+  try {
+    sdf3.combine(SdfOpcode::UNION);
+  }
+  catch (Cpp_Raytracing_INVALID_INPUT&) {
+    thrown = true;
+  }
+  CUSTOM_ASSERT(thrown);
+
+  // trace stack tests
+  TraceStack stack;
+  CUSTOM_ASSERT(stack.empty());
+  stack.push(TraceTask(r1, LightIntensity::white(), 0));
+  stack.push(TraceTask(r2, LightIntensity::gray(), 1));
+  CUSTOM_ASSERT(stack.size() == 2 and stack.top().depth == 1 and stack.top().stage == TraceStage::SHADE);
+  stack.top().stage = TraceStage::FINISH;
+  stack.pop();
+  CUSTOM_ASSERT(stack.size() == 1 and stack.top().depth == 0 and stack.top().stage == TraceStage::SHADE);
+  stack.pop();
+  CUSTOM_ASSERT(stack.empty());
+
+  // medium tests
+  Medium medium;
+  CUSTOM_ASSERT(medium.enter(1.5) == 1.5f);
+  CUSTOM_ASSERT(medium.enter(1.2f) == 1.2f);
+  CUSTOM_ASSERT(medium.enter(1.5) == 1.5f);
+  CUSTOM_ASSERT(medium.leave(1.2f, 1) == 1.5f); // still inside of both objects with index 1.5
+  CUSTOM_ASSERT(medium.leave(1.5, 1) == 1.5f);
+  CUSTOM_ASSERT(medium.leave(1.5, 1) == 1.0f);
+  CUSTOM_ASSERT(medium.leave(2, 1) == 1.0f); // leaving an object, that was never entered
+
+  // coherence tests
+  Eigen::Vector3d lower(0, 0, 0), upper(1, 1, 1);
+  unsigned near_key = coherence_key(Ray(0.1, 0.1, 0.1, 1, 1, 1, 1), lower, upper);
+  unsigned far_key = coherence_key(Ray(0.9, 0.9, 0.9, 1, 1, 1, 1), lower, upper);
+  unsigned back_key = coherence_key(Ray(0.1, 0.1, 0.1, -1, 1, 1, 1), lower, upper);
+  CUSTOM_ASSERT(near_key < far_key and far_key < back_key); // the direction octant is more significant than the start point
+  CUSTOM_ASSERT(coherence_key(Ray(0, 0, 0, 1, 1, 1, 1), lower, upper) == 0);
+
+  std::vector<WavefrontRay> queue, scratch;
+  queue.emplace_back(Ray(0.9, 0.9, 0.9, 1, 1, 1, 1), LightIntensity(), 0, LightIntensity(), Medium(), 0);
+  queue.emplace_back(Ray(0.1, 0.1, 0.1, -1, 1, 1, 1), LightIntensity(), 0, LightIntensity(), Medium(), 1);
+  queue.emplace_back(Ray(0, 0, 0, 1, 1, 1, 1), LightIntensity(), 0, LightIntensity(), Medium(), 2);
+  sort_coherent(queue, scratch);
+  CUSTOM_ASSERT(queue.size() == 3 and queue[0].sequence == 2 and queue[1].sequence == 0 and queue[2].sequence == 1);
+
+  // light tree tests
+  std::vector<LightSource*> lights;
+  for (unsigned k = 0; k < 7; k++) {
+    lights.push_back(arena.create<LightSource>(Eigen::Vector3d(k, 0, 0), LightIntensity(0.5, 0.5, 0.5)));
+  }
+  LightTree tree(lights);
+  CUSTOM_ASSERT(tree.size() == 7);
+
+  Eigen::Vector3d shaded(0.5, 1, 0);
+  double total = 0;
+  for (unsigned k = 0; k < 7; k++) {
+    CUSTOM_ASSERT(tree.probability(shaded, k) > 0);
+    total += tree.probability(shaded, k);
+  }
+  CUSTOM_ASSERT(abs(total - 1) < EPSILON);
+  CUSTOM_ASSERT(tree.probability(shaded, 0) > tree.probability(shaded, 6)); // near lights are more important
+
+  for (double u : {0.0, 0.3, 0.7, 0.999}) {
+    double p;
+    unsigned chosen = tree.sample(shaded, u, p);
+    CUSTOM_ASSERT(chosen < 7 and abs(p - tree.probability(shaded, chosen)) < EPSILON);
+  }
+
+  LightSample lit;
+  lit.lit = true;
+  lit.diffuse = LightIntensity(0.5, 0.2, 0);
+  LightIntensity exact_sum, weighted_sum;
+  LightSum exact, weighted;
+  exact.add(exact_sum, lit, 1);
+  exact.add(exact_sum, lit, 1);
+  exact.finish(exact_sum);
+  weighted.add(weighted_sum, lit, 2); // a single light counting twice
+  weighted.finish(weighted_sum);
+  CUSTOM_ASSERT(abs(exact_sum.at(0) - 0.75) < EPSILON and abs(exact_sum.at(1) - 0.36) < EPSILON);
+  for (unsigned k = 0; k < NUM_COL; k++) {
+    CUSTOM_ASSERT(abs(weighted_sum.at(k) - exact_sum.at(k)) < EPSILON);
+  }
+
+  // ranged light tests
+  LightSource ranged(Eigen::Vector3d(0, 0, 0), LightIntensity::white(), 2);
+  CUSTOM_ASSERT(ranged.ranged() and not lights[0]->ranged());
+  CUSTOM_ASSERT(ranged.attenuation(0) == 1 and abs(ranged.attenuation(1) - 0.5625) < EPSILON and ranged.attenuation(2) == 0);
+  CUSTOM_ASSERT(lights[0]->attenuation(1000) == 1);
+  CUSTOM_ASSERT(ranged.reaches(BoundingBox(Eigen::Vector3d(1, 1, 0), Eigen::Vector3d(3, 3, 3))));
+  CUSTOM_ASSERT(not ranged.reaches(BoundingBox(Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(3, 3, 3))));
+  CUSTOM_ASSERT(not ranged.reaches(BoundingBox()));
+
+  lights.push_back(arena.create<LightSource>(Eigen::Vector3d(20, 0, 0), LightIntensity::white(), 1));
+  LightTree ranged_tree(lights);
+  CUSTOM_ASSERT(ranged_tree.probability(shaded, 7) == 0); // out of range
+  CUSTOM_ASSERT(ranged_tree.probability(Eigen::Vector3d(20, 0.5, 0), 7) > 0.5);
+
+  LightGrid grid(lights.size(), 20, 40);
+  CUSTOM_ASSERT(grid.size() == 6 and grid.tile(17, 33) == 5 and grid.lights(5).size() == 8);
+  grid.cull(5, BoundingBox(Eigen::Vector3d(19, 0, 0), Eigen::Vector3d(21, 1, 1)), lights);
+  grid.cull(4, BoundingBox(Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(1, 1, 1)), lights);
+  CUSTOM_ASSERT(grid.lights(5).size() == 8 and grid.lights(4).size() == 7 and grid.lights(4).back() == 6);
+  CUSTOM_ASSERT(LightGrid(8).size() == 0 and LightGrid(8).lights(3).size() == 8);
+
+  // area light tests
+  LightSource* panel = LightSource::Rectangle(arena, Eigen::Vector3d(0, 0, 5), Eigen::Vector3d(2, 0, 0), Eigen::Vector3d(0, 4, 0), LightIntensity::white(), 1);
+  Eigen::Vector4d below(0, 0, 0, 1);
+  CUSTOM_ASSERT(panel->shape() == LightShape::RECTANGLE and abs(panel->extent() - sqrt(5)) < EPSILON);
+  CUSTOM_ASSERT((panel->sample_point(below, 0.5, 0.5) - Eigen::Vector4d(0, 0, 5, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT((panel->sample_point(below, 0, 1) - Eigen::Vector4d(-1, 2, 5, 1)).norm() < EPSILON);
+  CUSTOM_ASSERT(panel->reaches(BoundingBox(Eigen::Vector3d(2, 0, 5), Eigen::Vector3d(3, 1, 6)))); // reached from a corner of the panel
+
+  LightSource* bulb = LightSource::Sphere(arena, Eigen::Vector3d(0, 0, 5), 2, LightIntensity::white());
+  CUSTOM_ASSERT(bulb->shape() == LightShape::SPHERE and bulb->extent() == 2 and lights[0]->extent() == 0);
+  for (double s : {0.0, 0.4, 0.99}) {
+    Eigen::Vector4d p = bulb->sample_point(below, s, 0.3);
+    CUSTOM_ASSERT(abs(p[2] - 5) < EPSILON and (p - bulb->pos()).norm() <= 2 + EPSILON); // on the disc facing the point below
+  }
+  CUSTOM_ASSERT((lights[0]->sample_point(below, 0.3, 0.7) - lights[0]->pos()).norm() < EPSILON);
+
+  // parallel tests
+  std::vector<unsigned> visited(10000, 0);
+  parallel_for(visited.size(), 3, [&visited](unsigned begin, unsigned end) {
+    for (unsigned k = begin; k < end; k++) {
+      visited[k]++;
+    }
+  });
+  CUSTOM_ASSERT(std::count(visited.begin(), visited.end(), 1) == 10000);
+
+  // pixel traversal tests
+  for (PixelOrder order : {PixelOrder::SCANLINE, PixelOrder::MORTON, PixelOrder::HILBERT}) {
+    for (unsigned tile : {0u, 4u, 5u}) {
+      std::vector<unsigned> pixels = pixel_traversal(10, 13, order, tile);
+      std::vector<unsigned> sorted = pixels;
+      std::sort(sorted.begin(), sorted.end());
+      CUSTOM_ASSERT(pixels.size() == 130 and std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end() and sorted.back() == 129);
+    }
+  }
+  std::vector<unsigned> scanline = pixel_traversal(10, 13, PixelOrder::SCANLINE, 0);
+  for (unsigned s = 0; s < scanline.size(); s++) {
+    CUSTOM_ASSERT(scanline[s] == s);
+  }
+
+  std::vector<unsigned> morton = pixel_traversal(8, 8, PixelOrder::MORTON, 4);
+  CUSTOM_ASSERT(morton[0] == 0 and morton[1] == 1 and morton[2] == 8 and morton[3] == 9 and morton[4] == 2);
+  CUSTOM_ASSERT(*std::max_element(morton.begin(), morton.begin() + 16) == 3 * 8 + 3 and morton[16] == 4);
+
+  // every step of the Hilbert curve goes to a neighboring pixel
+  std::vector<unsigned> hilbert = pixel_traversal(16, 16, PixelOrder::HILBERT, 0);
+  for (unsigned s = 1; s < hilbert.size(); s++) {
+    int di = (int) (hilbert[s] / 16) - (int) (hilbert[s - 1] / 16);
+    int dj = (int) (hilbert[s] % 16) - (int) (hilbert[s - 1] % 16);
+    CUSTOM_ASSERT(std::abs(di) + std::abs(dj) == 1);
+  }
+
+  // image comparison tests
+  cv::Mat_<cv::Vec3b> gray(16, 16, cv::Vec3b(100, 100, 100));
+  cv::Mat_<cv::Vec3b> spot = gray.clone();
+  spot(3, 5) = cv::Vec3b(120, 100, 100);
+
+  ImageComparison same = ImageComparison::compare(gray, gray.clone());
+  CUSTOM_ASSERT(same.max_error == 0 and same.changed_pixels == 0 and std::isinf(same.psnr) and abs(same.ssim - 1) < EPSILON);
+  CUSTOM_ASSERT(same.within(ImageTolerance()) and same.json()["psnr"].is_null());
+
+  ImageComparison spotted = ImageComparison::compare(spot, gray);
+  CUSTOM_ASSERT(spotted.max_error == 20 and abs(spotted.changed_pixels - 1.0 / 256) < EPSILON);
+  CUSTOM_ASSERT(abs(spotted.psnr - 10 * log10(255.0 * 255.0 * 256 * 3 / 400)) < EPSILON and spotted.ssim < 1);
+  CUSTOM_ASSERT(not spotted.within(ImageTolerance()) and ImageComparison::compare(spot, gray, 20).changed_pixels == 0);
+  CUSTOM_ASSERT(ImageComparison::difference(spot, gray)(3, 5)[0] == 20 * REGRESSION_DIFF_GAIN and ImageComparison::difference(spot, gray)(0, 0)[0] == 0);
+
+  bool mismatched = false;
+  try {
+    ImageComparison::compare(gray, cv::Mat_<cv::Vec3b>(16, 8, cv::Vec3b(100, 100, 100)));
+  }
+  catch (Cpp_Raytracing_INVALID_INPUT&) {
+    mismatched = true;
+  }
+  CUSTOM_ASSERT(mismatched);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <scene.hpp>
+#include "defines.h"
+
+/**
+ * Estimates the time, rays and memory needed to render a scene, by tracing a sparse sample of its pixels.
+ *
+ * usage: render_estimate [--fraction f] [--output estimate.json] scene.json
+ *
+ * The estimate is printed, and written as JSON into the output file, if one is given.
+ */
+
+int main(int argc, char** argv) {
+  float fraction = ESTIMATE_FRACTION;
+  std::string output_path;
+  std::string scene_path;
+
+  for (int k = 1; k < argc; k++) {
+    std::string arg = argv[k];
+
+    if ((arg == "--fraction" or arg == "--output") and k + 1 == argc) {
+      std::cerr << "The option " << arg << " needs a value." << std::endl;
+      return 1;
+    }
+
+    if (arg == "--fraction") {
+      fraction = std::stof(argv[++k]);
+    }
+    else if (arg == "--output") {
+      output_path = argv[++k];
+    }
+    else if (arg.rfind("--", 0) == 0 or not scene_path.empty()) {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+    else {
+      scene_path = arg;
+    }
+  }
+
+  if (scene_path.empty() or not (fraction > 0 and fraction <= 1)) {
+    std::cerr << "usage: render_estimate [--fraction f] [--output estimate.json] scene.json, with 0 < f <= 1" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(scene_path);
+  if (not input.is_open()) {
+    std::cerr << "The scene " << scene_path << " could not be opened." << std::endl;
+    return 1;
+  }
+
+  Scene scene = Scene::read_parameters(input);
+
+  // the progress bar of the sampled pixels is not printed
+  std::ostringstream sink;
+  std::streambuf* console = std::cout.rdbuf(sink.rdbuf());
+  RenderEstimate estimate = scene.estimate(scene.options(), fraction);
+  std::cout.rdbuf(console);
+
+  std::cout << estimate << std::endl;
+
+  if (not output_path.empty()) {
+    std::ofstream(output_path) << estimate.json().dump(2) << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <scene_generator.hpp>
+#include "defines.h"
+
+/**
+ * Writes a random scene description, e.g. to measure how rendering scales with the size of a scene.
+ *
+ * usage: scene_generator [--spheres n] [--cylinders n] [--cubes n] [--triforces n] [--csg n] [--transforms n]
+ *                        [--lights n] [--recursion n] [--dpi n] [--seed n] [--output scene.json]
+ *
+ * Without an output file, the scene is printed. Equal arguments always give the same scene.
+ */
+
+int main(int argc, char** argv) {
+  GeneratorOptions options;
+  std::string output_path;
+
+  std::map<std::string, unsigned*> counts = {
+    {"--spheres", &options.spheres},        {"--cylinders", &options.cylinders},
+    {"--cubes", &options.cubes},            {"--triforces", &options.triforces},
+    {"--csg", &options.csg_depth},          {"--transforms", &options.transform_chain},
+    {"--lights", &options.lights},          {"--recursion", &options.recursion},
+    {"--dpi", &options.dpi},                {"--seed", &options.seed}
+  };
+
+  for (int k = 1; k + 1 < argc; k += 2) {
+    std::string arg = argv[k];
+
+    if (arg == "--output") {
+      output_path = argv[k + 1];
+    }
+    else if (counts.count(arg) > 0) {
+      *counts.at(arg) = std::stoul(argv[k + 1]);
+    }
+    else {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  if (argc % 2 == 0) {
+    std::cerr << "The option " << argv[argc - 1] << " needs a value." << std::endl;
+    return 1;
+  }
+
+  std::string description = SceneGenerator::describe(options).dump(2);
+
+  if (output_path.empty()) {
+    std::cout << description << std::endl;
+  }
+  else {
+    std::ofstream(output_path) << description << std::endl;
+  }
+
+  return 0;
+}